@@ -51,8 +51,14 @@ public:
     int        apply(S1* in, int inCount, S2* out, int outCount);
     int        neededOutCount(int inCount);
     int        coefsPerPhase() { return _coefsPerPhase; }
+
+    // optional dot product kernel for the inner filter loop: (x, h, count)
+    typedef C (*DotFunc)(const S1*, const C*, size_t);
+    void       setDot(DotFunc dot) { _dot = dot; }
     
 private:
+    DotFunc    _dot = nullptr;
+
     int        _upRate;
     int        _downRate;
 
@@ -164,8 +170,12 @@ int Resampler<S1, S2, C>::apply(S1* in, int inCount,
             }
             xPtr += offset;
         }
-        while (xPtr <= x) {
-            acc += *xPtr++ * *h++;
+        if (_dot) {
+            acc += _dot(xPtr, h, x - xPtr + 1);
+        } else {
+            while (xPtr <= x) {
+                acc += *xPtr++ * *h++;
+            }
         }
         *y++ = acc;
         _t += _downRate;
@@ -242,10 +252,11 @@ the original version of this function.
 template<class s1, class S1>
 void upfirdn2(int upRate, int downRate, 
              const S1& input, int inLength, vector<s1>& filter, int filterLength, 
-             vector<s1> &results)
+             vector<s1> &results, typename Resampler<s1, s1, s1>::DotFunc dot = nullptr)
 {
     // Create the Resampler
     Resampler<s1, s1, s1> theResampler(upRate, downRate, &filter[0], filterLength);
+    theResampler.setDot(dot);
 
     // pad input by length of one polyphase of filter to flush all values out
     int padding = theResampler.coefsPerPhase() - 1;
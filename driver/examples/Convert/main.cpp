@@ -0,0 +1,169 @@
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include "timeswipe_convert.hpp"
+
+void usage(const char* name)
+{
+    std::cerr << "Usage: '" << name << " --input <inname> --output <outname> [--input-format <format>] [--output-format <format>]"
+              << " [--input-rate <rate>] [--output-rate <rate>] [--threads <num>] [--chunk <samples>]"
+              << " [--scale <sensor> <gain> <offset>]... [--linear <sensor> <offset> <mfactor>]... [--serial] [--verify]'" << std::endl;
+    std::cerr << "possible values of <format>: tsv f32 raw16 (input only). default is tsv" << std::endl;
+    std::cerr << "default for <rate> is 48000, <outname> gets <input-rate> samples per second unless --output-rate given" << std::endl;
+    std::cerr << "default for <num> is the number of CPU cores" << std::endl;
+    std::cerr << "--scale: value * gain + offset of the sensor 0..3, --linear: calibration of raw16 ADC codes" << std::endl;
+    std::cerr << "--serial: single-threaded pass, --verify: compare the output with the single-threaded pass" << std::endl;
+}
+
+// compares the files, returns the offset of the first difference or -1 if they are identical
+long long compareFiles(const std::string& a, const std::string& b)
+{
+    std::ifstream fa(a, std::ios::binary);
+    std::ifstream fb(b, std::ios::binary);
+    std::vector<char> ba(1 << 20), bb(1 << 20);
+    long long offset = 0;
+    while (true) {
+        fa.read(ba.data(), ba.size());
+        fb.read(bb.data(), bb.size());
+        if (fa.gcount() != fb.gcount() || memcmp(ba.data(), bb.data(), fa.gcount())) {
+            size_t i = 0;
+            while (i < size_t(std::min(fa.gcount(), fb.gcount())) && ba[i] == bb[i]) i++;
+            return offset + i;
+        }
+        if (!fa.gcount()) return -1;
+        offset += fa.gcount();
+    }
+}
+
+uint64_t convert(TimeSwipeConverter& converter, const std::string& inname, TimeSwipeConverter::Format informat,
+                 const std::string& outname, TimeSwipeConverter::Format outformat, std::string& error)
+{
+    std::ifstream in(inname, std::ios::binary);
+    if (!in) {
+        error = "open input file \"" + inname + "\" failed";
+        return 0;
+    }
+    std::ofstream out(outname, std::ios::binary);
+    if (!out) {
+        error = "open output file \"" + outname + "\" failed";
+        return 0;
+    }
+    return converter.Convert(in, informat, out, outformat, error);
+}
+
+int main(int argc, char *argv[])
+{
+    std::string inname;
+    std::string outname;
+    auto informat = TimeSwipeConverter::Format::TSV;
+    auto outformat = TimeSwipeConverter::Format::TSV;
+    int inrate = 48000;
+    int outrate = 0;
+    bool serial = false;
+    bool verify = false;
+    TimeSwipeConverter converter;
+
+    for (int i = 1; i < argc; i++) {
+        auto args = [&](int num) {
+            if (i + num >= argc) {
+                usage(argv[0]);
+                exit(1);
+            }
+        };
+        if (!strcmp(argv[i],"--input")) {
+            args(1);
+            inname = argv[++i];
+        } else if (!strcmp(argv[i],"--output")) {
+            args(1);
+            outname = argv[++i];
+        } else if (!strcmp(argv[i],"--input-format") || !strcmp(argv[i],"--output-format")) {
+            args(1);
+            auto& format = !strcmp(argv[i],"--input-format") ? informat : outformat;
+            if (!TimeSwipeConverter::ParseFormat(argv[++i], format)) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i],"--input-rate")) {
+            args(1);
+            inrate = std::stoi(argv[++i]);
+        } else if (!strcmp(argv[i],"--output-rate")) {
+            args(1);
+            outrate = std::stoi(argv[++i]);
+        } else if (!strcmp(argv[i],"--threads")) {
+            args(1);
+            converter.SetThreads(std::stoi(argv[++i]));
+        } else if (!strcmp(argv[i],"--chunk")) {
+            args(1);
+            converter.SetChunkSize(std::stoul(argv[++i]));
+        } else if (!strcmp(argv[i],"--scale")) {
+            args(3);
+            if (!converter.SetSensorScale(std::stoi(argv[i+1]), std::stof(argv[i+2]), std::stof(argv[i+3]))) {
+                usage(argv[0]);
+                return 1;
+            }
+            i += 3;
+        } else if (!strcmp(argv[i],"--linear")) {
+            args(3);
+            if (!converter.SetSensorLinear(std::stoi(argv[i+1]), std::stoi(argv[i+2]), std::stof(argv[i+3]))) {
+                usage(argv[0]);
+                return 1;
+            }
+            i += 3;
+        } else if (!strcmp(argv[i],"--serial")) {
+            serial = true;
+        } else if (!strcmp(argv[i],"--verify")) {
+            verify = true;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (inname.empty() || outname.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (!converter.SetSampleRates(inrate, outrate ? outrate : inrate)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::string error;
+    converter.SetSerial(serial);
+    auto start = std::chrono::steady_clock::now();
+    auto samples = convert(converter, inname, informat, outname, outformat, error);
+    if (!error.empty()) {
+        std::cerr << "convert failed: " << error << std::endl;
+        return 2;
+    }
+    std::chrono::duration<float> diff = std::chrono::steady_clock::now() - start;
+    std::cout << "time: " << diff.count() << "s samples: " << samples << " samples/sec: " << samples / diff.count() << "\n";
+
+    if (verify && !serial) {
+        const auto refname = outname + ".serial";
+        converter.SetSerial(true);
+        start = std::chrono::steady_clock::now();
+        convert(converter, inname, informat, refname, outformat, error);
+        if (!error.empty()) {
+            std::cerr << "single-threaded convert failed: " << error << std::endl;
+            return 2;
+        }
+        diff = std::chrono::steady_clock::now() - start;
+        std::cout << "single-threaded time: " << diff.count() << "s" << "\n";
+
+        auto offset = compareFiles(outname, refname);
+        if (offset >= 0) {
+            std::cerr << "verify failed: the output differs from \"" << refname << "\" at byte " << offset << std::endl;
+            return 3;
+        }
+        std::remove(refname.c_str());
+        std::cout << "verify: the output is identical to the single-threaded one" << std::endl;
+    }
+
+    return 0;
+}
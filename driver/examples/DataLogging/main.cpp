@@ -12,6 +12,7 @@
 #include <thread>
 #include <chrono>
 #include "timeswipe.hpp"
+#include "timeswipe_pyramid.hpp"
 
 // #include <chrono>
 
@@ -23,13 +24,14 @@ void usage(const char* name)
     std::cerr << "Usage: 'sudo " << name << " [--config <configname>] [--input <input_type>] [--output <outname>] [-- time <runtime>] [--log-resample] [--trace-spi]'" << std::endl;
     std::cerr << "default for <configname> is ./config.json" << std::endl;
     std::cerr << "possible values: PRIMARY NORM DIGITAL. default for <input_type> is the first one from <configname>" << std::endl;
-    std::cerr << "if --output given then <outname> created in TSV format" << std::endl;
+    std::cerr << "if --output given then <outname> created in TSV format and <outname>.pyr created with its min/max/mean overview" << std::endl;
 }
 
 int main(int argc, char *argv[])
 {
     nlohmann::json config;
     std::ofstream data_log;
+    TimeSwipePyramidWriter pyramid;
     bool dump = false;
     std::string configname = "config.json";
     std::string dumpname;
@@ -129,6 +131,7 @@ int main(int argc, char *argv[])
     std::signal(SIGTERM, signal_handler);
     shutdown_handler = [&](int signal) {
         tswipe.Stop();
+        pyramid.Close();
         exit(1);
     };
 
@@ -170,14 +173,24 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    tswipe.SetSampleRate(24000);
-    tswipe.SetBurstSize(24000);
+    static const int sample_rate = 24000;
+    tswipe.SetSampleRate(sample_rate);
+    tswipe.SetBurstSize(sample_rate);
+
+    if (dump) {
+        std::string err;
+        if (!pyramid.Open(dumpname + ".pyr", sample_rate, 8, err)) {
+            std::cerr << err << std::endl;
+            return 1;
+        }
+    }
 
     // Board Start
 
     int counter = 0;
     ret = tswipe.Start([&](auto&& records, uint64_t errors) {
         counter += records.DataSize();
+        if (dump) pyramid.Append(records);
             for (size_t i = 0; i < records.DataSize(); i++) {
                 if (i == 0) {
                     for (size_t j = 0; j < records.SensorsSize(); j++) {
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include "timeswipe.hpp"
+
+// Runs the control protocol end-to-end against the driver built with the in-process loopback board
+// and reports the command latency. Returns non-zero if any round trip fails.
+
+static std::string strip(std::string str) {
+    if (!str.empty() && str.back() == '\n') str.pop_back();
+    return str;
+}
+
+struct Latency {
+    std::vector<double> us;
+
+    template <class F>
+    bool measure(F&& f) {
+        auto start = std::chrono::steady_clock::now();
+        bool ok = f();
+        us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        return ok;
+    }
+
+    void print(const char* name) {
+        if (us.empty()) return;
+        std::sort(us.begin(), us.end());
+        double sum = 0;
+        for (auto v: us) sum += v;
+        std::cout << name << ": n=" << us.size()
+                  << " min=" << us.front() << "us"
+                  << " avg=" << sum / us.size() << "us"
+                  << " p99=" << us[us.size() * 99 / 100] << "us"
+                  << " max=" << us.back() << "us" << std::endl;
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    int iterations = 1000;
+    if (argc > 2 && !strcmp(argv[1], "--iterations")) iterations = atoi(argv[2]);
+
+    TimeSwipe tswipe;
+    std::string error;
+    int failures = 0;
+
+    Latency set_lat, get_lat, pwm_lat;
+    for (int i = 0; i < iterations; i++) {
+        const int gain = 1 + i % 4;
+        const std::string set = "{\"Gain\":" + std::to_string(gain) + "}";
+        if (!set_lat.measure([&]{ return strip(tswipe.SetSettings(set, error)) == set && error.empty(); })) ++failures;
+        if (!get_lat.measure([&]{ return strip(tswipe.GetSettings("[\"Gain\"]", error)) == set && error.empty(); })) ++failures;
+
+        uint32_t freq = 1 + i, high, low, repeats;
+        float duty;
+        bool active;
+        if (!pwm_lat.measure([&]{
+                return tswipe.StartPWM(0, freq, 4000, 100, 0, 0.5) &&
+                       tswipe.GetPWM(0, active, freq, high, low, repeats, duty) && active && freq == uint32_t(1 + i) &&
+                       tswipe.StopPWM(0);
+            })) ++failures;
+    }
+    set_lat.print("js< settings");
+    get_lat.print("js> settings");
+    pwm_lat.print("PWM start/get/stop");
+
+    // events: every mode change must come back as an event
+    // (the gain events of the loop above overflow the board event queue, they are reported as lost)
+    std::atomic_int mode_events = 0;
+    tswipe.onEvent([&](TimeSwipeEvent&& event) {
+        if (event.is<TimeSwipeEvent::Mode>()) ++mode_events;
+    });
+    tswipe.Start([](SensorsData, uint64_t) {});
+    const int modes = 16;
+    for (int i = 0; i < modes; i++) tswipe.SetSettings("{\"Mode\":" + std::to_string(i % 3) + "}", error);
+    for (int i = 0; i < 50 && mode_events < modes; i++) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    tswipe.Stop();
+
+    std::cout << "events: " << mode_events << "/" << modes << " lost: " << tswipe.EventsLost() << std::endl;
+    if (mode_events != modes) ++failures;
+
+    std::cout << "failures: " << failures << std::endl;
+    return failures ? 1 : 0;
+}
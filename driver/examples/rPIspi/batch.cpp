@@ -0,0 +1,247 @@
+/*
+This Source Code Form is subject to the terms of the GNU General Public License v3.0.
+If a copy of the GPL was not distributed with this
+file, You can obtain one at https://www.gnu.org/licenses/gpl-3.0.html
+Copyright (c) 2019-2020 Panda Team
+*/
+
+#include "batch.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+std::string trim(const std::string &str)
+{
+    const auto begin=str.find_first_not_of(" \t\r");
+    if(begin==std::string::npos)
+        return std::string();
+    return str.substr(begin, str.find_last_not_of(" \t\r")-begin+1);
+}
+
+struct Distribution
+{
+    double min=0, avg=0, p50=0, p90=0, p99=0, max=0;
+
+    explicit Distribution(std::vector<double> us)
+    {
+        if(us.empty())
+            return;
+        std::sort(us.begin(), us.end());
+        auto at=[&](double q){ return us[size_t(q*(us.size()-1)+0.5)]; };
+        double sum=0;
+        for(auto v : us) sum+=v;
+        min=us.front(); avg=sum/us.size(); p50=at(0.5); p90=at(0.9); p99=at(0.99); max=us.back();
+    }
+};
+
+}
+
+bool CSPIBatch::load(std::istream &in, std::string &error)
+{
+    m_Steps.clear();
+    m_Stats.clear();
+
+    //the open loops, the script itself at the bottom
+    std::vector<std::vector<Step>*> stack{&m_Steps};
+    std::string str;
+    for(unsigned line=1; std::getline(in, str); line++)
+    {
+        str=trim(str);
+        if(str.empty() || '#'==str[0])
+            continue;
+
+        auto fail=[&](const std::string &what){
+            error="line "+std::to_string(line)+": "+what+": \""+str+"\"";
+            return false;
+        };
+        if('@'==str[0])
+        {
+            std::istringstream is(str.substr(1));
+            std::string directive;
+            long long arg=-1;
+            is>>directive;
+            if("end"==directive)
+            {
+                if(stack.size()==1)
+                    return fail("@end without @repeat");
+                stack.pop_back();
+                continue;
+            }
+            if(!(is>>arg) || arg<0)
+                return fail("wrong directive");
+            if("repeat"==directive)
+            {
+                stack.back()->push_back(Step{Step::Loop, unsigned(arg)});
+                stack.push_back(&stack.back()->back().body);
+            }
+            else if("sleep"==directive)
+            {
+                stack.back()->push_back(Step{Step::Sleep, unsigned(arg)});
+            }
+            else
+            {
+                return fail("unknown directive");
+            }
+            continue;
+        }
+
+        Step step{Step::Command};
+        step.stats=m_Stats.size();
+        stack.back()->push_back(step);
+        Stats stats;
+        stats.line=line;
+        stats.cmd=str;
+        m_Stats.push_back(stats);
+    }
+    if(stack.size()!=1)
+    {
+        error="@repeat without @end";
+        return false;
+    }
+    if(m_Stats.empty())
+    {
+        error="no commands";
+        return false;
+    }
+    return true;
+}
+
+bool CSPIBatch::exec(const std::vector<Step> &steps, const Transaction &transact, bool echo)
+{
+    bool ok=true;
+    std::string answer;
+    for(const auto &step : steps)
+    {
+        switch(step.type)
+        {
+            case Step::Loop:
+                for(unsigned i=0; i<step.count; i++)
+                    ok=exec(step.body, transact, echo) && ok;
+                break;
+
+            case Step::Sleep:
+                std::this_thread::sleep_for(std::chrono::milliseconds(step.count));
+                break;
+
+            case Step::Command:
+            {
+                auto &stats=m_Stats[step.stats];
+                answer.clear();
+                const auto start=std::chrono::steady_clock::now();
+                const bool received=transact(stats.cmd+"\n", answer);
+                stats.us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now()-start).count());
+
+                if(!received)
+                {
+                    stats.failed++;
+                    ok=false;
+                }
+                else
+                {
+                    if(!answer.empty() && '!'==answer[0])
+                    {
+                        stats.errors++;
+                        ok=false;
+                    }
+                    const size_t n=answer.size();
+                    stats.bytes_min=stats.bytes_sum ? std::min(stats.bytes_min, n) : n;
+                    stats.bytes_max=std::max(stats.bytes_max, n);
+                    stats.bytes_sum+=n;
+                }
+                if(echo)
+                {
+                    // the answer ends with its own line feed
+                    std::string shown=received ? answer : std::string("!no_answer!");
+                    while(!shown.empty() && (shown.back()=='\n' || shown.back()=='\r'))
+                        shown.pop_back();
+                    std::cout<<stats.cmd<<" -> "<<shown<<std::endl;
+                }
+                break;
+            }
+        }
+    }
+    return ok;
+}
+
+bool CSPIBatch::run(const Transaction &transact, unsigned repeat, bool echo)
+{
+    for(auto &stats : m_Stats)
+    {
+        Stats fresh;
+        fresh.line=stats.line;
+        fresh.cmd=std::move(stats.cmd);
+        stats=std::move(fresh);
+    }
+    bool ok=true;
+    const auto start=std::chrono::steady_clock::now();
+    for(unsigned i=0; i<repeat; i++)
+        ok=exec(m_Steps, transact, echo) && ok;
+    m_TotalSeconds=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    return ok;
+}
+
+void CSPIBatch::report(std::ostream &out, bool json) const
+{
+    std::vector<double> all;
+    unsigned failed=0, errors=0;
+    for(const auto &stats : m_Stats)
+    {
+        all.insert(all.end(), stats.us.begin(), stats.us.end());
+        failed+=stats.failed;
+        errors+=stats.errors;
+    }
+
+    if(json)
+    {
+        auto latency=[](const std::vector<double> &us){
+            Distribution d(us);
+            return nlohmann::json{{"min", d.min}, {"avg", d.avg}, {"p50", d.p50}, {"p90", d.p90}, {"p99", d.p99}, {"max", d.max}};
+        };
+        nlohmann::json commands=nlohmann::json::array();
+        for(const auto &stats : m_Stats)
+        {
+            const size_t answered=stats.us.size()-stats.failed;
+            commands.push_back({
+                {"line", stats.line},
+                {"command", stats.cmd},
+                {"count", stats.us.size()},
+                {"failed", stats.failed},
+                {"errors", stats.errors},
+                {"latency_us", latency(stats.us)},
+                {"answer_bytes", {{"min", stats.bytes_min}, {"avg", answered ? double(stats.bytes_sum)/answered : 0.0}, {"max", stats.bytes_max}}}
+            });
+        }
+        nlohmann::json res{
+            {"commands", commands},
+            {"total", {{"count", all.size()}, {"failed", failed}, {"errors", errors}, {"seconds", m_TotalSeconds},
+                       {"commands_per_second", m_TotalSeconds>0 ? all.size()/m_TotalSeconds : 0.0}, {"latency_us", latency(all)}}}
+        };
+        out<<res.dump(2)<<std::endl;
+        return;
+    }
+
+    out<<std::left<<std::setw(6)<<"line"<<std::setw(32)<<"command"<<std::right
+       <<std::setw(8)<<"count"<<std::setw(8)<<"failed"<<std::setw(8)<<"errors"
+       <<std::setw(10)<<"min_us"<<std::setw(10)<<"p50_us"<<std::setw(10)<<"p99_us"<<std::setw(10)<<"max_us"
+       <<std::setw(10)<<"bytes"<<std::endl;
+    out<<std::fixed<<std::setprecision(1);
+    for(const auto &stats : m_Stats)
+    {
+        Distribution d(stats.us);
+        const size_t answered=stats.us.size()-stats.failed;
+        std::string cmd=stats.cmd.size()>30 ? stats.cmd.substr(0, 27)+"..." : stats.cmd;
+        out<<std::left<<std::setw(6)<<stats.line<<std::setw(32)<<cmd<<std::right
+           <<std::setw(8)<<stats.us.size()<<std::setw(8)<<stats.failed<<std::setw(8)<<stats.errors
+           <<std::setw(10)<<d.min<<std::setw(10)<<d.p50<<std::setw(10)<<d.p99<<std::setw(10)<<d.max
+           <<std::setw(10)<<(answered ? double(stats.bytes_sum)/answered : 0.0)<<std::endl;
+    }
+    Distribution d(all);
+    out<<"total: "<<all.size()<<" commands in "<<std::setprecision(3)<<m_TotalSeconds<<std::setprecision(1)<<"s, failed: "<<failed<<" errors: "<<errors
+       <<" p50: "<<d.p50<<"us p99: "<<d.p99<<"us max: "<<d.max<<"us"<<std::endl;
+}
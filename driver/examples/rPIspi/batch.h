@@ -0,0 +1,84 @@
+/*
+This Source Code Form is subject to the terms of the GNU General Public License v3.0.
+If a copy of the GPL was not distributed with this
+file, You can obtain one at https://www.gnu.org/licenses/gpl-3.0.html
+Copyright (c) 2019-2020 Panda Team
+*/
+
+#ifndef SPIBATCH_H
+#define SPIBATCH_H
+
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/*!
+ * \brief Replays a command script through the SPI console and times every command
+ * \details Script lines are sent as they are, the same as typed in the interactive mode:
+ *  "# ..." is a comment, "@repeat <n>" ... "@end" repeats the lines between (loops may be nested),
+ *  "@sleep <ms>" pauses the replay
+ */
+class CSPIBatch
+{
+public:
+    /*!
+     * \brief Sends a command and receives the answer, returns false if no answer
+     */
+    using Transaction = std::function<bool(const std::string &cmd, std::string &answer)>;
+
+    /*!
+     * \brief Loads the script
+     * \param in script stream
+     * \param error the line and the reason of the failure
+     * \return true=successful, false=failure
+     */
+    bool load(std::istream &in, std::string &error);
+
+    /*!
+     * \brief Replays the script
+     * \param transact the SPI transaction
+     * \param repeat number of the whole script replays
+     * \param echo print every answer to stdout
+     * \return false if any command got no answer or an error answer ("!...")
+     */
+    bool run(const Transaction &transact, unsigned repeat, bool echo);
+
+    /*!
+     * \brief Prints the per-command round-trip latency and answer size statistics
+     * \param json print JSON instead of the text table
+     */
+    void report(std::ostream &out, bool json) const;
+
+protected:
+    struct Stats
+    {
+        unsigned line=0;
+        std::string cmd;
+        std::vector<double> us;
+        //no answer
+        unsigned failed=0;
+        //"!..." answers
+        unsigned errors=0;
+        size_t bytes_min=0;
+        size_t bytes_max=0;
+        size_t bytes_sum=0;
+    };
+
+    struct Step
+    {
+        enum Type {Command, Sleep, Loop} type;
+        unsigned count=0;
+        //the command statistics index
+        size_t stats=0;
+        std::vector<Step> body;
+    };
+
+    bool exec(const std::vector<Step> &steps, const Transaction &transact, bool echo);
+
+    std::vector<Step>  m_Steps;
+    std::vector<Stats> m_Stats;
+    double             m_TotalSeconds=0;
+};
+
+#endif // SPIBATCH_H
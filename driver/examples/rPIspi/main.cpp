@@ -6,11 +6,18 @@ Copyright (c) 2019 Panda Team
 */
 
 #include <iostream>
+#include <fstream>
+#include <cstring>
 
 using namespace std;
 
 #include "console.h"
+#include "batch.h"
+#ifdef TIMESWIPE_LOOPBACK
+#include "loopback_spi.h"
+#else
 #include "bcmspi.h"
+#endif
 
 void Wait ( unsigned long time_mS );
 int main ( int argc, char *argv[] )
@@ -18,6 +25,10 @@ int main ( int argc, char *argv[] )
 	int nSPI = 0;
 	bool bMasterMode = true;
 	bool interactive = true;
+	const char * script = nullptr;
+	unsigned repeat = 1;
+	bool json = false;
+	bool echo = false;
 	if ( argc > 1 )
 	{
 		nSPI = atoi ( argv[1] );
@@ -30,8 +41,25 @@ int main ( int argc, char *argv[] )
 	else
 	{
 		std::cout << "Usage: sudo " << argv[0] << " <SPI> <optional commands for non-interactive mode>" << std::endl;
+		std::cout << "       sudo " << argv[0] << " <SPI> --script <file> [--repeat <n>] [--json] [--echo]" << std::endl;
+		std::cout << "batch mode: replays the script (- for stdin) <n> times and prints the round-trip latency and answer size of every command" << std::endl;
 		return 0;
 	}
+	if ( argc > 2 && !strcmp ( argv[2], "--script" ) )
+	{
+		for ( int i = 2; i < argc; i++ )
+		{
+			if ( !strcmp ( argv[i], "--script" ) && i + 1 < argc ) script = argv[++i];
+			else if ( !strcmp ( argv[i], "--repeat" ) && i + 1 < argc ) repeat = atoi ( argv[++i] );
+			else if ( !strcmp ( argv[i], "--json" ) ) json = true;
+			else if ( !strcmp ( argv[i], "--echo" ) ) echo = true;
+			else
+			{
+				std::cout << "Wrong batch mode argument: " << argv[i] << std::endl;
+				return 1;
+			}
+		}
+	}
 	if ( nSPI == 2 )
 	{
 		bMasterMode = false;
@@ -47,7 +75,12 @@ int main ( int argc, char *argv[] )
 	if ( bMasterMode )
 	{
 
+#ifdef TIMESWIPE_LOOPBACK
+		// the in-process loopback board answers on any bus
+		CLoopbackSPI spi;
+#else
 		CBcmSPI spi ( nSPI ? CBcmLIB::iSPI::SPI1 : CBcmLIB::iSPI::SPI0 );
+#endif
 
 		if ( !spi.is_initialzed ( ) )
 		{
@@ -59,7 +92,35 @@ int main ( int argc, char *argv[] )
 		CFIFO  msg;
 		CFIFO answer;
 
-		if ( interactive == true )
+		if ( script )
+		{
+			CSPIBatch batch;
+			std::string error;
+			std::ifstream file;
+			if ( strcmp ( script, "-" ) ) file.open ( script );
+			if ( strcmp ( script, "-" ) && !file.is_open ( ) )
+			{
+				std::cout << "Failed to open the script: " << script << std::endl;
+				return 1;
+			}
+			if ( !batch.load ( file.is_open ( ) ? file : std::cin, error ) )
+			{
+				std::cout << "Wrong script: " << error << std::endl;
+				return 1;
+			}
+			const bool ok = batch.run ( [&] ( const std::string & cmd, std::string & ans ) {
+				msg.reset ( );
+				msg += cmd;
+				spi.send ( msg );
+				if ( !spi.receive ( answer ) ) return false;
+				ans = answer;
+				return true;
+			}, repeat, echo );
+			batch.report ( std::cout, json );
+			// failed or error answers make the run fail, e.g. in CI
+			return ok ? 0 : 2;
+		}
+		else if ( interactive == true )
 		{
 			std::cout << "SPI-" << nSPI << " Master" << std::endl << "type the commands:" << std::endl << "->" << std::endl;
 			while ( true )
@@ -4,55 +4,20 @@
  */
 #pragma once
 #include <memory>
+#include <chrono>
 #include <functional>
 #include <array>
 #include <vector>
 #include <string>
+#include <utility>
 
-/**
- * \brief Sensors container
- */
-class SensorsData {
-    static constexpr size_t SENSORS = 4;
-    using CONTAINER = std::array<std::vector<float>, SENSORS>;
-public:
-    /**
-     * \brief Get number of sensors
-     *
-     *
-     * @return number of sensors
-     */
-    size_t SensorsSize();
-
-    /**
-     * \brief Get number of data entries
-     *
-     *
-     * @return number of data entries each sensor has
-     */
-    size_t DataSize();
-
-    /**
-     * \brief Access sensor data
-     *
-     * @param num - sensor number. Valid values from 0 to @ref SensorsSize-1
-     *
-     * @return number of data entries each sensor has
-     */
-
-    std::vector<float>& operator[](size_t num);
-
-    CONTAINER& data();
-    void reserve(size_t num);
-    void clear();
-    bool empty();
-    void append(SensorsData&& other);
-    void erase_front(size_t num);
-    void erase_back(size_t num);
-
-private:
-    CONTAINER _data;
-};
+// the sensor data can allocate from a std::pmr::memory_resource when the standard library has one
+// (libstdc++ of GCC 9 or later), TIMESWIPE_NO_PMR turns it off;
+// the library and its users must be compiled with the same setting
+#if !defined(TIMESWIPE_NO_PMR) && __has_include(<memory_resource>)
+#include <memory_resource>
+#define TIMESWIPE_PMR 1
+#endif
 
 class TimeSwipeEventImpl;
 
@@ -174,6 +139,27 @@ public:
         int _value;
     };
 
+    /**
+      * \brief Driver-side setting change, delivered as a @ref SensorsData marker only
+      */
+    class Setting {
+    public:
+        Setting() = default;
+        Setting(std::string _name, std::string _value);
+        /**
+          * \brief returns the setting name: "Settings" for @ref TimeSwipe::SetSettings,
+          * "PWM1", "PWM2", "SensorOffsets", "SensorGains", "SensorTransmissions" or "SensorCalibration"
+          */
+        const std::string& name() const;
+        /**
+          * \brief returns the new value as JSON string
+          */
+        const std::string& value() const;
+    private:
+        std::string _name;
+        std::string _value;
+    };
+
     /**
       * \brief Check for interested event
       */
@@ -203,6 +189,273 @@ private:
 };
 
 
+/**
+ * \brief Sensors container
+ *
+ * With TIMESWIPE_PMR the sensor vectors are std::pmr::vector<float> and allocate from a std::pmr::memory_resource,
+ * the default one is the global heap. Without it they are std::vector<float>.
+ * Code that names the vector type should use @ref VECTOR
+ */
+class SensorsData {
+    static constexpr size_t SENSORS = 4;
+public:
+#ifdef TIMESWIPE_PMR
+    using VECTOR = std::pmr::vector<float>;
+#else
+    using VECTOR = std::vector<float>;
+#endif
+private:
+    using CONTAINER = std::array<VECTOR, SENSORS>;
+public:
+#ifdef TIMESWIPE_PMR
+    /**
+     * \brief Create an empty container
+     *
+     * @param resource - memory resource used by the sensor vectors, must outlive the container
+     */
+    explicit SensorsData(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+#else
+    /**
+     * \brief Create an empty container
+     */
+    SensorsData() = default;
+#endif
+
+    /**
+     * \brief Copy the data, the copy uses the same memory resource as @p other does
+     */
+    SensorsData(const SensorsData& other);
+    SensorsData(SensorsData&& other) = default;
+    SensorsData& operator=(const SensorsData& other) = default;
+    SensorsData& operator=(SensorsData&& other) = default;
+
+#ifdef TIMESWIPE_PMR
+    /**
+     * \brief Get the memory resource the sensor vectors allocate from
+     *
+     *
+     * @return memory resource
+     */
+    std::pmr::memory_resource* resource() const;
+#endif
+
+    /**
+     * \brief Event marker in the data stream
+     */
+    struct Marker {
+        /// index of the first sample taken after the event, counted from @ref TimeSwipe::Start at the delivered sample rate
+        uint64_t sample;
+        /// board event or driver-side @ref TimeSwipeEvent::Setting change
+        TimeSwipeEvent event;
+    };
+
+    /**
+     * \brief Access event markers
+     *
+     * The markers are sorted by sample. A marker is delivered together with the data that holds its sample,
+     * a board event read late may refer to a sample delivered before.
+     * The markers are kept by @ref append and are not affected by @ref erase_front and @ref erase_back
+     *
+     * @return markers
+     */
+    std::vector<Marker>& markers();
+    const std::vector<Marker>& markers() const;
+
+    /**
+     * \brief Get number of sensors
+     *
+     *
+     * @return number of sensors
+     */
+    size_t SensorsSize() const;
+
+    /**
+     * \brief Get number of data entries
+     *
+     *
+     * @return number of data entries each sensor has
+     */
+    size_t DataSize() const;
+
+    /**
+     * \brief Access sensor data
+     *
+     * Sensors disabled by @ref TimeSwipe::SetChannelMask have empty data
+     *
+     * @param num - sensor number. Valid values from 0 to @ref SensorsSize-1
+     *
+     * @return number of data entries each sensor has
+     */
+
+    VECTOR& operator[](size_t num);
+    const VECTOR& operator[](size_t num) const;
+
+    CONTAINER& data();
+    void reserve(size_t num);
+    void clear();
+    bool empty() const;
+    void append(SensorsData&& other);
+    void erase_front(size_t num);
+    void erase_back(size_t num);
+
+private:
+    CONTAINER _data;
+    std::vector<Marker> _markers;
+};
+
+/**
+ * \brief Board health snapshot
+ *
+ * Monitor readings, fan, DAC and PWM state of the board taken at the same moment
+ */
+struct TimeSwipeSnapshot {
+    /// record layout version reported by the board
+    uint16_t version = 0;
+    /// snapshot sequence number
+    uint32_t seq = 0;
+    /// snapshot time stamp of the board, milliseconds
+    uint32_t time_ms = 0;
+    /// core temperature, degrees Celsius
+    float temperature = 0;
+    /// fan state
+    bool fan_on = false;
+    /// monitor ADC values, raw-binary format
+    std::array<uint16_t, 4> adc_raw{};
+    /// filtered monitor ADC values
+    std::array<float, 4> adc_filtered{};
+    /// RMS of filtered monitor ADC values
+    std::array<float, 4> adc_rms{};
+    /// peak of filtered monitor ADC values
+    std::array<float, 4> adc_peak{};
+    /// offset DAC values, raw-binary format
+    std::array<uint16_t, 4> dac_raw{};
+    /// analog outputs #3, #4 values, raw-binary format
+    std::array<uint16_t, 2> aout_raw{};
+    /// PWM states
+    std::array<bool, 2> pwm_active{};
+    /// PWM frequencies, Hz
+    std::array<uint32_t, 2> pwm_frequency{};
+    /// PWM repeats
+    std::array<uint32_t, 2> pwm_repeats{};
+    /// PWM duty cycles
+    std::array<float, 2> pwm_duty_cycle{};
+    /// PWM high levels, raw-binary format
+    std::array<uint16_t, 2> pwm_high{};
+    /// PWM low levels, raw-binary format
+    std::array<uint16_t, 2> pwm_low{};
+};
+
+/**
+ * \brief Output setpoints queued by the control hook
+ *
+ * The setpoints of a block go to the board in a single SetSettings request, a setting queued twice keeps the last value
+ */
+class TimeSwipeSetpoints {
+public:
+    /// queue an integer setting, e.g. "AOUT3.raw"
+    void Set(const std::string& name, int value);
+    /// queue a floating point setting, e.g. "PWM1.duty"
+    void Set(const std::string& name, double value);
+    /// queue an on/off setting, e.g. "PWM1"
+    void Set(const std::string& name, bool value);
+
+    bool empty() const { return _values.empty(); }
+    void clear() { _values.clear(); }
+
+    /// queue the setpoints of other on top of these ones
+    void merge(const TimeSwipeSetpoints& other);
+
+    /// SetSettings request of the queued setpoints
+    std::string json() const;
+
+private:
+    void _set(const std::string& name, std::string value);
+    std::vector<std::pair<std::string, std::string>> _values;
+};
+
+/**
+ * \brief Latency distribution, microseconds
+ */
+struct TimeSwipeLatency {
+    double min_us = 0;
+    double p50_us = 0;
+    double p90_us = 0;
+    double p99_us = 0;
+    double max_us = 0;
+};
+
+/**
+ * \brief Control path statistics
+ *
+ * The latency is the time from the end of the block read to the board answer of its setpoints
+ */
+struct TimeSwipeControlStats {
+    /// blocks passed to the control hook
+    uint64_t blocks = 0;
+    /// requests sent to the board
+    uint64_t sent = 0;
+    /// setpoints superseded by a later block before they were sent
+    uint64_t merged = 0;
+    /// failed requests
+    uint64_t errors = 0;
+    /// latency distribution over the last requests sent
+    TimeSwipeLatency latency;
+};
+
+/**
+ * \brief Sample latency statistics
+ *
+ * The age of the oldest sample of the data passed to the read callback of @ref TimeSwipe::Start,
+ * split into the pipeline stages. The stages of a callback sum up to its total.
+ * The distributions are taken over the last callbacks
+ */
+struct TimeSwipeLatencyStats {
+    /// callbacks with data measured since @ref TimeSwipe::Start
+    uint64_t count = 0;
+    /// the board read of the block holding the sample
+    TimeSwipeLatency read;
+    /// the end of the read to the record queue: event markers and the control hook
+    TimeSwipeLatency fetch;
+    /// the record queue wait, the poller sleep included
+    TimeSwipeLatency queue;
+    /// the resampler hold (slicing and filter delay) and the degradation policy
+    TimeSwipeLatency process;
+    /// the burst buffer accumulation
+    TimeSwipeLatency burst;
+    /// the start of the block read to the read callback
+    TimeSwipeLatency total;
+};
+
+/**
+ * \brief Point of a compressed sensor stream
+ */
+struct TimeSwipePoint {
+    /// sample index in the delivered stream, the time since @ref TimeSwipe::Start is sample / sample rate
+    uint64_t sample;
+    /// sensor value
+    float value;
+};
+
+/**
+ * \brief Board sample clock estimate
+ *
+ * The board sample rate measured against the system clock from the block arrival times
+ */
+struct TimeSwipeClockStats {
+    /// false until enough blocks are measured, about 8 seconds after @ref TimeSwipe::Start
+    bool valid = false;
+    /// nominal sample rate of the board
+    double nominal_rate = 0;
+    /// estimated sample rate of the board, samples per system clock second
+    double rate = 0;
+    /// rate error, parts per million, positive if the board clock runs fast
+    double ppm = 0;
+    /// median deviation of the block arrival times from the estimated clock, microseconds
+    double jitter_us = 0;
+    /// samples repeated (positive) less samples dropped by the clock lock, see @ref TimeSwipe::SetClockLock
+    int64_t slips = 0;
+};
+
 class TimeSwipeImpl;
 
 /**
@@ -275,6 +528,74 @@ public:
      */
     void SetSensorTransmissions(float trans1, float trans2, float trans3, float trans4);
 
+    /**
+     * \brief Setup a linear Sensor calibration table
+     *
+     * The sensor value is calculated as (raw - offset) * mfactor, where raw is the sensor ADC code 0..65535.
+     * All calibration curves are precomputed into a 65536-entry lookup table per sensor,
+     * so any curve costs the same as the default linear scaling.
+     * A calibration table replaces the offset, gain and transmission scaling of the sensor.
+     * It is mandatory to setup calibration before @ref Start
+     *
+     * @param num - sensor number - possible values are 0..3
+     * @param offset - raw offset
+     * @param mfactor - multiplier
+     * @return true on success, false on wrong sensor number
+     */
+    bool SetSensorLinear(uint8_t num, int offset, float mfactor);
+
+    /**
+     * \brief Setup a polynomial Sensor calibration table
+     *
+     * The sensor value is calculated as coeffs[0] + coeffs[1]*raw + coeffs[2]*raw^2 + ...
+     * See @ref SetSensorLinear for details
+     *
+     * @param num - sensor number - possible values are 0..3
+     * @param coeffs - polynomial coefficients, the lowest order first
+     * @return true on success, false on wrong sensor number or empty coefficients
+     */
+    bool SetSensorPolynomial(uint8_t num, const std::vector<double>& coeffs);
+
+    /**
+     * \brief Setup a piecewise-linear Sensor calibration table
+     *
+     * The sensor value is interpolated linearly between (raw, value) points,
+     * outside the points range the value of the nearest point is used.
+     * See @ref SetSensorLinear for details
+     *
+     * @param num - sensor number - possible values are 0..3
+     * @param points - (raw, value) calibration points in any order
+     * @return true on success, false on wrong sensor number or empty points
+     */
+    bool SetSensorPiecewise(uint8_t num, const std::vector<std::pair<uint16_t, float>>& points);
+
+    /**
+     * \brief Remove the Sensor calibration table
+     *
+     * The sensor returns to the offset, gain and transmission scaling
+     *
+     * @param num - sensor number - possible values are 0..3
+     */
+    void ResetSensorCalibration(uint8_t num);
+
+    /**
+     * \brief Setup enabled sensors
+     *
+     * Disabled sensors are skipped in decoding, resampling and delivery: their data in @ref SensorsData is empty.
+     * Default is all sensors enabled. Can be called only when not started
+     *
+     * @param mask - bit 0 - sensor 1 ... bit 3 - sensor 4, at least one sensor must be enabled
+     * @return true on success, false on wrong mask or if started
+     */
+    bool SetChannelMask(uint8_t mask);
+
+    /**
+     * \brief Get enabled sensors
+     *
+     * @return the mask of enabled sensors, see @ref SetChannelMask
+     */
+    uint8_t GetChannelMask();
+
     /**
      * \brief Start PWM generator
      * Method can be called in any time.
@@ -333,6 +654,23 @@ public:
      */
     bool SetSampleRate(int rate);
 
+#ifdef TIMESWIPE_PMR
+    /**
+     * \brief Set memory resource for the sensor data
+     *
+     * All @ref SensorsData buffers of the driver (the reader blocks, the resampler and the burst buffer) and
+     * the data passed to the cb of @ref Start allocate from this resource.
+     * The data is allocated by the reader thread and released by the poller thread or by the user,
+     * so the resource must be thread-safe (e.g. std::pmr::synchronized_pool_resource) and must outlive
+     * the driver and all the data delivered.
+     * Must be called before @ref Start
+     *
+     * @param resource - memory resource, nullptr restores the default one
+     * @return false if the driver is started
+     */
+    bool SetMemoryResource(std::pmr::memory_resource* resource);
+#endif
+
     /**
      * \brief Read sensors callback function pointer
      */
@@ -351,6 +689,9 @@ public:
      *
      * Function can not be called from callback
      *
+     * The settings stored in the HAT EEPROM are applied first: the mode, then the offsets, gains, transmissions
+     * and calibration tables of the mode profile. The ones set by the application before are kept
+     *
      * @param cb
      * @return false if reading procedure start failed, otherwise true
      */
@@ -374,6 +715,18 @@ public:
      */
     std::string GetSettings(const std::string& request, std::string& error);
 
+    /**
+     * \brief Store the settings applied by @ref Start into the HAT EEPROM
+     *
+     * The settings atom of the image is added or replaced, the other atoms are kept.
+     * The board reads at most 1024 bytes of the image, the larger ones are refused
+     *
+     * @param json - the settings atom: {"timeswipe": ..., "mode": ..., "profiles": {...}}
+     * @param error - output error
+     * @return false if the atom is wrong, the image is too large or the EEPROM write failed
+     */
+    bool StoreEEPROMSettings(const std::string& json, std::string& error);
+
     using OnEventCallback = std::function<void(TimeSwipeEvent&& event)>;
     /**
      * \brief Register callback for event
@@ -385,6 +738,15 @@ public:
      */
     bool onEvent(OnEventCallback cb);
 
+    /**
+     * \brief Number of board events lost so far
+     *
+     * Board events are sequence-numbered, a gap in the sequence or a board queue overflow is counted here
+     *
+     * @return number of lost events
+     */
+    uint64_t EventsLost();
+
     using OnErrorCallback = std::function<void(uint64_t)>;
     /**
      * \brief Register error callback
@@ -396,6 +758,155 @@ public:
      */
     bool onError(OnErrorCallback cb);
 
+    /** @enum TimeSwipe::Degradation
+     *
+     * \brief Delivered stream level under consumer lag
+     *
+     */
+    enum class Degradation {
+        /// all samples, the usual callback rate
+        None,
+        /// all samples, everything queued is delivered in one callback
+        Batch,
+        /// every 8 samples are averaged into one
+        Decimate,
+        /// every 64 samples are replaced by their minimum and maximum (in this order)
+        Envelope
+    };
+
+    using OnDegradationCallback = std::function<void(Degradation level)>;
+    /**
+     * \brief Enable the degradation policy and register its callback
+     *
+     * If the read callback can't keep up and the record queue stays filled, the delivered stream degrades step by step:
+     * @ref Degradation::Batch, then @ref Degradation::Decimate, then @ref Degradation::Envelope.
+     * Once the queue stays nearly empty the stream recovers the same way back to @ref Degradation::None.
+     * cb is called from the read callback thread right before the first data of the new level is delivered.
+     * The markers of @ref SensorsData index the delivered (reduced) stream.
+     *
+     * onDegradation must be called before @ref Start called, otherwise register fails
+     *
+     * @param cb callback called on each level change
+     * @return false if register callback failed, true otherwise
+     */
+    bool onDegradation(OnDegradationCallback cb);
+
+    using ControlCallback = std::function<void(const SensorsData& block, TimeSwipeSetpoints& setpoints)>;
+    /**
+     * \brief Register the closed-loop control hook
+     *
+     * cb is called from the acquisition thread with each block as soon as it is read, before the resampling
+     * and the read callback queue. The setpoints queued by cb are sent by a dedicated control thread
+     * over the same board link as all other board requests; a waiting control request takes the link
+     * before them (settings, events, snapshots), but does not interrupt the one in progress. If the previous setpoints are still on the way,
+     * the new ones are merged and go with the next request.
+     * cb delays the acquisition thread, so it has to return quickly
+     *
+     * onControl must be called before @ref Start called, otherwise register fails
+     *
+     * @param cb callback called on each block read
+     * @return false if register callback failed, true otherwise
+     */
+    bool onControl(ControlCallback cb);
+
+    /**
+     * \brief Control path statistics since @ref Start
+     *
+     * @return blocks, requests and the achieved input-to-output latency distribution
+     */
+    TimeSwipeControlStats GetControlStats();
+
+    /**
+     * \brief Sample latency statistics since @ref Start
+     *
+     * @return the latency distribution of the delivered data per pipeline stage
+     */
+    TimeSwipeLatencyStats GetLatencyStats();
+
+    /** @enum TimeSwipe::Compression
+     *
+     * \brief Sensor stream compression
+     *
+     */
+    enum class Compression {
+        /// all samples
+        None,
+        /// a point whenever the value moves by more than the bound from the last point, reconstructed by sample-and-hold
+        Deadband,
+        /// the swinging door: the ends of the straight segments staying within the bound, reconstructed by linear interpolation
+        SwingingDoor
+    };
+
+    /**
+     * \brief Setup Sensor compression
+     *
+     * The compressed sensor is delivered as points to the @ref onCompressed callback instead of the read callback:
+     * its @ref SensorsData vector is empty. The first sample is always a point, the last one is a point at @ref Stop.
+     * The stream reconstructed from the points differs from the delivered one by at most bound.
+     * Without the @ref onCompressed callback registered nothing is compressed, the sensor goes to the read callback as is
+     *
+     * SetCompression must be called before @ref Start called, otherwise setup fails
+     *
+     * @param num - sensor number - possible values are 0..3
+     * @param mode - compression
+     * @param bound - reconstruction error bound, in sensor units
+     * @param maxInterval - the most samples between the points, 0 means no limit
+     * @return false on wrong sensor number or if called while started
+     */
+    bool SetCompression(uint8_t num, Compression mode, float bound, uint32_t maxInterval = 0);
+
+    using OnCompressedCallback = std::function<void(std::array<std::vector<TimeSwipePoint>, 4>&& points)>;
+    /**
+     * \brief Register the compressed data callback
+     *
+     * cb is called from the read callback thread right before each read callback with the new points of every sensor
+     * set up by @ref SetCompression, and once more at @ref Stop with the last points
+     *
+     * onCompressed must be called before @ref Start called, otherwise register fails
+     *
+     * @param cb callback called with the points
+     * @return false if register callback failed, true otherwise
+     */
+    bool onCompressed(OnCompressedCallback cb);
+
+    /**
+     * \brief Board sample clock estimate since @ref Start
+     *
+     * The true sample rate is fitted continuously over the last 8 minutes of the block arrival times,
+     * the earliest arrival of every second is taken, so late reads and stalls don't bias it
+     *
+     * @return the estimated rate and its error against the nominal one
+     */
+    TimeSwipeClockStats GetClockStats();
+
+    /**
+     * \brief Get system time of a delivered sample
+     *
+     * Maps the sample index (the one of @ref SensorsData::Marker::sample) to the system clock through the estimated board clock.
+     * The system clock adjustments (e.g. NTP) are followed up to the call. The mapping is exact for the undegraded stream,
+     * see @ref onDegradation
+     *
+     * @param sample - sample index counted from @ref Start at the delivered sample rate
+     * @param time - output system time
+     * @return false if there is no estimate yet
+     */
+    bool GetSampleTime(uint64_t sample, std::chrono::system_clock::time_point& time);
+
+    /**
+     * \brief Lock the delivered stream to the system clock
+     *
+     * Once the board clock is estimated, the delivered stream repeats or drops a sample at the end of a block
+     * whenever it gets a sample ahead or behind the system clock, so every delivered sample is within a sample of
+     * its nominal time since @ref Start. The markers follow the slips. Degraded data is not corrected.
+     * The slips are counted in @ref TimeSwipeClockStats::slips
+     *
+     * SetClockLock must be called before @ref Start called, otherwise setup fails
+     *
+     * @param enable - true to lock, default is unlocked
+     * @return false if called while started
+     */
+    bool SetClockLock(bool enable);
+
     /**
      * \brief Stop reading Sensor loop
      *
@@ -403,12 +914,32 @@ public:
      */
     bool Stop();
 
+    /**
+     * \brief Read board health snapshot
+     *
+     * The snapshot is fetched in a single SPI transaction, the board refreshes it every 100ms by default
+     *
+     * @param snap - output snapshot
+     * @return true on success, false otherwise
+     */
+    bool GetSnapshot(TimeSwipeSnapshot& snap);
+
     /*!
      * \brief TraceSPI
      * \param val true=on
      */
     void TraceSPI(bool val);
 
+    /**
+     * \brief Name of the CPU-specific data processing kernels in use
+     *
+     * The kernels are picked at startup from the detected CPU features: "avx2", "sse4", "neon" or "scalar".
+     * TIMESWIPE_KERNELS environment variable may force one of them, all of them give identical results
+     *
+     * @return kernels name
+     */
+    static const char* GetKernels();
+
     static bool resample_log;
 private:
     std::unique_ptr<TimeSwipeImpl> _impl;
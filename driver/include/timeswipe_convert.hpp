@@ -0,0 +1,145 @@
+/**
+ * \file
+ * \brief Timeswipe offline recording converter
+ */
+#pragma once
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+#include "timeswipe.hpp"
+
+/**
+ * \brief Offline recording converter
+ *
+ * Reprocesses a recorded stream with the driver calibration and resampler code.
+ * The recording is read by batches, every batch is split into chunks processed in parallel.
+ * The resampler processes fixed slices of the input and the output of a slice depends on the slice and its filter padding only,
+ * so the chunks start at slice boundaries and overlap by the padding: the stitched output is the same as
+ * the one of a single resampler over the whole stream, sample by sample.
+ */
+class TimeSwipeConverter {
+public:
+    /** @enum TimeSwipeConverter::Format
+     *
+     * \brief Recording format
+     *
+     */
+    enum class Format {
+        /// text, a line per sample, 1..4 sensor values separated by tabs (DataLogging example output)
+        TSV,
+        /// binary, 4 native float32 sensor values per sample
+        F32,
+        /// binary, 4 native uint16 sensor ADC codes per sample, input only
+        RAW16,
+    };
+
+    /**
+     * \brief Parse format name
+     *
+     * @param name - "tsv", "f32" or "raw16"
+     * @param format - output format
+     * @return false if the name is unknown
+     */
+    static bool ParseFormat(const std::string& name, Format& format);
+
+    /**
+     * \brief Setup input and output sample rates
+     *
+     * The stream is resampled if the rates differ, the same way the driver does for @ref TimeSwipe::SetSampleRate
+     *
+     * @param input - recording sample rate
+     * @param output - converted sample rate
+     * @return false if a rate is not positive
+     */
+    bool SetSampleRates(int input, int output);
+
+    /**
+     * \brief Setup a linear calibration table of @ref Format::RAW16 input
+     *
+     * The sensor value is calculated as (raw - offset) * mfactor, the same lookup tables as @ref TimeSwipe::SetSensorLinear use.
+     * Without a table the ADC code itself is the sensor value
+     *
+     * @param num - sensor number - possible values are 0..3
+     * @param offset - raw offset
+     * @param mfactor - multiplier
+     * @return true on success, false on wrong sensor number
+     */
+    bool SetSensorLinear(uint8_t num, int offset, float mfactor);
+
+    /**
+     * \brief Setup a polynomial calibration table of @ref Format::RAW16 input
+     *
+     * See @ref TimeSwipe::SetSensorPolynomial for details
+     *
+     * @param num - sensor number - possible values are 0..3
+     * @param coeffs - polynomial coefficients, the lowest order first
+     * @return true on success, false on wrong sensor number or empty coefficients
+     */
+    bool SetSensorPolynomial(uint8_t num, const std::vector<double>& coeffs);
+
+    /**
+     * \brief Setup a Sensor rescaling
+     *
+     * The sensor value is replaced by value * gain + offset before resampling, for any input format
+     *
+     * @param num - sensor number - possible values are 0..3
+     * @param gain - multiplier
+     * @param offset - added value
+     * @return true on success, false on wrong sensor number
+     */
+    bool SetSensorScale(uint8_t num, float gain, float offset);
+
+    /**
+     * \brief Setup the number of threads
+     *
+     * @param threads - 0 (the default) means one thread per CPU core
+     */
+    void SetThreads(unsigned threads);
+
+    /**
+     * \brief Setup the chunk size
+     *
+     * The size is rounded up to the resampler slice size
+     *
+     * @param samples - input samples per chunk
+     */
+    void SetChunkSize(size_t samples);
+
+    /**
+     * \brief Process the stream in a single pass in the calling thread
+     *
+     * A single resampler takes the whole stream by blocks, as the driver does live.
+     * This is the reference the chunked conversion is equal to
+     *
+     * @param serial - true for the single pass
+     */
+    void SetSerial(bool serial);
+
+    /**
+     * \brief Convert a recording
+     *
+     * The resampler is flushed at the end of the input, so every input sample has its output:
+     * the output has input samples * output rate / input rate samples, rounded down per resampler slice
+     *
+     * @param in - input stream, opened in binary mode for the binary formats
+     * @param inFormat - input format
+     * @param out - output stream, opened in binary mode for the binary formats
+     * @param outFormat - output format
+     * @param error - output error
+     * @return number of input samples converted, 0 and error set if failed
+     */
+    uint64_t Convert(std::istream& in, Format inFormat, std::ostream& out, Format outFormat, std::string& error);
+
+private:
+    int inputRate = 48000;
+    int outputRate = 48000;
+    std::array<std::shared_ptr<const std::vector<float>>, 4> lut;
+    std::array<float, 4> gain{1, 1, 1, 1};
+    std::array<float, 4> offset{};
+    unsigned threads = 0;
+    size_t chunkSize = 48000;
+    bool serial = false;
+};
@@ -0,0 +1,164 @@
+/**
+ * \file
+ * \brief Timeswipe min/max/mean pyramid of recordings
+ */
+#pragma once
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include "timeswipe.hpp"
+
+/**
+ * \brief Summary of a sample range of a sensor
+ *
+ * The values are NaN if the range has no data
+ */
+struct TimeSwipePyramidValue {
+    float min;
+    float max;
+    float mean;
+};
+
+/**
+ * \brief Min/max/mean pyramid writer
+ *
+ * Builds the overview sidecar file of a recording incrementally, e.g. from the read callback of @ref TimeSwipe::Start.
+ * Level 0 summarizes every factor samples, each next level summarizes factor entries of the previous one.
+ * The levels are written by pages: the file holds every complete page as soon as it is filled, @ref Flush
+ * and @ref Close write the incomplete ones too. An incomplete page takes the slot of a complete one
+ * and is filled in place, so the file is the same however often it is flushed.
+ * The pyramid takes about 3 / (factor - 1) of the size of the float32 recording, plus up to a page (48 KiB) per level
+ */
+class TimeSwipePyramidWriter {
+public:
+    static constexpr unsigned MIN_FACTOR = 2;
+    static constexpr unsigned MAX_FACTOR = 16;
+
+    ~TimeSwipePyramidWriter();
+
+    /**
+     * \brief Create the sidecar file
+     *
+     * @param path - sidecar file name, e.g. the recording name with ".pyr" appended
+     * @param sampleRate - sample rate of the recording
+     * @param factor - decimation factor between the levels, 2..16
+     * @param error - output error
+     * @return false on failure
+     */
+    bool Open(const std::string& path, int sampleRate, unsigned factor, std::string& error);
+
+    /**
+     * \brief Add the samples following the ones added before
+     *
+     * Sensors without data (e.g. disabled ones) get NaN values
+     *
+     * @param data - sensors data
+     */
+    void Append(const SensorsData& data);
+
+    /**
+     * \brief Write the incomplete pages
+     *
+     * The entries are complete summaries only, the samples of an incomplete entry are written once it is complete
+     */
+    void Flush();
+
+    /**
+     * \brief Write the incomplete pages and close the file
+     */
+    void Close();
+
+private:
+    struct Accumulator {
+        float min = std::numeric_limits<float>::quiet_NaN();
+        float max = std::numeric_limits<float>::quiet_NaN();
+        double sum = 0;
+        // the values summed, NaN ones are skipped
+        uint32_t n = 0;
+    };
+
+    struct Level {
+        // the entry in progress
+        std::array<Accumulator, 4> acc;
+        uint32_t count = 0;
+        // the page in progress and its first entry index
+        uint64_t pageFirst = 0;
+        std::vector<TimeSwipePyramidValue> page;
+        // the file slot of the page in progress once it has been flushed (-1 if not) and its entries written
+        std::streamoff slot = -1;
+        size_t written = 0;
+    };
+
+    // the entry of the level is complete: goes to the page and to the next level
+    void emit(size_t level);
+    void writePage(size_t level);
+
+    std::ofstream file;
+    unsigned factor = 0;
+    std::vector<Level> levels;
+};
+
+/**
+ * \brief Min/max/mean pyramid reader
+ *
+ * Answers any sample range at any resolution reading a bounded number of entries
+ */
+class TimeSwipePyramidReader {
+public:
+    /**
+     * \brief Open the sidecar file
+     *
+     * The file may be growing: the pages written by then are taken
+     *
+     * @param path - sidecar file name
+     * @param error - output error
+     * @return false on failure
+     */
+    bool Open(const std::string& path, std::string& error);
+
+    /// sample rate of the recording
+    int SampleRate() const { return sampleRate; }
+
+    /// decimation factor between the levels
+    unsigned Factor() const { return factor; }
+
+    /// number of the recording samples summarized by level 0
+    uint64_t Samples() const;
+
+    /**
+     * \brief Summarize a sample range by pixels
+     *
+     * The range [first, last) is split into pixels equal parts, each one is summarized from the coarsest level
+     * whose entries are not larger than a pixel. At most about pixels * factor entries are read whatever the range is.
+     * With pixels smaller than factor samples the level 0 entries are used, so a pixel may be summarized
+     * by the entry it starts in only.
+     *
+     * @param sensor - sensor number - possible values are 0..3
+     * @param first - first sample
+     * @param last - sample after the last one
+     * @param pixels - number of pixels
+     * @param out - output values, one per pixel
+     * @return false on wrong arguments or read failure
+     */
+    bool Query(uint8_t sensor, uint64_t first, uint64_t last, size_t pixels, std::vector<TimeSwipePyramidValue>& out);
+
+private:
+    struct Page {
+        uint64_t first;
+        uint32_t count;
+        std::streamoff offset;
+    };
+
+    bool read(size_t level, uint64_t begin, uint64_t end, std::vector<std::array<TimeSwipePyramidValue, 4>>& out);
+
+    std::ifstream file;
+    int sampleRate = 0;
+    unsigned factor = 0;
+    uint32_t pageSize = 0;
+    // pages of every level sorted by the first entry
+    std::vector<std::vector<Page>> levels;
+};
@@ -1,6 +1,9 @@
 #include "board.hpp"
 #include "defs.h"
+#include "timeswipe_snapshot.hpp"
 #include <nlohmann/json.hpp>
+#include <condition_variable>
+#include <mutex>
 
 // RPI GPIO FUNCTIONS
 void pullGPIO(unsigned pin, unsigned high)
@@ -94,13 +97,78 @@ unsigned int readAllGPIO()
     return (*(gpio + 13) & ALL_32_BITS_ON); 
 }
 
+// the board bus owner: one board request at a time
 static std::mutex boardMtx;
+static std::condition_variable boardFree;
+static bool boardBusy = false;
+// the control setpoints go to the board ahead of all other traffic:
+// the bus is handed to a waiting control request before the other callers
+static int boardControlWaiters = 0;
+
+class BoardLock {
+public:
+    explicit BoardLock(bool control = false) {
+        std::unique_lock<std::mutex> lock(boardMtx);
+        if (control) {
+            ++boardControlWaiters;
+            boardFree.wait(lock, [] { return !boardBusy; });
+            --boardControlWaiters;
+        } else {
+            boardFree.wait(lock, [] { return !boardBusy && !boardControlWaiters; });
+        }
+        boardBusy = true;
+    }
+
+    ~BoardLock() {
+        {
+            std::lock_guard<std::mutex> lock(boardMtx);
+            boardBusy = false;
+        }
+        boardFree.notify_all();
+    }
+
+    BoardLock(const BoardLock&) = delete;
+    BoardLock& operator=(const BoardLock&) = delete;
+};
+
+// sequence tracking of the board event queue
+static bool eventsSeqValid = false;
+static uint32_t eventsNextSeq = 0;
+static uint64_t eventsLost = 0;
+
+uint64_t BoardEventsLost()
+{
+    BoardLock lock;
+    return eventsLost;
+}
 
-std::list<TimeSwipeEvent> readBoardEvents()
+// the firmware before the event queue answers the last state of every event: {"Button":true,"ButtonStateCnt":3,"Gain":2}
+static void readLegacyEvents(const nlohmann::json& j, BoardEvents& events)
 {
-    std::list<TimeSwipeEvent> events;
-    std::lock_guard<std::mutex> lock(boardMtx);
-#if NOT_RPI
+    auto it_btn = j.find("Button");
+    if (it_btn != j.end() && it_btn->is_boolean()) {
+        auto it_cnt = j.find("ButtonStateCnt");
+        if (it_cnt != j.end() && it_cnt->is_number()) {
+            events.emplace_back(std::nullopt, TimeSwipeEvent::Button(it_btn->get<bool>(), it_cnt->get<int>()));
+        }
+    }
+    auto add = [&](const char* name, auto make) {
+        auto it = j.find(name);
+        if (it != j.end() && it->is_number()) events.emplace_back(std::nullopt, make(it->get<int>()));
+    };
+    add("Gain", [](int v) { return TimeSwipeEvent::Gain(v); });
+    add("SetSecondary", [](int v) { return TimeSwipeEvent::SetSecondary(v); });
+    add("Bridge", [](int v) { return TimeSwipeEvent::Bridge(v); });
+    add("Record", [](int v) { return TimeSwipeEvent::Record(v); });
+    add("Offset", [](int v) { return TimeSwipeEvent::Offset(v); });
+    add("Mode", [](int v) { return TimeSwipeEvent::Mode(v); });
+}
+
+BoardEvents readBoardEvents()
+{
+    BoardEvents events;
+    BoardLock lock;
+#if NO_BOARD_LINK
     return events;
 #endif
     std::string data;
@@ -111,43 +179,63 @@ std::list<TimeSwipeEvent> readBoardEvents()
 
         try {
             auto j = nlohmann::json::parse(data);
-            auto it_btn = j.find("Button");
-            if (it_btn != j.end() && it_btn->is_boolean()) {
-                auto it_cnt = j.find("ButtonStateCnt");
-                if (it_cnt != j.end() && it_cnt->is_number()) {
-                    events.push_back(TimeSwipeEvent::Button(it_btn->get<bool>(), it_cnt->get<int>()));
-                }
-            }
-
-            auto it = j.find("Gain");
-            if (it != j.end() && it->is_number()) {
-                events.push_back(TimeSwipeEvent::Gain(it->get<int>()));
-            }
-
-            it = j.find("SetSecondary");
-            if (it != j.end() && it->is_number()) {
-                events.push_back(TimeSwipeEvent::SetSecondary(it->get<int>()));
-            }
-
-            it = j.find("Bridge");
-            if (it != j.end() && it->is_number()) {
-                events.push_back(TimeSwipeEvent::Bridge(it->get<int>()));
-            }
-
-            it = j.find("Record");
-            if (it != j.end() && it->is_number()) {
-                events.push_back(TimeSwipeEvent::Record(it->get<int>()));
-            }
-
-            it = j.find("Offset");
-            if (it != j.end() && it->is_number()) {
-                events.push_back(TimeSwipeEvent::Offset(it->get<int>()));
+            auto it_ev = j.find("ev");
+            if (it_ev == j.end() || !it_ev->is_array()) {
+                readLegacyEvents(j, events);
+                return events;
             }
 
-            it = j.find("Mode");
-            if (it != j.end() && it->is_number()) {
-                events.push_back(TimeSwipeEvent::Mode(it->get<int>()));
+            // the board drops the oldest events on its queue overflow
+            auto it_lost = j.find("lost");
+            uint64_t lost = (it_lost != j.end() && it_lost->is_number()) ? it_lost->get<uint64_t>() : 0;
+
+            // each entry: [seq, time_ms, "name", value]
+            bool counted = eventsSeqValid;
+            bool btn_pressed = false;
+            bool btn_valid = false;
+            for (auto& ev: *it_ev) {
+                if (!ev.is_array() || ev.size() != 4 || !ev[0].is_number() || !ev[2].is_string()) continue;
+
+                uint32_t seq = ev[0].get<uint32_t>();
+                if (eventsSeqValid && seq < eventsNextSeq) {
+                    // the board restarted: a new sequence, its own counter tells about the loss
+                    std::cerr << "readBoardEvents: event sequence restarted at seq " << seq << '\n';
+                    counted = false;
+                } else if (eventsSeqValid && seq != eventsNextSeq) {
+                    uint32_t gap = seq - eventsNextSeq;
+                    eventsLost += gap;
+                    std::cerr << "readBoardEvents: " << gap << " events lost before seq " << seq << '\n';
+                }
+                eventsNextSeq = seq + 1;
+                eventsSeqValid = true;
+
+                const uint32_t time_ms = ev[1].is_number() ? ev[1].get<uint32_t>() : 0;
+                const auto name = ev[2].get<std::string>();
+                const auto& val = ev[3];
+                if (name == "Button" && val.is_boolean()) {
+                    btn_pressed = val.get<bool>();
+                    btn_valid = true;
+                } else if (name == "ButtonStateCnt" && val.is_number()) {
+                    if (btn_valid) events.emplace_back(time_ms, TimeSwipeEvent::Button(btn_pressed, val.get<int>()));
+                    btn_valid = false;
+                } else if (!val.is_number()) {
+                    continue;
+                } else if (name == "Gain") {
+                    events.emplace_back(time_ms, TimeSwipeEvent::Gain(val.get<int>()));
+                } else if (name == "SetSecondary") {
+                    events.emplace_back(time_ms, TimeSwipeEvent::SetSecondary(val.get<int>()));
+                } else if (name == "Bridge") {
+                    events.emplace_back(time_ms, TimeSwipeEvent::Bridge(val.get<int>()));
+                } else if (name == "Record") {
+                    events.emplace_back(time_ms, TimeSwipeEvent::Record(val.get<int>()));
+                } else if (name == "Offset") {
+                    events.emplace_back(time_ms, TimeSwipeEvent::Offset(val.get<int>()));
+                } else if (name == "Mode") {
+                    events.emplace_back(time_ms, TimeSwipeEvent::Mode(val.get<int>()));
+                }
             }
+            // without a previous sequence number only the board counter tells about the loss
+            if (!counted) eventsLost += lost;
         }
         catch (nlohmann::json::parse_error& e)
         {
@@ -159,45 +247,68 @@ std::list<TimeSwipeEvent> readBoardEvents()
 }
 
 std::string readBoardGetSettings(const std::string& request, std::string& error) {
-    std::lock_guard<std::mutex> lock(boardMtx);
-#if NOT_RPI
+    BoardLock lock;
+#if NO_BOARD_LINK
     return request;
 #endif
     return BoardInterface::get()->getGetSettings(request, error);
 }
 
 std::string readBoardSetSettings(const std::string& request, std::string& error) {
-    std::lock_guard<std::mutex> lock(boardMtx);
-#if NOT_RPI
+    BoardLock lock;
+#if NO_BOARD_LINK
     return request;
 #endif
     return BoardInterface::get()->getSetSettings(request, error);
 }
 
+bool BoardSetControl(const std::string& request, std::string& error) {
+    BoardLock lock(true);
+#if NO_BOARD_LINK
+    return true;
+#endif
+    auto answer = BoardInterface::get()->getSetSettings(request, error);
+    // the board reports a rejected setting in place of its value
+    if (error.empty() && answer.find("\"error\"") != std::string::npos) error = answer;
+    return error.empty();
+}
+
 bool BoardStartPWM(uint8_t num, uint32_t frequency, uint32_t high, uint32_t low, uint32_t repeats, float duty_cycle) {
-    std::lock_guard<std::mutex> lock(boardMtx);
-#if NOT_RPI
+    BoardLock lock;
+#if NO_BOARD_LINK
     return false;
 #endif
     return BoardInterface::get()->startPWM(num, frequency, high, low, repeats, duty_cycle);
 }
 
 bool BoardStopPWM(uint8_t num) {
-    std::lock_guard<std::mutex> lock(boardMtx);
-#if NOT_RPI
+    BoardLock lock;
+#if NO_BOARD_LINK
     return false;
 #endif
     return BoardInterface::get()->stopPWM(num);
 }
 
 bool BoardGetPWM(uint8_t num, bool& active, uint32_t& frequency, uint32_t& high, uint32_t& low, uint32_t& repeats, float& duty_cycle) {
-    std::lock_guard<std::mutex> lock(boardMtx);
-#if NOT_RPI
+    BoardLock lock;
+#if NO_BOARD_LINK
     return false;
 #endif
     return BoardInterface::get()->getPWM(num, active, frequency, high, low, repeats, duty_cycle);
 }
 
+bool BoardGetSnapshot(TimeSwipeSnapshot& snap) {
+    std::vector<uint8_t> rec;
+    {
+        BoardLock lock;
+#if NO_BOARD_LINK
+        return false;
+#endif
+        if (!BoardInterface::get()->getSnapshot(rec)) return false;
+    }
+    return TimeSwipeSnapshotRecord::Decode(rec, snap);
+}
+
 void BoardTraceSPI(bool val) {
     BoardInterface::trace_spi = val;
 }
@@ -5,6 +5,9 @@
 #include <array>
 #include <chrono>
 #include <thread>
+#include <atomic>
+#include <utility>
+#include <optional>
 
 #include "gpio/gpio.h"
 #include "board_iface.hpp"
@@ -25,17 +28,33 @@ static const unsigned char FAIL = 18; //BCM 18 - PIN 12
 static const unsigned char RESET = 17; //BCM 17 - PIN 11
 static const unsigned char BUTTON = 25; //BCM 25 - PIN 22
 
-static const std::array<uint32_t, 8> DATA_POSITION{
-  1UL << DATA0,
-  1UL << DATA1,
-  1UL << DATA2,
-  1UL << DATA3,
-  1UL << DATA4,
-  1UL << DATA5,
-  1UL << DATA6,
-  1UL << DATA7
+static constexpr std::array<unsigned char, 8> DATA_PINS{
+  DATA0, DATA1, DATA2, DATA3, DATA4, DATA5, DATA6, DATA7
 };
 
+// moves the GPIO bit "pin" to the bit "bit" of the result
+constexpr uint32_t movePinBit(uint32_t allGPIO, unsigned pin, unsigned bit)
+{
+    return pin >= bit ? (allGPIO & (1UL << pin)) >> (pin - bit)
+                      : (allGPIO & (1UL << pin)) << (bit - pin);
+}
+
+// the data byte gather generated from the pin table at compile time:
+// one mask and one constant shift per data bit, DATA0 is the MSB
+template <size_t... I>
+constexpr uint8_t gatherDataByte(uint32_t allGPIO, std::index_sequence<I...>)
+{
+    return (0 | ... | movePinBit(allGPIO, DATA_PINS[I], 7 - I));
+}
+
+constexpr uint8_t gatherDataByte(uint32_t allGPIO)
+{
+    return gatherDataByte(allGPIO, std::make_index_sequence<DATA_PINS.size()>{});
+}
+
+static_assert(gatherDataByte(1UL << DATA0) == 0x80 && gatherDataByte(1UL << DATA7) == 0x01,
+              "the data pin map is broken");
+
 static const uint32_t CLOCK_POSITION = 1UL << CLOCK;
 static const uint32_t TCO_POSITION = 1UL << TCO;
 static const uint32_t PI_STATUS_POSITION = 1UL << PI_OK;
@@ -53,12 +72,18 @@ void resetAllGPIO();
 void sleep55ns();
 void sleep8ns();
 unsigned int readAllGPIO();
-std::list<TimeSwipeEvent> readBoardEvents();
+// board events with the board time stamps, milliseconds; the legacy event format has no time stamps
+using BoardEvents = std::list<std::pair<std::optional<uint32_t>, TimeSwipeEvent>>;
+BoardEvents readBoardEvents();
+uint64_t BoardEventsLost();
 std::string readBoardGetSettings(const std::string& request, std::string& error);
 std::string readBoardSetSettings(const std::string& request, std::string& error);
+// SetSettings request of the control path, goes ahead of all other board requests
+bool BoardSetControl(const std::string& request, std::string& error);
 bool BoardStartPWM(uint8_t num, uint32_t frequency, uint32_t high, uint32_t low, uint32_t repeats, float duty_cycle);
 bool BoardStopPWM(uint8_t num);
 bool BoardGetPWM(uint8_t num, bool& active, uint32_t& frequency, uint32_t& high, uint32_t& low, uint32_t& repeats, float& duty_cycle);
+bool BoardGetSnapshot(TimeSwipeSnapshot& snap);
 void BoardTraceSPI(bool val);
 
 #include "board.cpp"
@@ -1,4 +1,5 @@
 #include "board_iface.hpp"
+#include "timeswipe_snapshot.hpp"
 #include <nlohmann/json.hpp>
 
 BoardInterface* BoardInterface::_instance = nullptr;
@@ -76,6 +77,14 @@ bool BoardInterface::getPWM(uint8_t num, bool& active, uint32_t& frequency, uint
     return true;
 }
 
+bool BoardInterface::getSnapshot(std::vector<uint8_t>& rec) {
+    sendGetCommand("Snap");
+    std::string answer;
+    if (!receiveStripAnswer(answer)) return false;
+    // the record is transferred as a hex string
+    return TimeSwipeSnapshotRecord::FromHex(answer, rec);
+}
+
 bool BoardInterface::startPWM(uint8_t num, uint32_t frequency, uint32_t high, uint32_t low, uint32_t repeats, float duty_cycle) {
 
     std::string pwm = std::string("PWM") + std::to_string(num+1);
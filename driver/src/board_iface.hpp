@@ -1,7 +1,14 @@
+#ifdef TIMESWIPE_LOOPBACK
+#include "loopback_spi.h"
+typedef CLoopbackSPI typeBoardSPI;
+#else
 #include "bcmspi.h"
+typedef CBcmSPI typeBoardSPI;
+#endif
 #include <iostream>
 #include <thread>
 #include <sstream>
+#include <vector>
 
 static void stripAnswer(std::string& str) {
     if (str.length() && str[str.length()-1] == 0x0A) // strip \n
@@ -14,7 +21,7 @@ public:
     inline static bool trace_spi = false;
 
 private:
-    CBcmSPI spi;
+    typeBoardSPI spi;
     void sendCommand(const std::string& cmd) {
         CFIFO command;
         command += cmd;
@@ -85,7 +92,6 @@ private:
     }
 
     BoardInterface()
-        : spi(CBcmLIB::iSPI::SPI0)
     {}
 
     static BoardInterface* _instance;
@@ -112,6 +118,8 @@ public:
         receiveAnswer(answer);
     }
 
+    bool getSnapshot(std::vector<uint8_t>& rec);
+
     bool getEvents(std::string& ev) {
         sendEventsCommand();
         return receiveAnswer(ev);
@@ -1,3 +1,10 @@
 #pragma once
 
-#define NOT_RPI !defined(__arm__) && !defined(__aarch64__)
\ No newline at end of file
+#define NOT_RPI !defined(__arm__) && !defined(__aarch64__)
+
+// the board link is available on RPI or via the in-process loopback board (LOOPBACK build, see src/loopback)
+#ifdef TIMESWIPE_LOOPBACK
+#define NO_BOARD_LINK 0
+#else
+#define NO_BOARD_LINK NOT_RPI
+#endif
@@ -0,0 +1,316 @@
+/*
+This Source Code Form is subject to the terms of the GNU General Public License v3.0.
+If a copy of the GPL was not distributed with this
+file, You can obtain one at https://www.gnu.org/licenses/gpl-3.0.html
+Copyright (c) 2019-2020 Panda Team
+*/
+
+#include <cstdio>
+#include "loopback_board.h"
+#include "BootTiming.h"
+#include "os.h"
+
+unsigned int CLoopbackADC::m_nWindow=1000;
+
+void CLoopbackADC::SetAvgSamples(unsigned int nSamples)
+{
+    unsigned int n=0;
+    while(n<10 && (2u<<n)<=nSamples)
+        n++;
+
+    m_nSampleNum=n;
+}
+
+void CLoopbackADC::SetPrescaler(unsigned int nDiv)
+{
+    unsigned int n=0;
+    while(n<7 && (4u<<n)<=nDiv)
+        n++;
+
+    m_nPrescaler=n;
+}
+
+void CLoopbackADC::SetSampleLen(unsigned int nCycles)
+{
+    if(nCycles<1)
+        nCycles=1;
+    if(nCycles>64)
+        nCycles=64;
+
+    m_nSampleLen=nCycles-1;
+}
+
+void CLoopbackADC::SetWindow(unsigned int nWindow)
+{
+    if(nWindow<1)
+        nWindow=1;
+    if(nWindow>60000)
+        nWindow=60000;
+
+    m_nWindow=nWindow;
+}
+
+void CLoopbackADC::Convert(unsigned int nSamples)
+{
+    m_Cond.SetWindow(m_nWindow);
+    for(unsigned int i=0; i<nSamples; i++)
+        m_Cond.Process(static_cast<float>(m_nRaw));
+}
+
+void CLoopbackSnapshot::SetPeriod(unsigned int nPeriod_mS)
+{
+    if(nPeriod_mS<10)
+        nPeriod_mS=10;
+    if(nPeriod_mS>60000)
+        nPeriod_mS=60000;
+
+    m_Period_mS=nPeriod_mS;
+}
+
+std::string CLoopbackSnapshot::GetSnapshot()
+{
+    //build the first record on demand:
+    if(0==m_Record.m_Size)
+        Snap();
+
+    return CBoardSnapshot::Encode(m_Record);
+}
+
+void CLoopbackSnapshot::Snap()
+{
+    CBoardSnapshot::record &r=m_Record;
+
+    r.m_Version=CBoardSnapshot::m_Version;
+    r.m_Size=sizeof(CBoardSnapshot::record);
+    r.m_nSeq++;
+    r.m_Time_mS=os::get_tick_mS();
+
+    //the model has no temperature sensor, the core is at the room temperature:
+    r.m_TempC=25.0f;
+    r.m_FanOn=m_Board.m_pNode->IsFanStarted() ? 1:0;
+
+    r.m_PWMon=0;
+    for(int i=0; i<CBoardSnapshot::nPWM; i++)
+    {
+        const auto &pPWM=m_Board.m_pPWM[i];
+        if(pPWM->IsStarted())
+            r.m_PWMon|=(1<<i);
+        r.m_PWMfreq[i]=pPWM->GetFrequency();
+        r.m_PWMrepeats[i]=pPWM->GetRepeats();
+        r.m_PWMduty[i]=pPWM->GetDutyCycle();
+        r.m_PWMhigh[i]=pPWM->GetHighLevel();
+        r.m_PWMlow[i]=pPWM->GetLowLevel();
+    }
+    for(int i=0; i<CBoardSnapshot::nADC; i++)
+    {
+        const auto &pADC=m_Board.m_pADC[i];
+        r.m_ADCraw[i]=pADC->DirectMeasure();
+        r.m_ADCflt[i]=pADC->GetVal();
+        r.m_ADCrms[i]=pADC->GetRMS();
+        r.m_ADCpeak[i]=pADC->GetPeak();
+    }
+    for(int i=0; i<CBoardSnapshot::nDAC; i++)
+        r.m_DACraw[i]=m_Board.m_pDAC[i]->GetRawBinVal();
+    r.m_AOUTraw[0]=m_Board.m_pNode->GetAOUT3();
+    r.m_AOUTraw[1]=m_Board.m_pNode->GetAOUT4();
+
+    m_LastSnap_mS=os::get_tick_mS();
+}
+
+void CLoopbackSnapshot::Update()
+{
+    if(os::get_tick_mS()-m_LastSnap_mS<m_Period_mS)
+        return;
+
+    Snap();
+}
+
+CLoopbackBoard::CLoopbackBoard()
+{
+    m_recFIFO.reserve(1024);
+    m_TxFIFO.reserve(1024);
+}
+
+std::shared_ptr<CLoopbackBoard> CLoopbackBoard::Factory()
+{
+    std::shared_ptr<CLoopbackBoard> pBoard(new CLoopbackBoard);
+    pBoard->Init(pBoard);
+    return pBoard;
+}
+
+void CLoopbackBoard::Init(const std::shared_ptr<CLoopbackBoard> &pThis)
+{
+    CBootTiming::Start();
+    CBootTiming::Mark(CBootTiming::eeprom);
+
+    m_pDisp=std::make_shared<CCmdDispatcher>();
+    m_pStdPort=std::make_shared<CStdPort>(m_pDisp, pThis);
+    AdviseSink(m_pStdPort);
+    CBootTiming::Mark(CBootTiming::comm);
+
+    m_pNode=std::make_shared<CLoopbackNode>();
+    const auto &pNC=m_pNode;
+
+    //analog outputs:
+    m_pDisp->Add("AOUT3.raw", std::make_shared< CCmdSGHandler<CLoopbackNode, int> >(pNC, &CLoopbackNode::GetAOUT3, &CLoopbackNode::SetAOUT3) );
+    m_pDisp->Add("AOUT4.raw", std::make_shared< CCmdSGHandler<CLoopbackNode, int> >(pNC, &CLoopbackNode::GetAOUT4, &CLoopbackNode::SetAOUT4) );
+    m_pDisp->Add("DACsw", std::make_shared< CCmdSGHandler<CLoopbackNode, bool> >(pNC, &CLoopbackNode::IsDACon, &CLoopbackNode::SetDACon) );
+
+    //monitor ADCs and offset DACs:
+    for(int i=0; i<CBoardSnapshot::nADC; i++)
+    {
+        char cmd[64];
+        int nInd=i+1;
+        auto &pADC=m_pADC[i];
+        auto &pDAC=m_pDAC[i];
+        pADC=std::make_shared<CLoopbackADC>(1000*nInd);
+        pDAC=std::make_shared<CLoopbackDAC>();
+
+        std::sprintf(cmd, "ADC%d.raw", nInd);
+        m_pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CLoopbackADC, int> >(pADC, &CLoopbackADC::DirectMeasure) );
+        std::sprintf(cmd, "ADC%d.avg", nInd);
+        m_pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CLoopbackADC, unsigned int> >(pADC, &CLoopbackADC::GetAvgSamples, &CLoopbackADC::SetAvgSamples) );
+        std::sprintf(cmd, "ADC%d.presc", nInd);
+        m_pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CLoopbackADC, unsigned int> >(pADC, &CLoopbackADC::GetPrescaler, &CLoopbackADC::SetPrescaler) );
+        std::sprintf(cmd, "ADC%d.samplen", nInd);
+        m_pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CLoopbackADC, unsigned int> >(pADC, &CLoopbackADC::GetSampleLen, &CLoopbackADC::SetSampleLen) );
+        std::sprintf(cmd, "ADC%d.fc", nInd);
+        m_pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CLoopbackADC, float> >(pADC, &CLoopbackADC::GetCutoff, &CLoopbackADC::SetCutoff) );
+        std::sprintf(cmd, "ADC%d.flt", nInd);
+        m_pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CLoopbackADC, float> >(pADC, &CLoopbackADC::GetVal) );
+        std::sprintf(cmd, "ADC%d.rms", nInd);
+        m_pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CLoopbackADC, float> >(pADC, &CLoopbackADC::GetRMS) );
+        std::sprintf(cmd, "ADC%d.peak", nInd);
+        m_pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CLoopbackADC, float> >(pADC, &CLoopbackADC::GetPeak) );
+
+        std::sprintf(cmd, "DAC%d.raw", nInd);
+        m_pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CLoopbackDAC, int> >(pDAC, &CLoopbackDAC::GetRawBinVal, &CLoopbackDAC::SetRawOutput) );
+    }
+    m_pDisp->Add("ADC.win", std::make_shared< CCmdSGHandlerF<unsigned int> >(&CLoopbackADC::GetWindow, &CLoopbackADC::SetWindow) );
+    CBootTiming::Mark(CBootTiming::board);
+
+    //PWMs:
+    for(int i=0; i<2; i++)
+    {
+        char cmd[64];
+        int nInd=i+1;
+        auto &pPWM=m_pPWM[i];
+        pPWM=std::make_shared<CLoopbackPWM>();
+
+        std::sprintf(cmd, "PWM%d", nInd);
+        m_pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CLoopbackPWM, bool> >(pPWM, &CLoopbackPWM::IsStarted, &CLoopbackPWM::Start) );
+        std::sprintf(cmd, "PWM%d.repeats", nInd);
+        m_pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CLoopbackPWM, unsigned int> >(pPWM, &CLoopbackPWM::GetRepeats, &CLoopbackPWM::SetRepeats) );
+        std::sprintf(cmd, "PWM%d.duty", nInd);
+        m_pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CLoopbackPWM, float> >(pPWM, &CLoopbackPWM::GetDutyCycle, &CLoopbackPWM::SetDutyCycle) );
+        std::sprintf(cmd, "PWM%d.freq", nInd);
+        m_pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CLoopbackPWM, unsigned int> >(pPWM, &CLoopbackPWM::GetFrequency, &CLoopbackPWM::SetFrequency) );
+        std::sprintf(cmd, "PWM%d.high", nInd);
+        m_pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CLoopbackPWM, int> >(pPWM, &CLoopbackPWM::GetHighLevel, &CLoopbackPWM::SetHighLevel) );
+        std::sprintf(cmd, "PWM%d.low", nInd);
+        m_pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CLoopbackPWM, int> >(pPWM, &CLoopbackPWM::GetLowLevel, &CLoopbackPWM::SetLowLevel) );
+    }
+    CBootTiming::Mark(CBootTiming::periph);
+
+    //control commands:
+    m_pDisp->Add("Gain", std::make_shared< CCmdSGHandler<CLoopbackNode, int> >(pNC, &CLoopbackNode::GetGain, &CLoopbackNode::SetGain) );
+    m_pDisp->Add("Bridge", std::make_shared< CCmdSGHandler<CLoopbackNode, bool> >(pNC, &CLoopbackNode::GetBridge, &CLoopbackNode::SetBridge) );
+    m_pDisp->Add("Record", std::make_shared< CCmdSGHandler<CLoopbackNode, bool> >(pNC, &CLoopbackNode::IsRecordStarted, &CLoopbackNode::StartRecord) );
+    m_pDisp->Add("Offset", std::make_shared< CCmdSGHandler<CLoopbackNode, int> >(pNC, &CLoopbackNode::GetOffsetRunSt, &CLoopbackNode::SetOffset) );
+    m_pDisp->Add("EnableADmes", std::make_shared< CCmdSGHandler<CLoopbackNode, bool> >(pNC, &CLoopbackNode::IsMeasurementsEnabled, &CLoopbackNode::EnableMeasurements) );
+    m_pDisp->Add("Mode", std::make_shared< CCmdSGHandler<CLoopbackNode, int> >(pNC, &CLoopbackNode::GetMode, &CLoopbackNode::SetMode) );
+    m_pDisp->Add("CalStatus", std::make_shared< CCmdSGHandler<CLoopbackNode, bool> >(pNC, &CLoopbackNode::GetCalStatus) );
+    m_pDisp->Add("Voltage", std::make_shared< CCmdSGHandler<CLoopbackNode, float> >(pNC, &CLoopbackNode::GetVoltage, &CLoopbackNode::SetVoltage) );
+    m_pDisp->Add("Current", std::make_shared< CCmdSGHandler<CLoopbackNode, float> >(pNC, &CLoopbackNode::GetCurrent, &CLoopbackNode::SetCurrent) );
+    m_pDisp->Add("MaxCurrent", std::make_shared< CCmdSGHandler<CLoopbackNode, float> >(pNC, &CLoopbackNode::GetMaxCurrent, &CLoopbackNode::SetMaxCurrent) );
+    m_pDisp->Add("Fan", std::make_shared< CCmdSGHandler<CLoopbackNode, bool> >(pNC, &CLoopbackNode::IsFanStarted, &CLoopbackNode::StartFan) );
+
+    //board health snapshot:
+    m_pSnap=std::make_shared<CLoopbackSnapshot>(*this);
+    m_pDisp->Add("Snap", std::make_shared< CCmdSGHandler<CLoopbackSnapshot, std::string> >(m_pSnap, &CLoopbackSnapshot::GetSnapshot) );
+    m_pDisp->Add("Snap.period", std::make_shared< CCmdSGHandler<CLoopbackSnapshot, unsigned int> >(m_pSnap, &CLoopbackSnapshot::GetPeriod, &CLoopbackSnapshot::SetPeriod) );
+
+    //boot timing:
+    m_pDisp->Add("Boot.eeprom", std::make_shared< CCmdSGHandlerF<unsigned int> >(&CBootTiming::Get<CBootTiming::eeprom>) );
+    m_pDisp->Add("Boot.comm", std::make_shared< CCmdSGHandlerF<unsigned int> >(&CBootTiming::Get<CBootTiming::comm>) );
+    m_pDisp->Add("Boot.board", std::make_shared< CCmdSGHandlerF<unsigned int> >(&CBootTiming::Get<CBootTiming::board>) );
+    m_pDisp->Add("Boot.periph", std::make_shared< CCmdSGHandlerF<unsigned int> >(&CBootTiming::Get<CBootTiming::periph>) );
+    m_pDisp->Add("Boot.cmd", std::make_shared< CCmdSGHandlerF<unsigned int> >(&CBootTiming::Get<CBootTiming::commands>) );
+    m_pDisp->Add("Boot.settings", std::make_shared< CCmdSGHandlerF<unsigned int> >(&CBootTiming::Get<CBootTiming::settings>) );
+    m_pDisp->Add("Boot.total", std::make_shared< CCmdSGHandlerF<unsigned int> >(&CBootTiming::Get<CBootTiming::total>) );
+    m_pDisp->Add("Boot.ordered", std::make_shared< CCmdSGHandlerF<bool> >(&CBootTiming::IsOrdered) );
+
+    //--------------------JSON- ---------------------
+    m_pDisp->Add("js", std::make_shared<CJSONDispatcher>(m_pDisp));
+
+    //------------------JSON EVENTS-------------------
+    m_pJE=std::make_shared<CJSONEvDispatcher>(m_pDisp);
+    m_pDisp->Add("je", m_pJE);
+    m_pNode->AdviseSink(m_pJE);
+    CBootTiming::Mark(CBootTiming::commands);
+
+    //the loopback board has no stored settings to apply:
+    CBootTiming::Mark(CBootTiming::settings);
+    CBootTiming::Mark(CBootTiming::total);
+    m_LastConv_mS=os::get_tick_mS();
+}
+
+void CLoopbackBoard::select()
+{
+    m_recFIFO.reset();
+    m_TxFIFO.reset();
+    m_ComCntr.start(CSyncSerComFSM::FSM::recLengthMSB);
+}
+
+typeSChar CLoopbackBoard::transfer(typeSChar ch)
+{
+    typeSChar out=0;
+    if(m_TxFIFO.in_avail())
+    {
+        //the bus carries bytes: the FIFO char must not be sign-extended (a length LSB >=0x80 would cut the message)
+        m_TxFIFO>>out;
+        out&=0xff;
+    }
+
+    m_ComCntr.proc(ch, m_recFIFO);
+    return out;
+}
+
+void CLoopbackBoard::Update()
+{
+    //the monitor ADCs convert at their polling rate, at most a second of the conversions is caught up:
+    unsigned long CurTime=os::get_tick_mS();
+    unsigned long nConv=static_cast<unsigned long>((CurTime-m_LastConv_mS)*CLoopbackADC::m_PollingRate/1000);
+    if(nConv)
+    {
+        m_LastConv_mS=CurTime;
+        if(nConv>CLoopbackADC::m_PollingRate)
+            nConv=static_cast<unsigned long>(CLoopbackADC::m_PollingRate);
+        for(auto &pADC : m_pADC)
+            pADC->Convert(nConv);
+    }
+    m_pSnap->Update();
+
+    if(m_ComCntr.get_state()!=CSyncSerComFSM::FSM::recOK)
+        return;
+
+    m_ComCntr.start(CSyncSerComFSM::FSM::halted);
+    while(m_recFIFO.in_avail())
+    {
+        typeSChar ch;
+        m_recFIFO>>ch;
+        Fire_on_rec_char(ch);
+    }
+}
+
+bool CLoopbackBoard::send(CFIFO &msg)
+{
+    typeSChar ch;
+    CSyncSerComFSM cntr;
+    cntr.start(CSyncSerComFSM::FSM::sendSilenceFrame);
+    while(cntr.proc(ch, msg))
+    {
+        m_TxFIFO<<ch;
+    }
+    return true;
+}
@@ -0,0 +1,307 @@
+/*
+This Source Code Form is subject to the terms of the GNU General Public License v3.0.
+If a copy of the GPL was not distributed with this
+file, You can obtain one at https://www.gnu.org/licenses/gpl-3.0.html
+Copyright (c) 2019-2020 Panda Team
+*/
+
+/*!
+*   \file
+*   \brief A definition file for the in-process loopback board:
+*   CLoopbackNode, CLoopbackPWM, CLoopbackADC, CLoopbackDAC, CLoopbackSnapshot, CLoopbackBoard
+*/
+
+#pragma once
+
+#include <memory>
+#include "Serial.h"
+#include "SyncCom.h"
+#include "cmd.h"
+#include "std_port.h"
+#include "jsondisp.h"
+#include "json_evsys.h"
+#include "sigcond.h"
+#include "BoardSnapshot.h"
+
+/*!
+ * \brief A host model of the board control state (a stand-in for the firmware nodeControl)
+ * \details Holds the values of the board-level access points and fires the same JSON events as the firmware does.
+ *  The offset search is completed immediately.
+ */
+class CLoopbackNode : public CJSONEvCP
+{
+protected:
+    int     m_nMode=0;
+    int     m_nGain=1;
+    int     m_nOffset=0;
+    bool    m_bBridge=false;
+    bool    m_bRecord=false;
+    bool    m_bMesEnabled=false;
+    bool    m_bDACon=false;
+    bool    m_bFan=false;
+    float   m_Voltage=0;
+    float   m_Current=0;
+    float   m_MaxCurrent=1000.0f;
+    int     m_AOUT[2]={2048, 2048};
+
+    /*!
+     * \brief Fires an integer JSON event
+     */
+    void Fire(const char *key, int val)
+    {
+        nlohmann::json v=val;
+        Fire_on_event(key, v);
+    }
+
+public:
+    int  GetMode(){ return m_nMode; }
+    void SetMode(int nMode){ m_nMode=nMode; Fire("Mode", nMode); }
+    int  GetGain(){ return m_nGain; }
+    void SetGain(int nGain){ m_nGain=nGain; Fire("Gain", nGain); }
+    bool GetBridge(){ return m_bBridge; }
+    void SetBridge(bool how){ m_bBridge=how; Fire("Bridge", how); }
+    bool IsRecordStarted(){ return m_bRecord; }
+    void StartRecord(bool how){ m_bRecord=how; Fire("Record", how); }
+    int  GetOffsetRunSt(){ return 0; }
+    void SetOffset(int nOffs){ m_nOffset=nOffs; Fire("Offset", nOffs); }
+    bool GetCalStatus(){ return true; }
+    bool IsMeasurementsEnabled(){ return m_bMesEnabled; }
+    void EnableMeasurements(bool how){ m_bMesEnabled=how; }
+    bool IsDACon(){ return m_bDACon; }
+    void SetDACon(bool how){ m_bDACon=how; }
+    bool IsFanStarted(){ return m_bFan; }
+    void StartFan(bool how){ m_bFan=how; }
+    float GetVoltage(){ return m_Voltage; }
+    void  SetVoltage(float val){ m_Voltage=val; }
+    float GetCurrent(){ return m_Current; }
+    void  SetCurrent(float val){ m_Current=val; }
+    float GetMaxCurrent(){ return m_MaxCurrent; }
+    void  SetMaxCurrent(float val){ m_MaxCurrent=val; }
+    int  GetAOUT3(){ return m_AOUT[0]; }
+    void SetAOUT3(int val){ m_AOUT[0]=val; }
+    int  GetAOUT4(){ return m_AOUT[1]; }
+    void SetAOUT4(int val){ m_AOUT[1]=val; }
+};
+
+/*!
+ * \brief A host model of the DAC PWM generator (a stand-in for the firmware CDacPWMht)
+ */
+class CLoopbackPWM
+{
+protected:
+    bool            m_bStarted=false;
+    unsigned int    m_nRepeats=0;
+    float           m_Duty=0.5f;
+    unsigned int    m_nFreq=1;
+    int             m_nHigh=4095;
+    int             m_nLow=0;
+
+public:
+    bool IsStarted(){ return m_bStarted; }
+    void Start(bool how){ m_bStarted=how; }
+    unsigned int GetRepeats(){ return m_nRepeats; }
+    void SetRepeats(unsigned int val){ m_nRepeats=val; }
+    float GetDutyCycle(){ return m_Duty; }
+    void  SetDutyCycle(float val){ m_Duty=val; }
+    unsigned int GetFrequency(){ return m_nFreq; }
+    void SetFrequency(unsigned int val){ m_nFreq=val; }
+    int  GetHighLevel(){ return m_nHigh; }
+    void SetHighLevel(int val){ m_nHigh=val; }
+    int  GetLowLevel(){ return m_nLow; }
+    void SetLowLevel(int val){ m_nLow=val; }
+};
+
+/*!
+ * \brief A host model of a monitor ADC channel with its signal conditioning (a stand-in for the firmware
+ *  CSamADCchan and CSigCondChan)
+ * \details The channel converts a constant level at the fixed polling rate. The conversion profile is fitted
+ *  the same way the firmware does it, the level is conditioned by the firmware CSigCond kernel
+ */
+class CLoopbackADC
+{
+protected:
+    static unsigned int m_nWindow;
+
+    int             m_nRaw;
+    unsigned int    m_nSampleNum=0;
+    unsigned int    m_nPrescaler=0;
+    unsigned int    m_nSampleLen=0;
+    CSigCond        m_Cond;
+
+public:
+    /*!
+     * \brief The conversion rate of the model, Hz
+     */
+    static constexpr float m_PollingRate=1000.0f;
+
+    /*!
+     * \brief The class constructor
+     * \param nRaw The converted level in the raw-binary format
+     */
+    CLoopbackADC(int nRaw) : m_nRaw(nRaw){ m_Cond.SetSampleRate(m_PollingRate); }
+
+    int  DirectMeasure(){ return m_nRaw; }
+    unsigned int GetAvgSamples(){ return 1<<m_nSampleNum; }
+    void SetAvgSamples(unsigned int nSamples);
+    unsigned int GetPrescaler(){ return 2<<m_nPrescaler; }
+    void SetPrescaler(unsigned int nDiv);
+    unsigned int GetSampleLen(){ return m_nSampleLen+1; }
+    void SetSampleLen(unsigned int nCycles);
+
+    float GetCutoff(){ return m_Cond.GetCutoff(); }
+    void  SetCutoff(float Fc_Hz){ m_Cond.SetCutoff(Fc_Hz); }
+    float GetVal(){ return m_Cond.GetVal(); }
+    float GetRMS(){ return m_Cond.GetRMS(); }
+    float GetPeak(){ return m_Cond.GetPeak(); }
+
+    static unsigned int GetWindow(){ return m_nWindow; }
+    static void SetWindow(unsigned int nWindow);
+
+    /*!
+     * \brief Converts and conditions a number of samples
+     * \param nSamples The number of samples
+     */
+    void Convert(unsigned int nSamples);
+};
+
+/*!
+ * \brief A host model of an offset DAC channel (a stand-in for the firmware CDac)
+ */
+class CLoopbackDAC
+{
+protected:
+    int m_nRaw=2048;
+
+public:
+    int  GetRawBinVal(){ return m_nRaw; }
+    void SetRawOutput(int val){ m_nRaw=val<0 ? 0:(val>4095 ? 4095:val); }
+};
+
+class CLoopbackBoard;
+
+/*!
+ * \brief A host model of the board health snapshot (a stand-in for the firmware CBoardSnapshot)
+ * \details Builds the CBoardSnapshot record from the loopback models and encodes it the same way the firmware does
+ */
+class CLoopbackSnapshot
+{
+protected:
+    CBoardSnapshot::record m_Record={};
+    unsigned int    m_Period_mS=100;
+    unsigned long   m_LastSnap_mS=0;
+    CLoopbackBoard  &m_Board;
+
+    void Snap();
+
+public:
+    /*!
+     * \brief The class constructor
+     * \param Board The board the record is built from
+     */
+    CLoopbackSnapshot(CLoopbackBoard &Board) : m_Board(Board){}
+
+    std::string GetSnapshot();
+    unsigned int GetPeriod(){ return m_Period_mS; }
+    void SetPeriod(unsigned int nPeriod_mS);
+
+    /*!
+     * \brief Rebuilds the record when the snapshot period is elapsed
+     */
+    void Update();
+};
+
+/*!
+ * \brief The in-process loopback board: the host-compiled firmware command stack behind a byte-level SPI slave
+ * \details The board runs the real firmware protocol chain: CSyncSerComFSM flow control -> CStdPort -> CCmdDispatcher
+ *  with the "js" (CJSONDispatcher) and "je" (CJSONEvDispatcher) handlers. The hardware-bound access points are served by
+ *  CLoopbackNode, CLoopbackPWM, CLoopbackADC, CLoopbackDAC and CLoopbackSnapshot models, the boot timing by the firmware
+ *  CBootTiming. The setpoint sequencer ("Seq" access points) is not served: the firmware CSetpointSeq runs its steps
+ *  from the CSamTC timer interrupt that has no host counterpart.
+ *  The master clocks the board byte by byte with transfer(), just like a real SPI bus does: the byte returned by a transfer is
+ *  the one the board has queued before it. Received requests are processed in Update() that plays the role of the firmware
+ *  "super loop" pass
+ */
+class CLoopbackBoard : public CSerial
+{
+friend class CLoopbackSnapshot;
+
+protected:
+
+    /*!
+     * \brief The slave side flow control (the same as in the firmware CSPIcomm)
+     */
+    CSyncSerComFSM m_ComCntr;
+
+    /*!
+     * \brief The received request message
+     */
+    CFIFO m_recFIFO;
+
+    /*!
+     * \brief The bytes queued to be shifted out to the master
+     */
+    CFIFO m_TxFIFO;
+
+    std::shared_ptr<CCmdDispatcher>     m_pDisp;
+    std::shared_ptr<CStdPort>           m_pStdPort;
+    std::shared_ptr<CJSONEvDispatcher>  m_pJE;
+    std::shared_ptr<CLoopbackNode>      m_pNode;
+    std::shared_ptr<CLoopbackPWM>       m_pPWM[2];
+    std::shared_ptr<CLoopbackADC>       m_pADC[CBoardSnapshot::nADC];
+    std::shared_ptr<CLoopbackDAC>       m_pDAC[CBoardSnapshot::nDAC];
+    std::shared_ptr<CLoopbackSnapshot>  m_pSnap;
+
+    /*!
+     * \brief The time stamp of the last monitor ADC conversions, milliseconds
+     */
+    unsigned long m_LastConv_mS=0;
+
+    /*!
+     * \brief The class constructor. Use Factory() to create the board
+     */
+    CLoopbackBoard();
+
+    /*!
+     * \brief Creates the command stack and registers all access points
+     * \param pThis A shared pointer to this object used as the port bus
+     */
+    void Init(const std::shared_ptr<CLoopbackBoard> &pThis);
+
+public:
+
+    /*!
+     * \brief Creates a new loopback board
+     * \return A pointer to the created board
+     */
+    static std::shared_ptr<CLoopbackBoard> Factory();
+
+    /*!
+     * \brief Starts a new transaction (chip select falls)
+     */
+    void select();
+
+    /*!
+     * \brief Performs a single byte full-duplex transfer
+     * \param ch A byte sent by the master
+     * \return A byte sent by the board
+     */
+    typeSChar transfer(typeSChar ch);
+
+    /*!
+     * \brief Runs the monitor conversions and the snapshot, then processes a completely received request (if any)
+     */
+    void Update();
+
+    /*!
+     * \brief Queues a response message to be fetched by the master
+     * \param msg The message to send
+     * \return true
+     */
+    virtual bool send(CFIFO &msg);
+
+    /*!
+     * \brief Not used
+     * \return false
+     */
+    virtual bool receive(CFIFO &msg){ return false; }
+};
@@ -0,0 +1,52 @@
+/*
+This Source Code Form is subject to the terms of the GNU General Public License v3.0.
+If a copy of the GPL was not distributed with this
+file, You can obtain one at https://www.gnu.org/licenses/gpl-3.0.html
+Copyright (c) 2019-2020 Panda Team
+*/
+
+//the host implementation of the firmware operating system interface for the loopback board:
+
+#include <chrono>
+#include <thread>
+#include "os.h"
+
+namespace os{
+
+static const auto start_time=std::chrono::steady_clock::now();
+
+unsigned long get_tick_mS(void)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()-start_time).count();
+}
+
+//the host "cycle" is one nanosecond:
+unsigned long get_cycles(void)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-start_time).count();
+}
+
+unsigned long cycles_to_uS(unsigned long cycles)
+{
+    return cycles/1000;
+}
+
+void wait(unsigned long time_mS)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(time_mS));
+}
+
+void uwait(unsigned long time_uS)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(time_uS));
+}
+
+void set_err(const char *perrtxt)
+{
+}
+
+void clear_err()
+{
+}
+
+}
@@ -0,0 +1,48 @@
+/*
+This Source Code Form is subject to the terms of the GNU General Public License v3.0.
+If a copy of the GPL was not distributed with this
+file, You can obtain one at https://www.gnu.org/licenses/gpl-3.0.html
+Copyright (c) 2019-2020 Panda Team
+*/
+
+#include "loopback_spi.h"
+
+CLoopbackSPI::CLoopbackSPI()
+{
+    m_pBoard=CLoopbackBoard::Factory();
+}
+
+bool CLoopbackSPI::send(CFIFO &msg)
+{
+    m_pBoard->select();
+    m_recFIFO.reset();
+
+    //flow control:
+    typeSChar ch=0;
+    m_ComCntr.start(CSyncSerComFSM::FSM::sendLengthMSB);
+    while(m_ComCntr.proc(ch, msg))
+    {
+        m_pBoard->transfer(ch);
+    }
+    if(m_ComCntr.bad()) return false;
+
+    m_pBoard->transfer(0); //provide add clock...
+
+    //the board "super loop" pass:
+    m_pBoard->Update();
+
+    m_ComCntr.start(CSyncSerComFSM::FSM::recSilenceFrame);
+    do
+    {
+        ch=m_pBoard->transfer(0); //provide a clock
+    }
+    while(m_ComCntr.proc(ch, m_recFIFO));
+
+    return true;
+}
+
+bool CLoopbackSPI::receive(CFIFO &msg)
+{
+    msg=m_recFIFO;
+    return (m_ComCntr.get_state()==CSyncSerComFSM::FSM::recOK);
+}
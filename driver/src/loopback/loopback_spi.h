@@ -0,0 +1,55 @@
+/*
+This Source Code Form is subject to the terms of the GNU General Public License v3.0.
+If a copy of the GPL was not distributed with this
+file, You can obtain one at https://www.gnu.org/licenses/gpl-3.0.html
+Copyright (c) 2019-2020 Panda Team
+*/
+
+/*!
+*   \file
+*   \brief A definition file for
+*   CLoopbackSPI
+*/
+
+#pragma once
+
+#include <memory>
+#include "SPI.h"
+#include "SyncCom.h"
+#include "loopback_board.h"
+
+/*!
+ * \brief The loopback transport: a drop-in replacement of CBcmSPI that talks to an in-process CLoopbackBoard
+ * \details The master side runs exactly the same flow-control sequence as CBcmSPI does on the real bus,
+ *  thus the whole control protocol path (framing, text port, command dispatcher, JSON settings and events)
+ *  can be exercised and benchmarked on a host without the board
+ */
+class CLoopbackSPI : public CSPI
+{
+protected:
+
+    /*!
+     * \brief The board on the other side of the loopback channel
+     */
+    std::shared_ptr<CLoopbackBoard> m_pBoard;
+
+    /*!
+     * \brief The last received message
+     */
+    CFIFO m_recFIFO;
+
+public:
+    CSyncSerComFSM m_ComCntr;
+
+public:
+    CLoopbackSPI();
+
+    bool is_initialzed(){ return true; }
+
+    virtual bool send(CFIFO &msg);
+    virtual bool receive(CFIFO &msg);
+
+    virtual void set_phpol(bool bPhase, bool bPol){}
+    virtual void set_baud_div(unsigned char div){}
+    virtual void set_tprofile_divs(unsigned char CSminDel, unsigned char IntertransDel, unsigned char BeforeClockDel){}
+};
@@ -1,7 +1,12 @@
 #include "reader.hpp"
 #include "defs.h"
+#include "timeswipe_calibration.hpp"
+#include "timeswipe_kernels.hpp"
+#include "timeswipe_resource.hpp"
 #if NOT_RPI
 #include <math.h>
+#include <cstdlib>
+#include <random>
 #endif
 
 struct GPIOData
@@ -22,15 +27,7 @@ GPIOData readByteAndStatusFromGPIO()
     sleep55ns();
 
     unsigned int allGPIO = readAllGPIO();
-    uint8_t byte =
-        ((allGPIO & DATA_POSITION[0]) >> 17) |  // Bit 7
-        ((allGPIO & DATA_POSITION[1]) >> 19) |  //     6
-        ((allGPIO & DATA_POSITION[2]) >> 2) |  //     5
-        ((allGPIO & DATA_POSITION[3]) >> 1) |  //     4
-        ((allGPIO & DATA_POSITION[4]) >> 3) |  //     3
-        ((allGPIO & DATA_POSITION[5]) >> 10) | //     2
-        ((allGPIO & DATA_POSITION[6]) >> 12) | //     1
-        ((allGPIO & DATA_POSITION[7]) >> 16);  //     0
+    uint8_t byte = gatherDataByte(allGPIO);
 
     sleep55ns();
     sleep55ns();
@@ -63,54 +60,100 @@ const size_t BLOCKS_PER_CHUNK = 8;
 const size_t CHUNK_SIZE_IN_BYTE = BLOCKS_PER_CHUNK;
 const size_t TCO_SIZE = 256;
 
-constexpr void setBit(uint16_t &word, uint8_t N, bool bit)
+// the chunk as a big-endian word: byte 0 is the most significant one
+inline uint64_t chunkToWord(const std::array<uint8_t, CHUNK_SIZE_IN_BYTE> &chunk)
 {
-    word = (word & ~(1UL << N)) | (bit << N);
+    uint64_t word = 0;
+    for (size_t i = 0; i < CHUNK_SIZE_IN_BYTE; ++i)
+        word = (word << 8) | chunk[i];
+    return word;
 }
 
-constexpr bool getBit(uint8_t byte, uint8_t N)
+// gathers the 16 bits of the sensor n from the chunk word (see the chunk-Layout above)
+// with a fixed sequence of masks and shifts instead of a per-bit loop
+constexpr uint16_t extractSensor(uint64_t word, size_t n)
 {
-    return (byte & (1UL << N));
+    constexpr uint64_t LSB_OF_BYTES = 0x0101010101010101ULL;
+
+    // every byte holds 2 bits of the sensor: bit 3-n is the higher one, bit 7-n is the lower one
+    uint64_t pairs = (((word >> (3 - n)) & LSB_OF_BYTES) << 1) | ((word >> (7 - n)) & LSB_OF_BYTES);
+
+    // pack the 2-bit pairs of the 8 bytes together, byte 0 goes to the MSBs
+    pairs = (pairs | (pairs >> 6)) & 0x000f000f000f000fULL;
+    pairs = (pairs | (pairs >> 12)) & 0x000000ff000000ffULL;
+    pairs = (pairs | (pairs >> 24)) & 0xffffULL;
+    return static_cast<uint16_t>(pairs);
 }
 
-template <class T>
-void convertChunkToRecord(const std::array<uint8_t, CHUNK_SIZE_IN_BYTE> &chunk, const std::array<int, 4> &offset, const std::array<float, 4> &mfactor, T& data)
+static_assert(extractSensor(0x0800000000000000ULL, 0) == 0x8000 && extractSensor(0x0000000000000010ULL, 3) == 0x0001,
+              "the chunk layout is broken");
+
+using SensorsLUT = std::array<std::shared_ptr<const TimeSwipeCalibration::Table>, 4>;
+
+// channel mask: bit N set = sensor N+1 is decoded
+const uint8_t ALL_CHANNELS_MASK = 0x0f;
+
+// raw ADC codes of the sensors, scaled in a batch by scaleRecords
+using SensorsRaw = std::array<std::vector<uint16_t>, 4>;
+
+void convertChunkToRecord(const std::array<uint8_t, CHUNK_SIZE_IN_BYTE> &chunk, uint8_t mask, SensorsRaw& raw)
 {
-    size_t count = 0;
-    std::vector<uint16_t> sensors(4, 0);
-    static std::vector<uint16_t> sensorOld(4, 32768);
+    static std::array<uint16_t, 4> sensorOld = {32768, 32768, 32768, 32768};
+    const uint64_t word = chunkToWord(chunk);
 
-    for (size_t i = 0; i < CHUNK_SIZE_IN_BYTE; ++i)
+    for (size_t n = 0; n < 4; ++n)
     {
-        setBit(sensors[0], 15 - count, getBit(chunk[i], 3));
-        setBit(sensors[1], 15 - count, getBit(chunk[i], 2));
-        setBit(sensors[2], 15 - count, getBit(chunk[i], 1));
-        setBit(sensors[3], 15 - count, getBit(chunk[i], 0));
-        count++;
-
-        setBit(sensors[0], 15 - count, getBit(chunk[i], 7));
-        setBit(sensors[1], 15 - count, getBit(chunk[i], 6));
-        setBit(sensors[2], 15 - count, getBit(chunk[i], 5));
-        setBit(sensors[3], 15 - count, getBit(chunk[i], 4));
-        count++;
-    }
+        // disabled channels are neither extracted nor stored
+        if (!(mask & (1 << n))) continue;
+
+        uint16_t sensor = extractSensor(word, n);
 
-    for (size_t i = 0; i < 4; ++i)
-    {
         //##########################//
         //TBD: Dirty fix for clippings
         //##########################//
-        if (sensors[i] % 64 == 7 || sensors[i] % 64 == 56)
+        if (sensor % 64 == 7 || sensor % 64 == 56)
         {
-            sensors[i] = sensorOld[i];
+            sensor = sensorOld[n];
         }
-        sensorOld[i] = sensors[i];
+        sensorOld[n] = sensor;
         //##########################//
 
-        data[i].push_back((float)(sensors[i] - offset[i]) * mfactor[i]);
+        raw[n].push_back(sensor);
     }
 }
 
+template <class T>
+void scaleRecords(const SensorsRaw& raw, const std::array<int, 4> &offset, const std::array<float, 4> &mfactor, const SensorsLUT &lut, T& data)
+{
+    const auto& kernels = TimeSwipeKernels::Get();
+    for (size_t n = 0; n < raw.size(); ++n)
+    {
+        const auto count = raw[n].size();
+        if (!count) continue;
+
+        auto& out = data[n];
+        const auto pos = out.size();
+        out.resize(pos + count);
+        // a calibration table replaces the linear scaling
+        if (lut[n])
+        {
+            for (size_t i = 0; i < count; ++i)
+                out[pos + i] = (*lut[n])[raw[n][i]];
+        }
+        else
+            kernels.scale(raw[n].data(), count, offset[n], mfactor[n], out.data() + pos);
+    }
+}
+
+// the decoder scaling: (raw - offset) * gain * transmission or a calibration table
+struct SensorsScaling
+{
+    std::array<int, 4> offset = {0, 0, 0, 0};
+    std::array<float, 4> gain = {1.0, 1.0, 1.0, 1.0};
+    std::array<float, 4> transmission = {1.0, 1.0, 1.0, 1.0};
+    SensorsLUT lut;
+};
+
 struct RecordReader
 {
     std::array<uint8_t, CHUNK_SIZE_IN_BYTE> currentChunk;
@@ -119,16 +162,22 @@ struct RecordReader
     size_t lastRead = 0;
 
     int mode = 0;
-    std::array<int, 4> offset = {0, 0, 0, 0};
-    std::array<float, 4> gain = {1.0, 1.0, 1.0, 1.0};
-    std::array<float, 4> transmission = {1.0, 1.0, 1.0, 1.0};
+    SensorsScaling scaling;
     std::array<float, 4> mfactor;
+    uint8_t channelMask = ALL_CHANNELS_MASK;
+    SensorsRaw raw;
+    MemoryResource memoryResource = defaultMemoryResource();
 
 #if NOT_RPI
     std::chrono::steady_clock::time_point emulPointBegin;
     std::chrono::steady_clock::time_point emulPointEnd;
     uint64_t emulSent = 0;
     static constexpr size_t emulRate = 48000;
+    // the emulated board clock error and the read delay jitter:
+    // TIMESWIPE_EMUL_PPM and TIMESWIPE_EMUL_JITTER_US environment variables
+    double emulPpm = 0;
+    double emulJitterUs = 0;
+    std::minstd_rand emulRandom;
 #endif
 
     // read records from hardware buffer
@@ -137,7 +186,7 @@ struct RecordReader
 #if NOT_RPI
         return readEmulated();
 #endif
-        SensorsData out;
+        SensorsData out = makeSensorsData(memoryResource);
         out.reserve(lastRead*2);
         int lastTCO;
         int currentTCO;
@@ -161,7 +210,7 @@ struct RecordReader
 
             if (bytesRead == CHUNK_SIZE_IN_BYTE)
             {
-                convertChunkToRecord(currentChunk, offset, mfactor, out.data());
+                convertChunkToRecord(currentChunk, channelMask, raw);
                 bytesRead = 0;
             }
 
@@ -173,10 +222,10 @@ struct RecordReader
 
         // discard first read - thats any old data in RAM!
         if (isFirst)
-        {
             isFirst = false;
-            out.clear();
-        }
+        else
+            scaleRecords(raw, scaling.offset, mfactor, scaling.lut, out.data());
+        for (auto& r : raw) r.clear();
 
         // III.
         sleep55ns();
@@ -200,15 +249,22 @@ struct RecordReader
         setup_io();
     }
 
-    void start()
+    void updateScaling()
     {
         for (size_t i = 0; i < mfactor.size(); i++)
         {
-            mfactor[i] = gain[i] * transmission[i];
+            mfactor[i] = scaling.gain[i] * scaling.transmission[i];
         }
+    }
+
+    void start()
+    {
+        updateScaling();
 #if NOT_RPI
         emulPointBegin = std::chrono::steady_clock::now();
         emulSent = 0;
+        emulPpm = getenv("TIMESWIPE_EMUL_PPM") ? atof(getenv("TIMESWIPE_EMUL_PPM")) : 0;
+        emulJitterUs = getenv("TIMESWIPE_EMUL_JITTER_US") ? atof(getenv("TIMESWIPE_EMUL_JITTER_US")) : 0;
         return;
 #endif
         init(mode);
@@ -226,26 +282,30 @@ struct RecordReader
     double angle = 0.0;
     SensorsData readEmulated()
     {
-        SensorsData out;
-        auto& data = out.data();
+        SensorsData out = makeSensorsData(memoryResource);
         while (true) {
             emulPointEnd = std::chrono::steady_clock::now();
             uint64_t diff_us = std::chrono::duration_cast<std::chrono::microseconds>(emulPointEnd - emulPointBegin).count();
-            uint64_t wouldSent = diff_us * emulRate / 1000 / 1000;
+            uint64_t wouldSent = diff_us * (emulRate * (1 + emulPpm * 1e-6)) / 1000 / 1000;
             if (wouldSent > emulSent) {
-                while (emulSent++ < wouldSent) {
+                for (; emulSent < wouldSent; emulSent++) {
                     static constexpr int NB_OF_SAMPLES = emulRate;
                     auto val = int(3276 * sin(angle) + 32767);
                     angle += (2.0 * M_PI) / NB_OF_SAMPLES;
-                    data[0].push_back(val);
-                    data[1].push_back(val);
-                    data[2].push_back(val);
-                    data[3].push_back(val);
+                    for (size_t i = 0; i < raw.size(); i++) {
+                        if (channelMask & (1 << i)) raw[i].push_back(val);
+                    }
                 }
                 break;
             }
             std::this_thread::sleep_for(std::chrono::milliseconds(2));
         }
+        if (emulJitterUs > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(uint64_t(std::uniform_real_distribution<double>(0, emulJitterUs)(emulRandom))));
+        }
+        // the emulated codes go through the same scaling as the real ones
+        scaleRecords(raw, scaling.offset, mfactor, scaling.lut, out.data());
+        for (auto& r : raw) r.clear();
         return out;
     }
 #endif
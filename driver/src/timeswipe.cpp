@@ -5,26 +5,71 @@
 #include <boost/lockfree/spsc_queue.hpp>
 #include <iostream>
 #include <list>
+#include <algorithm>
 #include <stdexcept>
 #include "timeswipe.hpp"
 #include "reader.hpp"
 #include "timeswipe_eeprom.hpp"
 #include "timeswipe_resampler.hpp"
+#include "timeswipe_calibration.hpp"
+#include "timeswipe_kernels.hpp"
+#include "timeswipe_markers.hpp"
+#include "timeswipe_degradation.hpp"
+#include "timeswipe_control.hpp"
+#include "timeswipe_latency.hpp"
+#include "timeswipe_compression.hpp"
+#include "timeswipe_clock.hpp"
 #include "pidfile.hpp"
 #include "defs.h"
 
 bool TimeSwipe::resample_log = false;
 
-std::vector<float>& SensorsData::operator[](size_t num) {
+#ifdef TIMESWIPE_PMR
+SensorsData::SensorsData(std::pmr::memory_resource* resource)
+    : _data{VECTOR(resource), VECTOR(resource), VECTOR(resource), VECTOR(resource)} {
+}
+
+SensorsData::SensorsData(const SensorsData& other)
+    : SensorsData(other._data[0].get_allocator().resource()) {
+    _data = other._data;
+    _markers = other._markers;
+}
+
+std::pmr::memory_resource* SensorsData::resource() const {
+    return _data[0].get_allocator().resource();
+}
+#else
+SensorsData::SensorsData(const SensorsData& other)
+    : _data(other._data)
+    , _markers(other._markers) {
+}
+#endif
+
+SensorsData::VECTOR& SensorsData::operator[](size_t num) {
     return _data[num];
 }
 
-size_t SensorsData::SensorsSize() {
+const SensorsData::VECTOR& SensorsData::operator[](size_t num) const {
+    return _data[num];
+}
+
+size_t SensorsData::SensorsSize() const {
     return SENSORS;
 }
 
-size_t SensorsData::DataSize() {
-    return _data[0].size();
+size_t SensorsData::DataSize() const {
+    // disabled sensors are empty
+    for (size_t i = 0; i < SENSORS; i++)
+        if (!_data[i].empty()) return _data[i].size();
+    return 0;
+}
+
+std::vector<SensorsData::Marker>& SensorsData::markers() {
+    return _markers;
+}
+
+const std::vector<SensorsData::Marker>& SensorsData::markers() const {
+    return _markers;
 }
 
 SensorsData::CONTAINER& SensorsData::data() {
@@ -39,28 +84,46 @@ void SensorsData::reserve(size_t num) {
 void SensorsData::clear() {
     for (size_t i = 0; i < SENSORS; i++)
         _data[i].clear();
+    _markers.clear();
 }
 
-bool SensorsData::empty() {
+bool SensorsData::empty() const {
     return DataSize() == 0;
 }
 
 void SensorsData::append(SensorsData&& other) {
+    if (empty() && _markers.empty()) {
+        // nothing to keep: take the other data over
+        _data = std::move(other._data);
+        _markers = std::move(other._markers);
+        other.clear();
+        return;
+    }
     for (size_t i = 0; i < SENSORS; i++)
         std::move(other._data[i].begin(), other._data[i].end(), std::back_inserter(_data[i]));
+    const auto middle = _markers.size();
+    std::move(other._markers.begin(), other._markers.end(), std::back_inserter(_markers));
+    std::inplace_merge(_markers.begin(), _markers.begin() + middle, _markers.end(),
+                       [](const Marker& a, const Marker& b) { return a.sample < b.sample; });
     other.clear();
 }
 
 void SensorsData::erase_front(size_t num) {
     for (size_t i = 0; i < SENSORS; i++)
-        _data[i].erase(_data[i].begin(), _data[i].begin() + num);
+        _data[i].erase(_data[i].begin(), _data[i].begin() + std::min(num, _data[i].size()));
 }
 
 void SensorsData::erase_back(size_t num) {
     for (size_t i = 0; i < SENSORS; i++)
-        _data[i].resize(_data[i].size()-num);
+        _data[i].resize(_data[i].size() - std::min(num, _data[i].size()));
 }
 
+// a record queue entry: the block and its fetcher stamps
+struct RecordBlock {
+    SensorsData data;
+    TimeSwipeLatencyTracker::Stamps stamps;
+};
+
 class TimeSwipeImpl {
     static std::mutex startStopMtx;
     static TimeSwipeImpl* startedInstance;
@@ -74,11 +137,27 @@ public:
     void SetSensorOffsets(int offset1, int offset2, int offset3, int offset4);
     void SetSensorGains(float gain1, float gain2, float gain3, float gain4);
     void SetSensorTransmissions(float trans1, float trans2, float trans3, float trans4);
+    bool SetSensorCalibration(uint8_t num, std::shared_ptr<const TimeSwipeCalibration::Table> table);
+    bool SetChannelMask(uint8_t mask);
+    uint8_t GetChannelMask();
 
     bool SetSampleRate(int rate);
+#ifdef TIMESWIPE_PMR
+    bool SetMemoryResource(std::pmr::memory_resource* resource);
+#endif
+    void AddMarker(TimeSwipeEvent::Setting&& setting);
     bool Start(TimeSwipe::ReadCallback);
     bool onEvent(TimeSwipe::OnEventCallback cb);
     bool onError(TimeSwipe::OnErrorCallback cb);
+    bool onDegradation(TimeSwipe::OnDegradationCallback cb);
+    bool onControl(TimeSwipe::ControlCallback cb);
+    TimeSwipeControlStats GetControlStats();
+    TimeSwipeLatencyStats GetLatencyStats();
+    bool SetCompression(uint8_t num, TimeSwipe::Compression mode, float bound, uint32_t maxInterval);
+    bool onCompressed(TimeSwipe::OnCompressedCallback cb);
+    TimeSwipeClockStats GetClockStats();
+    bool GetSampleTime(uint64_t sample, std::chrono::system_clock::time_point& time);
+    bool SetClockLock(bool enable);
     std::string Settings(uint8_t set_or_get, const std::string& request, std::string& error);
     bool Stop();
 
@@ -88,8 +167,22 @@ private:
     bool _isStarted();
     void _fetcherLoop();
     void _pollerLoop(TimeSwipe::ReadCallback cb);
+    void _deliver(TimeSwipe::ReadCallback& cb, SensorsData&& data, uint64_t errors, bool last);
     void _spiLoop();
     void _receiveEvents();
+    void _applyScaling();
+    void _applyStored(const TimeSwipeEEPROM::Settings& stored);
+
+    // the settings made by the application, the EEPROM ones don't override them
+    enum : uint32_t {
+        USER_MODE = 1,
+        USER_OFFSETS = 2,
+        USER_GAINS = 4,
+        USER_TRANSMISSIONS = 8,
+        // shifted by the sensor number
+        USER_CALIBRATION = 16
+    };
+    uint32_t userSettings = 0;
 #if NOT_RPI
     int emulButtonPressed = 0;
     int emulButtonSent = 0;
@@ -97,13 +190,21 @@ private:
 #endif
 
     RecordReader Rec;
+    TimeSwipeMarkers markers;
+
+    // the scaling requested by the user, applied to Rec by the fetcher between blocks
+    std::mutex scalingMtx;
+    SensorsScaling scaling;
+    std::vector<TimeSwipeEvent> scalingChanges;
+    void _changeScaling(const char* name, std::string value, std::function<void()> change);
     // 32 - minimal sample 48K maximal rate, next buffer is enough too keep records for 1 sec
     static const unsigned constexpr BUFFER_SIZE = 48000/32*2;
-    boost::lockfree::spsc_queue<SensorsData, boost::lockfree::capacity<BUFFER_SIZE>> recordBuffer;
+    boost::lockfree::spsc_queue<RecordBlock, boost::lockfree::capacity<BUFFER_SIZE>> recordBuffer;
     std::atomic_uint64_t recordErrors = 0;
 
-    SensorsData burstBuffer;
     size_t burstSize = 0;
+    int sampleRate = BASE_SAMPLE_RATE;
+    MemoryResource memoryResource = defaultMemoryResource();
 
     boost::lockfree::spsc_queue<std::pair<uint8_t,std::string>, boost::lockfree::capacity<1024>> _inSPI;
     boost::lockfree::spsc_queue<std::pair<std::string,std::string>, boost::lockfree::capacity<1024>> _outSPI;
@@ -114,6 +215,17 @@ private:
 
     TimeSwipe::OnEventCallback onEventCb;
     TimeSwipe::OnErrorCallback onErrorCb;
+    TimeSwipe::OnDegradationCallback onDegradationCb;
+    TimeSwipeDegradation degradation;
+    TimeSwipe::ControlCallback onControlCb;
+    TimeSwipeControl control;
+    TimeSwipeLatencyTracker latency;
+    TimeSwipe::OnCompressedCallback onCompressedCb;
+    std::array<TimeSwipeCompressor, 4> compressors;
+    // samples delivered since Start, the compressed points are indexed by
+    uint64_t delivered = 0;
+    TimeSwipeClock clock;
+    bool clockLock = false;
 
     bool _work = false;
     bool _inCallback = false;
@@ -146,6 +258,7 @@ TimeSwipeImpl::~TimeSwipeImpl() {
 }
 
 void TimeSwipeImpl::SetMode(int number) {
+    userSettings |= USER_MODE;
     Rec.mode = number;
 }
 
@@ -153,36 +266,124 @@ int TimeSwipeImpl::GetMode() {
     return Rec.mode;
 }
 
+void TimeSwipeImpl::_changeScaling(const char* name, std::string value, std::function<void()> change) {
+    std::lock_guard<std::mutex> lock(scalingMtx);
+    change();
+    scalingChanges.push_back(TimeSwipeEvent::Setting(name, std::move(value)));
+}
+
 void TimeSwipeImpl::SetSensorOffsets(int offset1, int offset2, int offset3, int offset4) {
-    Rec.offset[0] = offset1;
-    Rec.offset[1] = offset2;
-    Rec.offset[2] = offset3;
-    Rec.offset[3] = offset4;
+    userSettings |= USER_OFFSETS;
+    _changeScaling("SensorOffsets", nlohmann::json({offset1, offset2, offset3, offset4}).dump(), [&] {
+        scaling.offset[0] = offset1;
+        scaling.offset[1] = offset2;
+        scaling.offset[2] = offset3;
+        scaling.offset[3] = offset4;
+    });
 }
 
 void TimeSwipeImpl::SetSensorGains(float gain1, float gain2, float gain3, float gain4) {
-    Rec.gain[0] = 1.0 / gain1;
-    Rec.gain[1] = 1.0 / gain2;
-    Rec.gain[2] = 1.0 / gain3;
-    Rec.gain[3] = 1.0 / gain4;
+    userSettings |= USER_GAINS;
+    _changeScaling("SensorGains", nlohmann::json({gain1, gain2, gain3, gain4}).dump(), [&] {
+        scaling.gain[0] = 1.0 / gain1;
+        scaling.gain[1] = 1.0 / gain2;
+        scaling.gain[2] = 1.0 / gain3;
+        scaling.gain[3] = 1.0 / gain4;
+    });
 }
 
 void TimeSwipeImpl::SetSensorTransmissions(float trans1, float trans2, float trans3, float trans4) {
-    Rec.transmission[0] = 1.0 / trans1;
-    Rec.transmission[1] = 1.0 / trans2;
-    Rec.transmission[2] = 1.0 / trans3;
-    Rec.transmission[3] = 1.0 / trans4;
+    userSettings |= USER_TRANSMISSIONS;
+    _changeScaling("SensorTransmissions", nlohmann::json({trans1, trans2, trans3, trans4}).dump(), [&] {
+        scaling.transmission[0] = 1.0 / trans1;
+        scaling.transmission[1] = 1.0 / trans2;
+        scaling.transmission[2] = 1.0 / trans3;
+        scaling.transmission[3] = 1.0 / trans4;
+    });
+}
+
+void TimeSwipeImpl::_applyScaling() {
+    std::lock_guard<std::mutex> lock(scalingMtx);
+    if (scalingChanges.empty()) return;
+
+    Rec.scaling = scaling;
+    Rec.updateScaling();
+    // the next block is the first one scaled the new way
+    const auto sample = markers.Samples();
+    for (auto& change: scalingChanges) markers.AddAt(sample, std::move(change));
+    scalingChanges.clear();
+}
+
+void TimeSwipeImpl::_applyStored(const TimeSwipeEEPROM::Settings& stored) {
+    // applied the same way as the application does, but the settings stay the stored ones
+    const auto user = userSettings;
+    if (!(user & USER_MODE) && stored.mode >= 0) SetMode(stored.mode);
+    if (Rec.mode >= 0 && size_t(Rec.mode) < stored.profiles.size() && stored.profiles[Rec.mode]) {
+        const auto& profile = *stored.profiles[Rec.mode];
+        if (profile.offsets && !(user & USER_OFFSETS)) {
+            const auto& o = *profile.offsets;
+            SetSensorOffsets(o[0], o[1], o[2], o[3]);
+        }
+        if (profile.gains && !(user & USER_GAINS)) {
+            const auto& g = *profile.gains;
+            SetSensorGains(g[0], g[1], g[2], g[3]);
+        }
+        if (profile.transmissions && !(user & USER_TRANSMISSIONS)) {
+            const auto& t = *profile.transmissions;
+            SetSensorTransmissions(t[0], t[1], t[2], t[3]);
+        }
+        for (size_t i = 0; i < profile.calibration.size(); i++) {
+            if (profile.calibration[i] && !(user & (USER_CALIBRATION << i))) SetSensorCalibration(i, profile.calibration[i]);
+        }
+    }
+    userSettings = user;
+}
+
+void TimeSwipeImpl::AddMarker(TimeSwipeEvent::Setting&& setting) {
+    if (!_isStarted()) return;
+    markers.Add(TimeSwipeMarkers::Clock::now(), std::move(setting));
 }
 
+bool TimeSwipeImpl::SetSensorCalibration(uint8_t num, std::shared_ptr<const TimeSwipeCalibration::Table> table) {
+    if (num >= scaling.lut.size()) return false;
+    userSettings |= USER_CALIBRATION << num;
+    _changeScaling("SensorCalibration", std::to_string(num), [&] {
+        scaling.lut[num] = std::move(table);
+    });
+    return true;
+}
+
+bool TimeSwipeImpl::SetChannelMask(uint8_t mask) {
+    if (mask == 0 || (mask & ~ALL_CHANNELS_MASK)) return false;
+    // the decoder and the resampler state can't be changed on the fly
+    if (_isStarted()) return false;
+    Rec.channelMask = mask;
+    return true;
+}
+
+uint8_t TimeSwipeImpl::GetChannelMask() {
+    return Rec.channelMask;
+}
 
 bool TimeSwipeImpl::SetSampleRate(int rate) {
     if (rate < 1 || rate > BASE_SAMPLE_RATE) return false;
+    sampleRate = rate;
     resampler.reset(nullptr);
     if (rate != BASE_SAMPLE_RATE)
-        resampler = std::make_unique<TimeSwipeResampler>(rate, BASE_SAMPLE_RATE);
+        resampler = std::make_unique<TimeSwipeResampler>(rate, BASE_SAMPLE_RATE, memoryResource);
     return true;
 }
 
+#ifdef TIMESWIPE_PMR
+bool TimeSwipeImpl::SetMemoryResource(std::pmr::memory_resource* resource) {
+    if (_isStarted()) return false;
+    memoryResource = resource ? resource : std::pmr::get_default_resource();
+    Rec.memoryResource = memoryResource;
+    // the resampler keeps its buffer
+    return SetSampleRate(sampleRate);
+}
+#endif
+
 bool TimeSwipeImpl::Start(TimeSwipe::ReadCallback cb) {
     {
         std::lock_guard<std::mutex> lock(startStopMtx);
@@ -191,19 +392,43 @@ bool TimeSwipeImpl::Start(TimeSwipe::ReadCallback cb) {
             return false;
         }
         startedInstance = this;
+    }
+    _clearThreads();
 
+    {
+        // a board without the image still runs with the application settings
+        TimeSwipeEEPROM::Settings stored;
         std::string err;
-        if (!TimeSwipeEEPROM::Read(err)) {
+        if (!TimeSwipeEEPROM::Read(stored, err)) {
             std::cerr << "EEPROM read failed: \"" << err << "\"" << std::endl;
-            //TODO: uncomment once parsing implemented
-            //return false;
         }
+        _applyStored(stored);
     }
-    _clearThreads();
+
+    {
+        std::lock_guard<std::mutex> lock(scalingMtx);
+        Rec.scaling = scaling;
+        scalingChanges.clear();
+    }
+    markers.Reset();
+    degradation.Reset();
+    latency.Reset();
+    for (auto& c: compressors) c.Reset();
+    delivered = 0;
+    clock.Reset(BASE_SAMPLE_RATE, sampleRate);
+    // a new stream for the resampler too
+    SetSampleRate(sampleRate);
 
     Rec.setup();
     Rec.start();
 
+    if (onControlCb) {
+        control.Start([](const std::string& request) {
+            std::string error;
+            return BoardSetControl(request, error);
+        });
+    }
+
     _work = true;
     _serviceThreads.push_back(std::thread(std::bind(&TimeSwipeImpl::_fetcherLoop, this)));
     _serviceThreads.push_back(std::thread(std::bind(&TimeSwipeImpl::_pollerLoop, this, cb)));
@@ -228,6 +453,7 @@ bool TimeSwipeImpl::Stop() {
     _work = false;
 
     _clearThreads();
+    control.Stop();
 
     while (recordBuffer.pop());
     while (_inSPI.pop());
@@ -250,6 +476,61 @@ bool TimeSwipeImpl::onError(TimeSwipe::OnErrorCallback cb) {
     return true;
 }
 
+bool TimeSwipeImpl::onDegradation(TimeSwipe::OnDegradationCallback cb) {
+    if (_isStarted()) return false;
+    onDegradationCb = cb;
+    return true;
+}
+
+bool TimeSwipeImpl::onControl(TimeSwipe::ControlCallback cb) {
+    if (_isStarted()) return false;
+    onControlCb = cb;
+    return true;
+}
+
+TimeSwipeControlStats TimeSwipeImpl::GetControlStats() {
+    return control.Stats();
+}
+
+TimeSwipeLatencyStats TimeSwipeImpl::GetLatencyStats() {
+    return latency.Stats();
+}
+
+bool TimeSwipeImpl::SetCompression(uint8_t num, TimeSwipe::Compression mode, float bound, uint32_t maxInterval) {
+    if (num >= compressors.size() || _isStarted()) return false;
+    compressors[num].Configure(mode, bound, maxInterval);
+    return true;
+}
+
+bool TimeSwipeImpl::onCompressed(TimeSwipe::OnCompressedCallback cb) {
+    if (_isStarted()) return false;
+    onCompressedCb = cb;
+    return true;
+}
+
+TimeSwipeClockStats TimeSwipeImpl::GetClockStats() {
+    return clock.Stats();
+}
+
+bool TimeSwipeImpl::GetSampleTime(uint64_t sample, std::chrono::system_clock::time_point& time) {
+    TimeSwipeClock::Clock::time_point steady;
+    if (clockLock) {
+        if (!clock.LockedTime(sample, steady)) return false;
+    } else {
+        if (!clock.InputTime(double(sample) * BASE_SAMPLE_RATE / sampleRate, steady)) return false;
+    }
+    // the system clock as it is now
+    const auto now = TimeSwipeClock::Clock::now();
+    time = std::chrono::system_clock::now() + std::chrono::duration_cast<std::chrono::system_clock::duration>(steady - now);
+    return true;
+}
+
+bool TimeSwipeImpl::SetClockLock(bool enable) {
+    if (_isStarted()) return false;
+    clockLock = enable;
+    return true;
+}
+
 std::string TimeSwipeImpl::Settings(uint8_t set_or_get, const std::string& request, std::string& error) {
     _inSPI.push(std::make_pair(set_or_get, request));
     std::pair<std::string,std::string> resp;
@@ -272,15 +553,20 @@ bool TimeSwipeImpl::_isStarted() {
 }
 
 void TimeSwipeImpl::_receiveEvents() {
-#if NOT_RPI
+#if NO_BOARD_LINK
     if (emulButtonSent < emulButtonPressed) {
         TimeSwipeEvent::Button btn(true, emulButtonPressed);
         emulButtonSent = emulButtonPressed;
+        markers.Add(TimeSwipeMarkers::Clock::now(), btn);
         _events.push(btn);
     }
 #else
-    for (auto&& event: readBoardEvents()) {
-        _events.push(event);
+    auto events = readBoardEvents();
+    const auto received = TimeSwipeMarkers::Clock::now();
+    for (auto&& event: events) {
+        _events.push(event.second);
+        if (event.first) markers.AddBoard(*event.first, received, std::move(event.second));
+        else markers.Add(received, std::move(event.second));
     }
 #endif
 }
@@ -290,6 +576,7 @@ void TimeSwipeImpl::_processSPIRequests() {
     while (_inSPI.pop(request)) {
         std::string error;
         auto response = request.first ? readBoardSetSettings(request.second, error) : readBoardGetSettings(request.second, error);
+        if (request.first && error.empty()) AddMarker(TimeSwipeEvent::Setting("Settings", request.second));
         _outSPI.push(std::make_pair(response, error));
     }
 }
@@ -327,6 +614,33 @@ void TimeSwipe::SetSensorTransmissions(float trans1, float trans2, float trans3,
     return _impl->SetSensorTransmissions(trans1, trans2, trans3, trans4);
 }
 
+bool TimeSwipe::SetSensorLinear(uint8_t num, int offset, float mfactor) {
+    if (num >= 4) return false;
+    return _impl->SetSensorCalibration(num, TimeSwipeCalibration::Linear(offset, mfactor));
+}
+
+bool TimeSwipe::SetSensorPolynomial(uint8_t num, const std::vector<double>& coeffs) {
+    if (num >= 4 || coeffs.empty()) return false;
+    return _impl->SetSensorCalibration(num, TimeSwipeCalibration::Polynomial(coeffs));
+}
+
+bool TimeSwipe::SetSensorPiecewise(uint8_t num, const std::vector<std::pair<uint16_t, float>>& points) {
+    if (num >= 4 || points.empty()) return false;
+    return _impl->SetSensorCalibration(num, TimeSwipeCalibration::Piecewise(points));
+}
+
+void TimeSwipe::ResetSensorCalibration(uint8_t num) {
+    _impl->SetSensorCalibration(num, nullptr);
+}
+
+bool TimeSwipe::SetChannelMask(uint8_t mask) {
+    return _impl->SetChannelMask(mask);
+}
+
+uint8_t TimeSwipe::GetChannelMask() {
+    return _impl->GetChannelMask();
+}
+
 void TimeSwipe::SetMode(Mode number) {
     return _impl->SetMode(int(number));
 }
@@ -343,6 +657,12 @@ bool TimeSwipe::SetSampleRate(int rate) {
     return _impl->SetSampleRate(rate);
 }
 
+#ifdef TIMESWIPE_PMR
+bool TimeSwipe::SetMemoryResource(std::pmr::memory_resource* resource) {
+    return _impl->SetMemoryResource(resource);
+}
+#endif
+
 bool TimeSwipe::Start(TimeSwipe::ReadCallback cb) {
     return _impl->Start(cb);
 }
@@ -351,6 +671,42 @@ bool TimeSwipe::onError(TimeSwipe::OnErrorCallback cb) {
     return _impl->onError(cb);
 }
 
+bool TimeSwipe::onDegradation(TimeSwipe::OnDegradationCallback cb) {
+    return _impl->onDegradation(cb);
+}
+
+bool TimeSwipe::onControl(TimeSwipe::ControlCallback cb) {
+    return _impl->onControl(cb);
+}
+
+bool TimeSwipe::SetCompression(uint8_t num, TimeSwipe::Compression mode, float bound, uint32_t maxInterval) {
+    return _impl->SetCompression(num, mode, bound, maxInterval);
+}
+
+bool TimeSwipe::onCompressed(TimeSwipe::OnCompressedCallback cb) {
+    return _impl->onCompressed(cb);
+}
+
+TimeSwipeClockStats TimeSwipe::GetClockStats() {
+    return _impl->GetClockStats();
+}
+
+bool TimeSwipe::GetSampleTime(uint64_t sample, std::chrono::system_clock::time_point& time) {
+    return _impl->GetSampleTime(sample, time);
+}
+
+bool TimeSwipe::SetClockLock(bool enable) {
+    return _impl->SetClockLock(enable);
+}
+
+TimeSwipeControlStats TimeSwipe::GetControlStats() {
+    return _impl->GetControlStats();
+}
+
+TimeSwipeLatencyStats TimeSwipe::GetLatencyStats() {
+    return _impl->GetLatencyStats();
+}
+
 bool TimeSwipe::onEvent(TimeSwipe::OnEventCallback cb) {
     return _impl->onEvent(cb);
 }
@@ -363,10 +719,26 @@ std::string TimeSwipe::GetSettings(const std::string& request, std::string& erro
     return _impl->Settings(0, request, error);
 }
 
+bool TimeSwipe::StoreEEPROMSettings(const std::string& json, std::string& error) {
+    return TimeSwipeEEPROM::Write(json, error);
+}
+
 void TimeSwipeImpl::_fetcherLoop() {
     while (_work) {
+        _applyScaling();
+        TimeSwipeLatencyTracker::Stamps stamps;
+        stamps.read = TimeSwipeLatencyTracker::Clock::now();
         auto data = Rec.read();
-        if (!recordBuffer.push(data))
+        stamps.captured = TimeSwipeLatencyTracker::Clock::now();
+        clock.Block(data.DataSize(), stamps.captured);
+        markers.Block(data);
+        if (onControlCb) {
+            _inCallback = true;
+            control.Block(data, stamps.captured, onControlCb);
+            _inCallback = false;
+        }
+        stamps.queued = TimeSwipeLatencyTracker::Clock::now();
+        if (!recordBuffer.push(RecordBlock{std::move(data), stamps}))
             ++recordErrors;
 
         TimeSwipeEvent event;
@@ -389,10 +761,19 @@ void TimeSwipeImpl::_spiLoop() {
 }
 
 void TimeSwipeImpl::_pollerLoop(TimeSwipe::ReadCallback cb) {
+    // the popped blocks are copied into these ones, so they have to use the driver memory resource too
+    std::vector<RecordBlock> records(10, RecordBlock{makeSensorsData(memoryResource), {}});
+    SensorsData burstBuffer = makeSensorsData(memoryResource);
     while (_work)
     {
-        SensorsData records[10];
-        auto num = recordBuffer.pop(&records[0], 10);
+        // the queue backlog drives the degradation policy
+        if (onDegradationCb && degradation.Update(double(recordBuffer.read_available()) / BUFFER_SIZE)) {
+            _inCallback = true;
+            onDegradationCb(degradation.GetLevel());
+            _inCallback = false;
+        }
+
+        auto num = recordBuffer.pop(&records[0], records.size());
         uint64_t errors = recordErrors.fetch_and(0UL);
         if (num == 0 && errors == 0) {
             std::this_thread::sleep_for(std::chrono::milliseconds(1));
@@ -405,47 +786,91 @@ void TimeSwipeImpl::_pollerLoop(TimeSwipe::ReadCallback cb) {
             _inCallback = false;
         }
 
+        const auto popped = TimeSwipeLatencyTracker::Clock::now();
+        // the input sample the data of this pass starts from
+        const uint64_t first = resampler ? resampler->NextInput() : latency.Samples();
+        for (size_t i = 0; i < num; i++) {
+            latency.Popped(records[i].stamps, records[i].data.DataSize(), popped);
+        }
+
         SensorsData* records_ptr = nullptr;
-        SensorsData samples;
+        SensorsData samples = makeSensorsData(memoryResource);
         if (resampler) {
             for (size_t i = 0; i < num; i++) {
-                auto s = resampler->Resample(std::move(records[i]));
+                auto s = resampler->Resample(std::move(records[i].data));
                 samples.append(std::move(s));
             }
             records_ptr = &samples;
         } else {
             for (size_t i = 1; i < num; i++) {
-                records[0].append(std::move(records[i]));
+                records[0].data.append(std::move(records[i].data));
+            }
+            records_ptr = &records[0].data;
+        }
+
+        if (onDegradationCb) {
+            // a degraded stream takes everything queued at once, records[0] may hold the data so far
+            if (degradation.GetLevel() != TimeSwipe::Degradation::None) {
+                while ((num = recordBuffer.pop(&records[1], records.size() - 1))) {
+                    const auto now = TimeSwipeLatencyTracker::Clock::now();
+                    for (size_t i = 1; i <= num; i++) {
+                        latency.Popped(records[i].stamps, records[i].data.DataSize(), now);
+                        records_ptr->append(resampler ? resampler->Resample(std::move(records[i].data)) : std::move(records[i].data));
+                    }
+                }
             }
-            records_ptr = &records[0];
+            *records_ptr = degradation.Process(std::move(*records_ptr));
         }
 
+        if (clockLock && degradation.GetLevel() == TimeSwipe::Degradation::None) clock.Lock(*records_ptr);
+
+        if (records_ptr->DataSize()) latency.Ready(first, TimeSwipeLatencyTracker::Clock::now());
+
         if (burstBuffer.empty() && burstSize <= records_ptr->DataSize()) {
             // optimization if burst buffer not used or smaller than first buffer
-            _inCallback = true;
-            cb(std::move(*records_ptr), errors);
-            _inCallback = false;
+            _deliver(cb, std::move(*records_ptr), errors, false);
             records_ptr->clear();
         } else {
             // burst buffer mode
             burstBuffer.append(std::move(*records_ptr));
             records_ptr->clear();
             if (burstBuffer.DataSize() >= burstSize) {
-                _inCallback = true;
-                cb(std::move(burstBuffer), errors);
-                _inCallback = false;
+                _deliver(cb, std::move(burstBuffer), errors, false);
                 burstBuffer.clear();
             }
         }
     }
-    if (!_inCallback && burstBuffer.DataSize()) {
-        _inCallback = true;
-        cb(std::move(burstBuffer), 0);
-        _inCallback = false;
+    if (!_inCallback) {
+        // the compressed streams end here, their last points go even without data left
+        _deliver(cb, std::move(burstBuffer), 0, true);
         burstBuffer.clear();
     }
 }
 
+void TimeSwipeImpl::_deliver(TimeSwipe::ReadCallback& cb, SensorsData&& data, uint64_t errors, bool last) {
+    const size_t size = data.DataSize();
+    std::array<std::vector<TimeSwipePoint>, 4> points;
+    bool compressed = false;
+    // the points have no consumer without the callback: the data goes as is
+    for (size_t i = 0; onCompressedCb && i < compressors.size(); i++) {
+        if (compressors[i].GetMode() == TimeSwipe::Compression::None) continue;
+        compressed = true;
+        compressors[i].Process(data[i].data(), data[i].size(), delivered, points[i]);
+        if (last) compressors[i].Flush(points[i]);
+        data[i].clear();
+    }
+    delivered += size;
+
+    _inCallback = true;
+    if (compressed) onCompressedCb(std::move(points));
+    // the end of the stream has nothing else to deliver
+    if (!last || size) {
+        latency.Delivered(TimeSwipeLatencyTracker::Clock::now());
+        cb(std::move(data), errors);
+    }
+    _inCallback = false;
+}
+
 #if NOT_RPI
 void TimeSwipeImpl::_emulLoop() {
     emulButtonPressed = 0;
@@ -491,12 +916,16 @@ bool TimeSwipe::StartPWM(uint8_t num, uint32_t frequency, uint32_t high, uint32_
     else if (low > 4096) return false;
     else if (low > high) return false;
     else if (duty_cycle < 0.001 || duty_cycle > 0.999) return false;
-    return BoardStartPWM(num, frequency, high, low, repeats, duty_cycle);
+    if (!BoardStartPWM(num, frequency, high, low, repeats, duty_cycle)) return false;
+    _impl->AddMarker(TimeSwipeEvent::Setting("PWM" + std::to_string(num + 1), "true"));
+    return true;
 }
 
 bool TimeSwipe::StopPWM(uint8_t num) {
     if (num > 1) return false;
-    return BoardStopPWM(num);
+    if (!BoardStopPWM(num)) return false;
+    _impl->AddMarker(TimeSwipeEvent::Setting("PWM" + std::to_string(num + 1), "false"));
+    return true;
 }
 
 bool TimeSwipe::GetPWM(uint8_t num, bool& active, uint32_t& frequency, uint32_t& high, uint32_t& low, uint32_t& repeats, float& duty_cycle) {
@@ -504,6 +933,18 @@ bool TimeSwipe::GetPWM(uint8_t num, bool& active, uint32_t& frequency, uint32_t&
     return BoardGetPWM(num, active, frequency, high, low, repeats, duty_cycle);
 }
 
+bool TimeSwipe::GetSnapshot(TimeSwipeSnapshot& snap) {
+    return BoardGetSnapshot(snap);
+}
+
 void TimeSwipe::TraceSPI(bool val) {
     BoardTraceSPI(val);
 }
+
+uint64_t TimeSwipe::EventsLost() {
+    return BoardEventsLost();
+}
+
+const char* TimeSwipe::GetKernels() {
+    return TimeSwipeKernels::Get().name;
+}
@@ -0,0 +1,47 @@
+#include "timeswipe_calibration.hpp"
+#include <algorithm>
+
+std::shared_ptr<const TimeSwipeCalibration::Table> TimeSwipeCalibration::Linear(int offset, float mfactor) {
+    auto table = std::make_shared<Table>(TABLE_SIZE);
+    for (size_t raw = 0; raw < TABLE_SIZE; raw++) {
+        (*table)[raw] = (float)(int(raw) - offset) * mfactor;
+    }
+    return table;
+}
+
+std::shared_ptr<const TimeSwipeCalibration::Table> TimeSwipeCalibration::Polynomial(const std::vector<double>& coeffs) {
+    if (coeffs.empty()) return nullptr;
+
+    auto table = std::make_shared<Table>(TABLE_SIZE);
+    for (size_t raw = 0; raw < TABLE_SIZE; raw++) {
+        // Horner's scheme
+        double val = 0;
+        for (auto it = coeffs.rbegin(); it != coeffs.rend(); ++it) {
+            val = val * double(raw) + *it;
+        }
+        (*table)[raw] = float(val);
+    }
+    return table;
+}
+
+std::shared_ptr<const TimeSwipeCalibration::Table> TimeSwipeCalibration::Piecewise(std::vector<std::pair<uint16_t, float>> points) {
+    if (points.empty()) return nullptr;
+
+    std::stable_sort(points.begin(), points.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    auto table = std::make_shared<Table>(TABLE_SIZE);
+    auto& t = *table;
+    size_t raw = 0;
+    for (; raw <= points.front().first; raw++) t[raw] = points.front().second;
+
+    for (size_t i = 1; i < points.size(); i++) {
+        const auto& p0 = points[i-1];
+        const auto& p1 = points[i];
+        if (p1.first == p0.first) continue;
+        const double slope = double(p1.second - p0.second) / double(p1.first - p0.first);
+        for (; raw <= p1.first; raw++) t[raw] = float(p0.second + slope * double(raw - p0.first));
+    }
+
+    for (; raw < TABLE_SIZE; raw++) t[raw] = points.back().second;
+    return table;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <utility>
+#include <cstdint>
+
+// Per-channel sensor calibration lookup table:
+// one precomputed value for each of 65536 ADC codes, the decoder indexes it directly
+class TimeSwipeCalibration {
+public:
+    static constexpr size_t TABLE_SIZE = 65536;
+    using Table = std::vector<float>;
+
+    // value = (raw - offset) * mfactor, the same as the default decoder path
+    static std::shared_ptr<const Table> Linear(int offset, float mfactor);
+
+    // value = coeffs[0] + coeffs[1]*raw + coeffs[2]*raw^2 + ...
+    // returns nullptr if coeffs is empty
+    static std::shared_ptr<const Table> Polynomial(const std::vector<double>& coeffs);
+
+    // linear interpolation between (raw, value) points, the end values are held outside the points range
+    // returns nullptr if points is empty
+    static std::shared_ptr<const Table> Piecewise(std::vector<std::pair<uint16_t, float>> points);
+};
@@ -0,0 +1,149 @@
+#include "timeswipe_clock.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+double median(std::vector<double>& v) {
+    auto mid = v.begin() + v.size() / 2;
+    std::nth_element(v.begin(), mid, v.end());
+    return *mid;
+}
+
+}
+
+void TimeSwipeClock::Reset(int nominalRate, int outputRate) {
+    std::lock_guard<std::mutex> lock(mtx);
+    nominal = nominalRate;
+    output = outputRate;
+    samples = 0;
+    bucketOpen = false;
+    history.clear();
+    valid = false;
+    residuals.clear();
+    residualsNext = 0;
+    streamed = 0;
+    delivered = 0;
+    slips = 0;
+}
+
+void TimeSwipeClock::Block(size_t n, Clock::time_point arrived) {
+    if (n == 0) return;
+    std::lock_guard<std::mutex> lock(mtx);
+    if (samples == 0) origin = arrived;
+    samples += n;
+    const Point p{double(samples), std::chrono::duration<double>(arrived - origin).count()};
+
+    if (valid) {
+        const float r = float((p.seconds - intercept - slope * p.samples) * 1e6);
+        if (residuals.size() < RESIDUALS_SIZE) residuals.push_back(r);
+        else residuals[residualsNext] = r;
+        residualsNext = (residualsNext + 1) % RESIDUALS_SIZE;
+    }
+
+    // the earliest against the nominal rate
+    auto early = [&](const Point& a, const Point& b) {
+        return a.seconds - a.samples / nominal < b.seconds - b.samples / nominal;
+    };
+    if (bucketOpen && p.seconds - bucketStart < BUCKET_SECONDS) {
+        if (early(p, bucket)) bucket = p;
+        return;
+    }
+    if (bucketOpen) {
+        history.push_back(bucket);
+        if (history.size() > HISTORY_SIZE) history.pop_front();
+        fit();
+    }
+    bucketOpen = true;
+    bucketStart = p.seconds;
+    bucket = p;
+}
+
+void TimeSwipeClock::fit() {
+    const size_t n = history.size();
+    if (n < MIN_HISTORY) return;
+
+    // the slopes between the points half the history apart
+    const size_t half = n / 2;
+    std::vector<double> v;
+    v.reserve(n);
+    for (size_t i = 0; i + half < n; i++) {
+        const auto& a = history[i];
+        const auto& b = history[i + half];
+        v.push_back((b.seconds - a.seconds) / (b.samples - a.samples));
+    }
+    const double s = median(v);
+
+    v.clear();
+    for (const auto& p: history) v.push_back(p.seconds - s * p.samples);
+    intercept = median(v);
+    slope = s;
+    // a block arrives once its last sample is taken: the sample is counted by its end
+    if (!valid) first = intercept + slope;
+    valid = true;
+}
+
+void TimeSwipeClock::Lock(SensorsData& data) {
+    size_t n = data.DataSize();
+    std::lock_guard<std::mutex> lock(mtx);
+    const int64_t offset = int64_t(delivered) - int64_t(streamed);
+    for (auto& m: data.markers()) m.sample = uint64_t(std::max<int64_t>(0, int64_t(m.sample) + offset));
+    streamed += n;
+    if (n == 0 || !valid) {
+        delivered += n;
+        return;
+    }
+
+    // the samples the stream should have delivered by the fitted time of its last sample,
+    // a sample slips per block at most
+    const double target = (intercept + slope * double(streamed) * nominal / output - first) * output + 1;
+    const double ahead = double(delivered + n) - target;
+    if (ahead >= 1 && n > 1) {
+        for (size_t i = 0; i < data.SensorsSize(); i++) {
+            if (!data[i].empty()) data[i].pop_back();
+        }
+        slips--;
+        n--;
+    } else if (ahead <= -1) {
+        for (size_t i = 0; i < data.SensorsSize(); i++) {
+            if (!data[i].empty()) data[i].push_back(data[i].back());
+        }
+        slips++;
+        n++;
+    }
+    delivered += n;
+}
+
+TimeSwipeClockStats TimeSwipeClock::Stats() {
+    std::lock_guard<std::mutex> lock(mtx);
+    TimeSwipeClockStats res;
+    res.nominal_rate = nominal;
+    res.slips = slips;
+    if (!valid) return res;
+    res.valid = true;
+    res.rate = 1 / slope;
+    res.ppm = (res.rate / nominal - 1) * 1e6;
+    if (!residuals.empty()) {
+        std::vector<double> v(residuals.begin(), residuals.end());
+        const double m = median(v);
+        for (auto& r: v) r = std::fabs(r - m);
+        res.jitter_us = median(v);
+    }
+    return res;
+}
+
+bool TimeSwipeClock::InputTime(double sample, Clock::time_point& time) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!valid) return false;
+    // the sample ends the block of sample + 1 samples
+    time = origin + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(intercept + slope * (sample + 1)));
+    return true;
+}
+
+bool TimeSwipeClock::LockedTime(uint64_t sample, Clock::time_point& time) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!valid) return false;
+    // the locked stream runs at the output rate of the fitted clock from the first sample on
+    time = origin + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(first + double(sample) / output));
+    return true;
+}
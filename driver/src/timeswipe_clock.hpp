@@ -0,0 +1,75 @@
+#pragma once
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include "timeswipe.hpp"
+
+// The board sample clock against the system one: the input sample count at the end of every block
+// is fitted to the block arrival time. The arrivals are late by the read and scheduling jitter only,
+// so the earliest arrival of every bucket is taken and the line is fitted by Theil-Sen estimator:
+// a late bucket or a stall moves the median slopes a little.
+// The lock part slips the delivered stream by a sample whenever it gets a sample apart from the fitted clock.
+class TimeSwipeClock {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // a new stream at the nominal input rate delivered at the output rate, the fit and the lock are reset
+    void Reset(int nominalRate, int outputRate);
+
+    // fetcher side: a block of n input samples arrived at the time point
+    void Block(size_t n, Clock::time_point arrived);
+
+    // poller side: keeps the data of the delivered stream within a sample of the fitted clock,
+    // the markers are moved to the delivered sample indexes
+    void Lock(SensorsData& data);
+
+    TimeSwipeClockStats Stats();
+
+    // the steady clock time of the input sample, false if there is no fit yet
+    bool InputTime(double sample, Clock::time_point& time);
+
+    // the steady clock time of the delivered sample of the locked stream, false if there is no fit yet
+    bool LockedTime(uint64_t sample, Clock::time_point& time);
+
+private:
+    struct Point {
+        // input samples by the end of the block
+        double samples;
+        // arrival, seconds since origin
+        double seconds;
+    };
+
+    // the earliest arrival of every bucket is fitted
+    static constexpr double BUCKET_SECONDS = 1;
+    // the buckets fitted: the estimate follows the clock over about 8 minutes
+    static constexpr size_t HISTORY_SIZE = 512;
+    // the buckets needed for the first fit
+    static constexpr size_t MIN_HISTORY = 8;
+    // the block arrivals the jitter is measured over
+    static constexpr size_t RESIDUALS_SIZE = 1024;
+
+    void fit();
+
+    std::mutex mtx;
+    int nominal = 48000;
+    int output = 48000;
+    Clock::time_point origin;
+    uint64_t samples = 0;
+    bool bucketOpen = false;
+    double bucketStart = 0;
+    Point bucket{};
+    std::deque<Point> history;
+    // the fit: seconds = intercept + slope * samples
+    bool valid = false;
+    double intercept = 0;
+    double slope = 0;
+    std::vector<float> residuals;
+    size_t residualsNext = 0;
+
+    // the lock: the fitted time of the first sample, taken by the first fit, the stream samples and the delivered ones
+    double first = 0;
+    uint64_t streamed = 0;
+    uint64_t delivered = 0;
+    int64_t slips = 0;
+};
@@ -0,0 +1,79 @@
+#include "timeswipe_compression.hpp"
+#include <algorithm>
+#include <cmath>
+
+void TimeSwipeCompressor::Configure(Mode m, float b, uint32_t interval) {
+    mode = m;
+    bound = std::fabs(b);
+    maxInterval = interval;
+    Reset();
+}
+
+void TimeSwipeCompressor::Reset() {
+    started = false;
+}
+
+void TimeSwipeCompressor::Process(const float* values, size_t count, uint64_t first, std::vector<TimeSwipePoint>& out) {
+    for (size_t i = 0; i < count; i++) {
+        const uint64_t sample = first + i;
+        if (!started) {
+            started = true;
+            last = prev = {sample, values[i]};
+            low = -INFINITY;
+            high = INFINITY;
+            out.push_back(last);
+            continue;
+        }
+        if (mode == Mode::Deadband) {
+            deadband(sample, values[i], out);
+        } else {
+            swingingDoor(sample, values[i], out);
+        }
+        prev = {sample, values[i]};
+    }
+}
+
+void TimeSwipeCompressor::deadband(uint64_t sample, float value, std::vector<TimeSwipePoint>& out) {
+    if (std::fabs(value - last.value) > bound || (maxInterval && sample - last.sample >= maxInterval)) {
+        last = {sample, value};
+        out.push_back(last);
+    }
+}
+
+void TimeSwipeCompressor::swingingDoor(uint64_t sample, float value, std::vector<TimeSwipePoint>& out) {
+    double dt = double(sample - last.sample);
+    double l = (value - bound - last.value) / dt;
+    double h = (value + bound - last.value) / dt;
+    if (std::max(low, l) > std::min(high, h)) {
+        // the doors closed: the segment ends at the previous sample, the new one starts with this sample
+        closeDoor(prev.sample, prev.value, out);
+        dt = double(sample - last.sample);
+        l = (value - bound - last.value) / dt;
+        h = (value + bound - last.value) / dt;
+        low = l;
+        high = h;
+    } else {
+        low = std::max(low, l);
+        high = std::min(high, h);
+    }
+    if (maxInterval && sample - last.sample >= maxInterval) closeDoor(sample, value, out);
+}
+
+void TimeSwipeCompressor::closeDoor(uint64_t sample, float value, std::vector<TimeSwipePoint>& out) {
+    const double dt = double(sample - last.sample);
+    const double slope = std::clamp((value - last.value) / dt, low, high);
+    last = {sample, float(last.value + slope * dt)};
+    out.push_back(last);
+    low = -INFINITY;
+    high = INFINITY;
+}
+
+void TimeSwipeCompressor::Flush(std::vector<TimeSwipePoint>& out) {
+    if (!started || prev.sample == last.sample) return;
+    if (mode == Mode::Deadband) {
+        last = prev;
+        out.push_back(last);
+    } else {
+        closeDoor(prev.sample, prev.value, out);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include "timeswipe.hpp"
+
+// The compressor of a sensor stream: keeps the points the stream is reconstructed from within the error bound,
+// sample-and-hold for the deadband, the linear interpolation for the swinging door
+class TimeSwipeCompressor {
+public:
+    using Mode = TimeSwipe::Compression;
+
+    void Configure(Mode mode, float bound, uint32_t maxInterval);
+    Mode GetMode() const { return mode; }
+
+    // a new stream: the next sample is a point
+    void Reset();
+
+    // the samples of the stream starting at the sample first, the points go to out
+    void Process(const float* values, size_t count, uint64_t first, std::vector<TimeSwipePoint>& out);
+
+    // the end of the stream: the last sample is a point too
+    void Flush(std::vector<TimeSwipePoint>& out);
+
+private:
+    void deadband(uint64_t sample, float value, std::vector<TimeSwipePoint>& out);
+    void swingingDoor(uint64_t sample, float value, std::vector<TimeSwipePoint>& out);
+    // the swinging door point at the sample: the value on the line of the slope from the last point
+    // allowed by the doors and closest to the actual one
+    void closeDoor(uint64_t sample, float value, std::vector<TimeSwipePoint>& out);
+
+    Mode mode = Mode::None;
+    float bound = 0;
+    uint32_t maxInterval = 0;
+
+    bool started = false;
+    TimeSwipePoint last{};
+    // the last sample seen
+    TimeSwipePoint prev{};
+    // the swinging door: the slopes from the last point every sample since is within the bound of
+    double low = 0;
+    double high = 0;
+};
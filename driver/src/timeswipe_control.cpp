@@ -0,0 +1,119 @@
+#include "timeswipe_control.hpp"
+#include "timeswipe_latency.hpp"
+#include <algorithm>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+void TimeSwipeSetpoints::_set(const std::string& name, std::string value) {
+    auto it = std::find_if(_values.begin(), _values.end(), [&](const auto& v) { return v.first == name; });
+    if (it != _values.end()) {
+        it->second = std::move(value);
+    } else {
+        _values.emplace_back(name, std::move(value));
+    }
+}
+
+void TimeSwipeSetpoints::Set(const std::string& name, int value) {
+    _set(name, std::to_string(value));
+}
+
+void TimeSwipeSetpoints::Set(const std::string& name, double value) {
+    _set(name, nlohmann::json(value).dump());
+}
+
+void TimeSwipeSetpoints::Set(const std::string& name, bool value) {
+    _set(name, value ? "true" : "false");
+}
+
+void TimeSwipeSetpoints::merge(const TimeSwipeSetpoints& other) {
+    for (const auto& v: other._values) _set(v.first, v.second);
+}
+
+std::string TimeSwipeSetpoints::json() const {
+    // the values are JSON already, the board keeps the order of the request
+    std::string res = "{";
+    for (const auto& v: _values) {
+        if (res.size() > 1) res += ',';
+        res += nlohmann::json(v.first).dump();
+        res += ':';
+        res += v.second;
+    }
+    return res + "}";
+}
+
+TimeSwipeControl::~TimeSwipeControl() {
+    Stop();
+}
+
+void TimeSwipeControl::Start(Sender s) {
+    Stop();
+    std::lock_guard<std::mutex> lock(mtx);
+    sender = std::move(s);
+    pending.clear();
+    stats = TimeSwipeControlStats();
+    latencyCount = 0;
+    work = true;
+    thread = std::thread(&TimeSwipeControl::loop, this);
+}
+
+void TimeSwipeControl::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        work = false;
+    }
+    cv.notify_one();
+    if (thread.joinable()) thread.join();
+}
+
+void TimeSwipeControl::Block(const SensorsData& data, Clock::time_point read, const TimeSwipe::ControlCallback& cb) {
+    setpoints.clear();
+    cb(data, setpoints);
+
+    std::unique_lock<std::mutex> lock(mtx);
+    stats.blocks++;
+    if (setpoints.empty()) return;
+    if (pending.empty()) {
+        pendingRead = read;
+    } else {
+        stats.merged++;
+    }
+    pending.merge(setpoints);
+    lock.unlock();
+    cv.notify_one();
+}
+
+void TimeSwipeControl::loop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        cv.wait(lock, [this] { return !work || !pending.empty(); });
+        if (!work) break;
+
+        const auto request = pending.json();
+        const auto read = pendingRead;
+        pending.clear();
+
+        lock.unlock();
+        const bool ok = sender(request);
+        const auto done = Clock::now();
+        lock.lock();
+
+        if (!ok) {
+            stats.errors++;
+            continue;
+        }
+        stats.sent++;
+        latency_us[latencyCount++ % LATENCY_SIZE] = std::chrono::duration<float, std::micro>(done - read).count();
+    }
+}
+
+TimeSwipeControlStats TimeSwipeControl::Stats() {
+    std::vector<float> lat;
+    TimeSwipeControlStats res;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        res = stats;
+        lat.assign(latency_us.begin(), latency_us.begin() + std::min(latencyCount, LATENCY_SIZE));
+    }
+    res.latency = LatencyDistribution(std::move(lat));
+    return res;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "timeswipe.hpp"
+
+// The closed-loop control path: the fetcher passes each block to the control hook, the control thread
+// sends the queued setpoints to the board as soon as they are there
+class TimeSwipeControl {
+public:
+    using Clock = std::chrono::steady_clock;
+    // sends a SetSettings request, returns false on failure
+    using Sender = std::function<bool(const std::string& request)>;
+
+    ~TimeSwipeControl();
+
+    // starts the control thread, the stats are reset
+    void Start(Sender sender);
+    // stops the control thread, the setpoints not sent yet are dropped
+    void Stop();
+
+    // a block has been read at the time point: runs the hook and queues its setpoints
+    void Block(const SensorsData& data, Clock::time_point read, const TimeSwipe::ControlCallback& cb);
+
+    TimeSwipeControlStats Stats();
+
+private:
+    void loop();
+
+    // the number of the latest requests the latency distribution is taken over
+    static constexpr size_t LATENCY_SIZE = 4096;
+
+    Sender sender;
+    std::thread thread;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool work = false;
+
+    // the hook output, reused for every block
+    TimeSwipeSetpoints setpoints;
+    // the setpoints waiting for the control thread and the read time of the oldest block among them
+    TimeSwipeSetpoints pending;
+    Clock::time_point pendingRead;
+
+    TimeSwipeControlStats stats;
+    std::array<float, LATENCY_SIZE> latency_us;
+    size_t latencyCount = 0;
+};
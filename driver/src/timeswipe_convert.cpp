@@ -0,0 +1,360 @@
+#include "timeswipe_convert.hpp"
+#include "timeswipe_resampler.hpp"
+#include "timeswipe_calibration.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+constexpr size_t SENSORS = 4;
+// the text batch size estimate per sample, bytes
+constexpr size_t TSV_SAMPLE_SIZE = 48;
+// the serial pass feeds the resampler by blocks of this size, like the reader thread does live
+constexpr size_t SERIAL_BLOCK = 1000;
+
+// calls fn(0..count-1) spread over the threads, the calling thread included
+void parallelFor(size_t count, unsigned threads, const std::function<void(size_t)>& fn) {
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+        for (size_t i; (i = next++) < count;) fn(i);
+    };
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < std::min<size_t>(threads, count); t++) pool.emplace_back(work);
+    work();
+    for (auto& t: pool) t.join();
+}
+
+// the samples [begin, end) of the first channels
+SensorsData range(const SensorsData& data, size_t channels, size_t begin, size_t end) {
+    SensorsData res;
+    for (size_t c = 0; c < channels; c++) res[c].assign(data[c].begin() + begin, data[c].begin() + end);
+    return res;
+}
+
+class Reader {
+public:
+    using Format = TimeSwipeConverter::Format;
+
+    Reader(std::istream& in, Format format, const std::array<std::shared_ptr<const std::vector<float>>, 4>& lut,
+           const std::array<float, 4>& gain, const std::array<float, 4>& offset)
+        : in(in), format(format), lut(lut), gain(gain), offset(offset) {
+        if (format != Format::TSV) channels = SENSORS;
+    }
+
+    // appends about count samples to data, returns false at the end of the input
+    bool Read(size_t count, SensorsData& data, unsigned threads, std::string& error) {
+        return format == Format::TSV ? readText(count, data, threads, error) : readBinary(count, data, threads, error);
+    }
+
+    size_t Channels() const { return channels; }
+
+private:
+    float scale(size_t c, float v) const { return v * gain[c] + offset[c]; }
+
+    bool readBinary(size_t count, SensorsData& data, unsigned threads, std::string& error) {
+        const size_t sampleSize = SENSORS * (format == Format::F32 ? sizeof(float) : sizeof(uint16_t));
+        buf.resize(count * sampleSize);
+        in.read(buf.data(), buf.size());
+        const size_t n = size_t(in.gcount()) / sampleSize;
+        if (in.bad()) {
+            error = "input read failed";
+            return false;
+        }
+
+        const size_t base = data.DataSize();
+        for (size_t c = 0; c < SENSORS; c++) data[c].resize(base + n);
+
+        const size_t pieces = std::max<size_t>(1, std::min<size_t>(threads * 4, n / 4096));
+        parallelFor(pieces, threads, [&](size_t p) {
+            const size_t begin = n * p / pieces;
+            const size_t end = n * (p + 1) / pieces;
+            for (size_t i = begin; i < end; i++) {
+                const char* s = buf.data() + i * sampleSize;
+                for (size_t c = 0; c < SENSORS; c++) {
+                    float v;
+                    if (format == Format::F32) {
+                        std::memcpy(&v, s + c * sizeof(float), sizeof(float));
+                    } else {
+                        uint16_t raw;
+                        std::memcpy(&raw, s + c * sizeof(uint16_t), sizeof(uint16_t));
+                        v = lut[c] ? (*lut[c])[raw] : float(raw);
+                    }
+                    data[c][base + i] = scale(c, v);
+                }
+            }
+        });
+        return n == count;
+    }
+
+    // parses the lines of [begin, end), returns false on a malformed line
+    bool parseLines(const char* begin, const char* end, SensorsData& out, std::string& bad) const {
+        while (begin < end) {
+            const char* eol = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+            if (!eol) eol = end;
+            size_t c = 0;
+            const char* p = begin;
+            while (p < eol) {
+                while (p < eol && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+                if (p == eol) break;
+                char* next;
+                const float v = std::strtof(p, &next);
+                if (next == p || next > eol || c == channels) {
+                    bad.assign(begin, eol);
+                    return false;
+                }
+                out[c].push_back(scale(c, v));
+                c++;
+                p = next;
+            }
+            if (c != 0 && c != channels) {
+                bad.assign(begin, eol);
+                return false;
+            }
+            begin = eol + 1;
+        }
+        return true;
+    }
+
+    bool readText(size_t count, SensorsData& data, unsigned threads, std::string& error) {
+        std::string text = std::move(carry);
+        carry.clear();
+        const size_t have = text.size();
+        text.resize(have + count * TSV_SAMPLE_SIZE);
+        in.read(&text[have], text.size() - have);
+        text.resize(have + size_t(in.gcount()));
+        if (in.bad()) {
+            error = "input read failed";
+            return false;
+        }
+        const bool more = bool(in);
+
+        // an incomplete last line waits for the next batch
+        if (more) {
+            const auto eol = text.rfind('\n');
+            if (eol == std::string::npos) {
+                carry = std::move(text);
+                return true;
+            }
+            carry = text.substr(eol + 1);
+            text.resize(eol + 1);
+        }
+
+        if (text.empty()) return more;
+
+        // the number of sensors is taken from the first line
+        if (!channels) {
+            std::istringstream first(text.substr(0, text.find('\n')));
+            float v;
+            while (first >> v) channels++;
+            if (!channels || channels > SENSORS) {
+                error = "wrong TSV line: \"" + text.substr(0, text.find('\n')) + "\"";
+                return false;
+            }
+        }
+
+        // pieces split at line ends
+        const size_t pieces = std::max<size_t>(1, std::min<size_t>(threads * 4, text.size() / 65536));
+        std::vector<const char*> bounds{text.data()};
+        for (size_t p = 1; p < pieces; p++) {
+            const auto eol = text.find('\n', text.size() * p / pieces);
+            if (eol == std::string::npos) break;
+            bounds.push_back(std::max<const char*>(bounds.back(), text.data() + eol + 1));
+        }
+        bounds.push_back(text.data() + text.size());
+
+        std::vector<SensorsData> parsed(bounds.size() - 1);
+        std::vector<std::string> bad(parsed.size());
+        std::atomic<bool> ok{true};
+        parallelFor(parsed.size(), threads, [&](size_t p) {
+            if (!parseLines(bounds[p], bounds[p + 1], parsed[p], bad[p])) ok = false;
+        });
+        if (!ok) {
+            for (const auto& b: bad) {
+                if (!b.empty()) {
+                    error = "wrong TSV line: \"" + b + "\"";
+                    break;
+                }
+            }
+            return false;
+        }
+        for (auto& p: parsed) data.append(std::move(p));
+        return more;
+    }
+
+    std::istream& in;
+    Format format;
+    const std::array<std::shared_ptr<const std::vector<float>>, 4>& lut;
+    const std::array<float, 4>& gain;
+    const std::array<float, 4>& offset;
+    size_t channels = 0;
+    std::vector<char> buf;
+    std::string carry;
+};
+
+void format(const SensorsData& data, size_t channels, TimeSwipeConverter::Format format, std::string& out) {
+    const size_t n = data.DataSize();
+    if (format == TimeSwipeConverter::Format::F32) {
+        out.resize(n * SENSORS * sizeof(float));
+        char* p = &out[0];
+        for (size_t i = 0; i < n; i++) {
+            for (size_t c = 0; c < SENSORS; c++) {
+                const float v = c < channels ? data[c][i] : 0;
+                std::memcpy(p, &v, sizeof(v));
+                p += sizeof(v);
+            }
+        }
+        return;
+    }
+
+    // the shortest text every float value is read back exactly from
+    out.clear();
+    out.reserve(n * channels * 16);
+    char buf[32];
+    for (size_t i = 0; i < n; i++) {
+        for (size_t c = 0; c < channels; c++) {
+            if (c != 0) out += '\t';
+            out.append(buf, std::snprintf(buf, sizeof(buf), "%.9g", data[c][i]));
+        }
+        out += '\n';
+    }
+}
+
+}
+
+bool TimeSwipeConverter::ParseFormat(const std::string& name, Format& format) {
+    if (name == "tsv") format = Format::TSV;
+    else if (name == "f32") format = Format::F32;
+    else if (name == "raw16") format = Format::RAW16;
+    else return false;
+    return true;
+}
+
+bool TimeSwipeConverter::SetSampleRates(int input, int output) {
+    if (input < 1 || output < 1) return false;
+    inputRate = input;
+    outputRate = output;
+    return true;
+}
+
+bool TimeSwipeConverter::SetSensorLinear(uint8_t num, int offset, float mfactor) {
+    if (num >= lut.size()) return false;
+    lut[num] = TimeSwipeCalibration::Linear(offset, mfactor);
+    return true;
+}
+
+bool TimeSwipeConverter::SetSensorPolynomial(uint8_t num, const std::vector<double>& coeffs) {
+    if (num >= lut.size() || coeffs.empty()) return false;
+    lut[num] = TimeSwipeCalibration::Polynomial(coeffs);
+    return true;
+}
+
+bool TimeSwipeConverter::SetSensorScale(uint8_t num, float g, float o) {
+    if (num >= gain.size()) return false;
+    gain[num] = g;
+    offset[num] = o;
+    return true;
+}
+
+void TimeSwipeConverter::SetThreads(unsigned t) {
+    threads = t;
+}
+
+void TimeSwipeConverter::SetChunkSize(size_t samples) {
+    chunkSize = std::max<size_t>(samples, 1);
+}
+
+void TimeSwipeConverter::SetSerial(bool s) {
+    serial = s;
+}
+
+uint64_t TimeSwipeConverter::Convert(std::istream& in, Format inFormat, std::ostream& out, Format outFormat, std::string& error) {
+    error.clear();
+    if (outFormat == Format::RAW16) {
+        error = "raw16 output is not supported";
+        return 0;
+    }
+
+    const unsigned nthreads = serial ? 1 : threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+    const bool resample = inputRate != outputRate;
+    auto newResampler = [&] { return std::make_unique<TimeSwipeResampler>(outputRate, inputRate); };
+    auto resampler = resample ? newResampler() : nullptr;
+    const size_t slice = resampler ? resampler->SliceSize() : 1;
+    const size_t overlap = resampler ? 2 * resampler->Pad() : 0;
+    const size_t chunk = (chunkSize + slice - 1) / slice * slice;
+
+    Reader reader(in, inFormat, lut, gain, offset);
+    SensorsData pending;
+    uint64_t total = 0;
+    std::vector<std::string> outputs;
+    bool more = true;
+    while (more) {
+        const size_t before = pending.DataSize();
+        more = reader.Read(chunk * nthreads, pending, nthreads, error);
+        if (!error.empty()) return 0;
+        total += pending.DataSize() - before;
+        const size_t channels = reader.Channels();
+
+        if (serial) {
+            std::string text;
+            for (size_t b = 0; b < pending.DataSize(); b += SERIAL_BLOCK) {
+                auto block = range(pending, channels, b, std::min(pending.DataSize(), b + SERIAL_BLOCK));
+                format(resampler ? resampler->Resample(std::move(block)) : block, channels, outFormat, text);
+                out.write(text.data(), text.size());
+            }
+            if (!more && resampler) {
+                format(resampler->Flush(), channels, outFormat, text);
+                out.write(text.data(), text.size());
+            }
+            pending.clear();
+            continue;
+        }
+
+        // the input samples the output can be made for: complete slices followed by their padding
+        const size_t avail = pending.DataSize();
+        const size_t usable = avail >= overlap ? (avail - overlap) / slice * slice : 0;
+        outputs.assign((usable + chunk - 1) / chunk, std::string());
+        parallelFor(outputs.size(), nthreads, [&](size_t i) {
+            const size_t begin = i * chunk;
+            const size_t end = std::min(usable, begin + chunk);
+            if (!resample) {
+                format(range(pending, channels, begin, end), channels, outFormat, outputs[i]);
+                return;
+            }
+            // a new stream over the chunk and its padding, by slices to keep the resampler buffer short
+            auto r = newResampler();
+            SensorsData res;
+            for (size_t b = begin; b < end + overlap; b += slice) {
+                res.append(r->Resample(range(pending, channels, b, std::min(end + overlap, b + slice))));
+            }
+            format(res, channels, outFormat, outputs[i]);
+        });
+        for (const auto& o: outputs) out.write(o.data(), o.size());
+        pending.erase_front(usable);
+
+        // the rest of the input: the single pass has the same samples in its resampler buffer at the end
+        if (!more && resample) {
+            auto r = newResampler();
+            SensorsData res;
+            for (size_t b = 0; b < pending.DataSize(); b += slice) {
+                res.append(r->Resample(range(pending, channels, b, std::min(pending.DataSize(), b + slice))));
+            }
+            res.append(r->Flush());
+            std::string text;
+            format(res, channels, outFormat, text);
+            out.write(text.data(), text.size());
+        }
+    }
+    if (!out) {
+        error = "output write failed";
+        return 0;
+    }
+    return total;
+}
@@ -0,0 +1,106 @@
+#include "timeswipe_degradation.hpp"
+#include "timeswipe_resource.hpp"
+#include <algorithm>
+
+void TimeSwipeDegradation::Reset() {
+    level = Level::None;
+    lagging = false;
+    recovering = false;
+    inDone = 0;
+    outDone = 0;
+    resetWindows();
+}
+
+void TimeSwipeDegradation::resetWindows() {
+    // a partial window is dropped on a level change
+    phase = 0;
+    windows.fill(Window());
+}
+
+bool TimeSwipeDegradation::Update(double fill, Clock::time_point now) {
+    if (fill > LAG_FILL) {
+        recovering = false;
+        if (!lagging) {
+            lagging = true;
+            lagSince = now;
+        } else if (now - lagSince >= LAG_TIME && level != Level::Envelope) {
+            level = Level(int(level) + 1);
+            lagSince = now;
+            resetWindows();
+            return true;
+        }
+    } else if (fill < RECOVER_FILL) {
+        lagging = false;
+        if (!recovering) {
+            recovering = true;
+            recoverSince = now;
+        } else if (now - recoverSince >= RECOVER_TIME && level != Level::None) {
+            level = Level(int(level) - 1);
+            recoverSince = now;
+            resetWindows();
+            return true;
+        }
+    } else {
+        lagging = false;
+        recovering = false;
+    }
+    return false;
+}
+
+SensorsData TimeSwipeDegradation::Process(SensorsData&& data) {
+    const uint64_t n = data.DataSize();
+
+    if (level == Level::None || level == Level::Batch) {
+        // a reduced period before shifts the delivered indexes
+        for (auto& m: data.markers()) {
+            m.sample = outDone + (m.sample > inDone ? m.sample - inDone : 0);
+        }
+        inDone += n;
+        outDone += n;
+        return std::move(data);
+    }
+
+    const bool envelope = level == Level::Envelope;
+    const size_t window = envelope ? ENVELOPE_WINDOW : DECIMATION;
+    const size_t perWindow = envelope ? 2 : 1;
+
+    SensorsData out = makeSensorsData(memoryResourceOf(data));
+    for (size_t s = 0; s < data.SensorsSize(); s++) {
+        const auto& in = data[s];
+        if (in.empty()) continue;
+
+        auto& w = windows[s];
+        auto& o = out[s];
+        o.reserve((phase + in.size()) / window * perWindow);
+        size_t count = phase;
+        for (auto v: in) {
+            if (count == 0) {
+                w.sum = 0;
+                w.min = v;
+                w.max = v;
+            }
+            w.sum += v;
+            w.min = std::min(w.min, v);
+            w.max = std::max(w.max, v);
+            if (++count == window) {
+                if (envelope) {
+                    o.push_back(w.min);
+                    o.push_back(w.max);
+                } else {
+                    o.push_back(w.sum / window);
+                }
+                count = 0;
+            }
+        }
+    }
+
+    for (auto& m: data.markers()) {
+        const uint64_t pos = m.sample > inDone ? m.sample - inDone : 0;
+        out.markers().push_back({outDone + (phase + pos) / window * perWindow, std::move(m.event)});
+    }
+
+    phase = (phase + n) % window;
+    inDone += n;
+    outDone += out.DataSize();
+    return out;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include "timeswipe.hpp"
+
+// The degradation policy of the poller: watches the record queue fill and reduces the delivered stream
+// while the consumer lags behind
+class TimeSwipeDegradation {
+public:
+    using Level = TimeSwipe::Degradation;
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t DECIMATION = 8;
+    static constexpr size_t ENVELOPE_WINDOW = 64;
+
+    // the queue fill (0..1) to start degrading and the time it has to be exceeded
+    static constexpr double LAG_FILL = 0.1;
+    static constexpr std::chrono::milliseconds LAG_TIME{250};
+    // the queue fill (0..1) to start recovering and the time it has to be held
+    static constexpr double RECOVER_FILL = 0.02;
+    static constexpr std::chrono::milliseconds RECOVER_TIME{2000};
+
+    // a new stream at Level::None
+    void Reset();
+
+    // the queue fill seen by the poller before popping, returns true if the level changed
+    bool Update(double fill, Clock::time_point now = Clock::now());
+
+    Level GetLevel() const { return level; }
+
+    // reduces the data to the current level and maps its markers to the delivered stream
+    SensorsData Process(SensorsData&& data);
+
+private:
+    struct Window {
+        float sum = 0;
+        float min = 0;
+        float max = 0;
+    };
+
+    void resetWindows();
+
+    Level level = Level::None;
+    Clock::time_point lagSince;
+    Clock::time_point recoverSince;
+    bool lagging = false;
+    bool recovering = false;
+
+    // samples in the current window
+    size_t phase = 0;
+    std::array<Window, 4> windows;
+    // samples taken in and delivered so far
+    uint64_t inDone = 0;
+    uint64_t outDone = 0;
+};
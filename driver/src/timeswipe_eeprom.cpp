@@ -1,72 +1,224 @@
 #include "timeswipe_eeprom.hpp"
 #include "HatsMemMan.h"
 #include "defs.h"
+#include <algorithm>
 #include <memory>
 #include <fstream>
+#include <nlohmann/json.hpp>
 
-bool TimeSwipeEEPROM::Read(std::string& error) {
-#if NOT_RPI
-    return true;
-#endif
-    const char* i2c_file = "/sys/class/i2c-adapter/i2c-0/0-0050/eeprom";
-    std::ifstream i2c(i2c_file);
-    if (!i2c.is_open()) {
-        //echo "24c32 0x50" > /sys/class/i2c-adapter/i2c-0/new_device
-        std::ofstream ofs("/sys/class/i2c-adapter/i2c-0/new_device");
-        if (!ofs.is_open()) {
-            error = "Can not access i2c subsystem. Check drivers are properly loaded";
-            return false;
-        }
-        std::string cmd_buf = "24c32 0x50\n";
-        ofs.write(cmd_buf.c_str(), cmd_buf.length());
-        ofs.close();
-        if (!ofs) {
-            error = "Create i2c failed. Check permissions";
-            return false;
+namespace {
+
+const char* MODE_NAMES[TimeSwipeEEPROM::MODES] = {"Primary", "Norm", "Digital"};
+
+// the vendor info atom comes first; the GPIO map one may follow, the default image of the firmware has none
+constexpr unsigned FIRST_CUSTOM_ATOM = 1;
+
+std::shared_ptr<const TimeSwipeCalibration::Table> parseCalibration(const nlohmann::json& j) {
+    if (j.is_null()) return nullptr;
+    if (j.contains("linear")) {
+        const auto& l = j.at("linear");
+        return TimeSwipeCalibration::Linear(l.at(0).get<int>(), l.at(1).get<float>());
+    }
+    if (j.contains("polynomial")) {
+        auto table = TimeSwipeCalibration::Polynomial(j.at("polynomial").get<std::vector<double>>());
+        if (!table) throw std::invalid_argument("empty polynomial");
+        return table;
+    }
+    if (j.contains("piecewise")) {
+        auto table = TimeSwipeCalibration::Piecewise(j.at("piecewise").get<std::vector<std::pair<uint16_t, float>>>());
+        if (!table) throw std::invalid_argument("empty piecewise");
+        return table;
+    }
+    throw std::invalid_argument("unknown calibration " + j.dump());
+}
+
+int parseMode(const std::string& name) {
+    for (size_t i = 0; i < TimeSwipeEEPROM::MODES; i++) {
+        if (name == MODE_NAMES[i]) return i;
+    }
+    throw std::invalid_argument("unknown mode \"" + name + "\"");
+}
+
+bool parseSettings(const std::string& data, TimeSwipeEEPROM::Settings& settings, std::string& error) {
+    try {
+        const auto j = nlohmann::json::parse(data);
+        TimeSwipeEEPROM::Settings res;
+        if (j.contains("mode")) res.mode = parseMode(j.at("mode").get<std::string>());
+        if (j.contains("profiles")) {
+            for (const auto& p: j.at("profiles").items()) {
+                auto& profile = res.profiles[parseMode(p.key())].emplace();
+                const auto& v = p.value();
+                if (v.contains("offsets")) profile.offsets = v.at("offsets").get<std::array<int, 4>>();
+                if (v.contains("gains")) profile.gains = v.at("gains").get<std::array<float, 4>>();
+                if (v.contains("transmissions")) profile.transmissions = v.at("transmissions").get<std::array<float, 4>>();
+                if (v.contains("calibration")) {
+                    const auto& c = v.at("calibration");
+                    if (c.size() > profile.calibration.size()) throw std::invalid_argument("too many calibrations");
+                    for (size_t i = 0; i < c.size(); i++) profile.calibration[i] = parseCalibration(c.at(i));
+                }
+            }
         }
-        i2c.open(i2c_file, std::ifstream::in);
-        if (!i2c.is_open()) {
-            error = "Can not access i2c subsystem. Check drivers are properly loaded";
-            return false;
+        settings = std::move(res);
+    } catch (const std::exception& e) {
+        error = std::string("wrong settings atom: ") + e.what();
+        return false;
+    }
+    return true;
+}
+
+bool isSettings(const std::string& data) {
+    const auto j = nlohmann::json::parse(data, nullptr, false);
+    return j.is_object() && j.contains("timeswipe");
+}
+
+// the index of the settings atom, the atoms count if there is none
+unsigned findSettings(CHatsMemMan& man, std::string* data) {
+    const unsigned count = man.GetAtomsCount();
+    for (unsigned i = FIRST_CUSTOM_ATOM; i < count; i++) {
+        // the other atom types fail to load as a custom one
+        CHatAtomCustom atom(i);
+        if (man.Load(atom) == CHatsMemMan::OK && isSettings(atom.m_data)) {
+            if (data) *data = std::move(atom.m_data);
+            return i;
         }
     }
-    std::string str((std::istreambuf_iterator<char>(i2c)),
-            std::istreambuf_iterator<char>());
-    if (str.length() > 127) str.resize(127);
+    return count;
+}
+
+bool openDevice(std::fstream& i2c, std::ios::openmode mode, std::string& error) {
+    i2c.open(TimeSwipeEEPROM::DEVICE, mode);
+    if (i2c.is_open()) return true;
+    //echo "24c32 0x50" > /sys/class/i2c-adapter/i2c-0/new_device
+    std::ofstream ofs("/sys/class/i2c-adapter/i2c-0/new_device");
+    if (!ofs.is_open()) {
+        error = "Can not access i2c subsystem. Check drivers are properly loaded";
+        return false;
+    }
+    std::string cmd_buf = "24c32 0x50\n";
+    ofs.write(cmd_buf.c_str(), cmd_buf.length());
+    ofs.close();
+    if (!ofs) {
+        error = "Create i2c failed. Check permissions";
+        return false;
+    }
+    i2c.open(TimeSwipeEEPROM::DEVICE, mode);
+    if (!i2c.is_open()) {
+        error = "Can not access i2c subsystem. Check drivers are properly loaded";
+        return false;
+    }
+    return true;
+}
+
+bool openImage(const std::string& path, std::fstream& f, std::ios::openmode mode, std::string& error) {
+    if (path == TimeSwipeEEPROM::DEVICE) return openDevice(f, mode, error);
+    f.open(path, mode);
+    if (!f.is_open()) {
+        error = "Can not open EEPROM image \"" + path + "\"";
+        return false;
+    }
+    return true;
+}
+
+// the i2c reads are slow: the header tells the image size, only the image is read, not the whole chip
+std::string readImage(std::istream& in) {
+    const size_t header = CHatsMemMan::GetHeaderSize();
+    std::string image(header, '\0');
+    in.read(&image[0], image.size());
+    image.resize(in.gcount());
+
+    auto buf = std::make_shared<CFIFO>();
+    *buf += image;
+    CHatsMemMan man(buf);
+    // a corrupted header may declare any size
+    const size_t size = std::min<size_t>(std::max(man.GetImageSize(), 0), TimeSwipeEEPROM::CHIP_SIZE);
+    if (image.size() == header && size > header) {
+        image.resize(size);
+        in.read(&image[header], size - header);
+        image.resize(header + in.gcount());
+    }
+    return image;
+}
+
+}
+
+bool TimeSwipeEEPROM::Read(Settings& settings, std::string& error, const std::string& path) {
+    settings = Settings();
+#if NOT_RPI
+    if (path == DEVICE) return true;
+#endif
+    std::fstream i2c;
+    if (!openImage(path, i2c, std::ios::in | std::ios::binary, error)) return false;
+    return Parse(readImage(i2c), settings, error);
+}
+
+bool TimeSwipeEEPROM::Parse(const std::string& image, Settings& settings, std::string& error) {
     auto buf = std::make_shared<CFIFO>();
-    *buf += str;
+    *buf += image;
     CHatsMemMan HatMan(buf);
 
     //The image has to be verified before use: Verify() methode will check the image consistency and CRCs of the atoms
-    CHatsMemMan::op_result res;
-    res = HatMan.Verify();
-    if (res != CHatsMemMan::OK) {
+    if (HatMan.Verify() != CHatsMemMan::OK) {
         error = "EEPROM verify failed";
         return false;
     }
 
-    //The number of atoms can be obtained as following (optional)
-    unsigned int nAtoms = HatMan.GetAtomsCount();
+    std::string data;
+    if (findSettings(HatMan, &data) == HatMan.GetAtomsCount()) {
+        settings = Settings();
+        return true;
+    }
+    return parseSettings(data, settings, error);
+}
 
-    //Then obligatory atoms can be obtained:
-    CHatAtomVendorInfo vi;
-    CHatAtomGPIOmap gpio;
+bool TimeSwipeEEPROM::Store(std::string& image, const std::string& json, std::string& error) {
+    Settings settings;
+    if (!isSettings(json)) {
+        error = "wrong settings atom: \"timeswipe\" is missing";
+        return false;
+    }
+    if (!parseSettings(json, settings, error)) return false;
 
-    res = HatMan.Load(vi);
-    res = HatMan.Load(gpio);
+    auto buf = std::make_shared<CFIFO>();
+    *buf += image;
+    CHatsMemMan HatMan(buf);
+    if (HatMan.Verify() != CHatsMemMan::OK) {
+        error = "EEPROM verify failed";
+        return false;
+    }
+    CHatAtomCustom atom(findSettings(HatMan, nullptr));
+    atom.m_data = nlohmann::json::parse(json).dump();
+    if (HatMan.Store(atom) != CHatsMemMan::OK) {
+        error = "EEPROM settings atom store failed";
+        return false;
+    }
+    if (buf->size() > IMAGE_SIZE_MAX) {
+        error = "EEPROM image too large: " + std::to_string(buf->size()) + " bytes, the board reads " +
+                std::to_string(IMAGE_SIZE_MAX) + " at most";
+        return false;
+    }
+    image.assign(buf->data(), buf->size());
+    return true;
+}
 
-    /*
-    printf("uuid: %x-%x-%x-%x\n", vi.m_uuid[0], vi.m_uuid[1], vi.m_uuid[2], vi.m_uuid[3]);
-    printf("pid: 0x%x\n", vi.m_PID);
-    printf("vstr: %s\n", vi.m_vstr.c_str());
-    printf("pstr: %s\n", vi.m_pstr.c_str());
-    printf("GPIO:\n");
-    for (int i = 0; i < 28; i++) {
-        const auto& g = gpio.m_GPIO[i];
-        printf("%d: func_sel: %u reserved: %u pulltype: %u is_used: %u\n", i + 2, g.func_sel, g.reserved, g.pulltype, g.is_used);
+bool TimeSwipeEEPROM::Write(const std::string& json, std::string& error, const std::string& path) {
+#if NOT_RPI
+    if (path == DEVICE) {
+        error = "no EEPROM in the emulation";
+        return false;
     }
-     */
+#endif
+    std::fstream f;
+    if (!openImage(path, f, std::ios::in | std::ios::out | std::ios::binary, error)) return false;
+    std::string image = readImage(f);
+    if (!Store(image, json, error)) return false;
 
+    f.clear();
+    f.seekp(0);
+    f.write(image.data(), image.size());
+    f.flush();
+    if (!f) {
+        error = "EEPROM write failed";
+        return false;
+    }
     return true;
-
 }
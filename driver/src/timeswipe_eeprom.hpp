@@ -1,6 +1,51 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <optional>
 #include <string>
+#include "timeswipe_calibration.hpp"
 
+// The HAT EEPROM image: the vendor info and GPIO map atoms followed by the custom ones.
+// The driver settings atom is a custom atom holding JSON:
+// {"timeswipe": 1, "mode": "Norm",
+//  "profiles": {"Norm": {"offsets": [4 ints], "gains": [4 floats], "transmissions": [4 floats],
+//                        "calibration": [null, {"linear": [offset, mfactor]}, {"polynomial": [coeffs]}, {"piecewise": [[raw, value]...]}]}}}
+// every member but "timeswipe" is optional, the profiles are named after TimeSwipe::Mode values
 class TimeSwipeEEPROM {
 public:
-    static bool Read(std::string& error);
-};
\ No newline at end of file
+    static constexpr const char* DEVICE = "/sys/class/i2c-adapter/i2c-0/0-0050/eeprom";
+    static constexpr size_t MODES = 3;
+    // the chip (24c32) size, the image size the header declares is cut to it
+    static constexpr size_t CHIP_SIZE = 4096;
+    // the firmware reads the image up to this size, a larger one is taken as corrupted and replaced by the default
+    static constexpr size_t IMAGE_SIZE_MAX = 1024;
+
+    // the sensor settings of a hardware mode
+    struct Profile {
+        std::optional<std::array<int, 4>> offsets;
+        std::optional<std::array<float, 4>> gains;
+        std::optional<std::array<float, 4>> transmissions;
+        // nullptr for the sensors without the calibration
+        std::array<std::shared_ptr<const TimeSwipeCalibration::Table>, 4> calibration;
+    };
+
+    struct Settings {
+        // the mode to start in, -1 if not stored
+        int mode = -1;
+        // indexed by mode
+        std::array<std::optional<Profile>, MODES> profiles;
+    };
+
+    // reads the whole image, the settings stay empty if there is no settings atom
+    static bool Read(Settings& settings, std::string& error, const std::string& path = DEVICE);
+
+    // the settings of the image
+    static bool Parse(const std::string& image, Settings& settings, std::string& error);
+
+    // adds the settings atom to the image or replaces it, json is the atom content;
+    // fails if the image would be larger than IMAGE_SIZE_MAX
+    static bool Store(std::string& image, const std::string& json, std::string& error);
+
+    // stores the settings atom into the image of the chip or of the file at path
+    static bool Write(const std::string& json, std::string& error, const std::string& path = DEVICE);
+};
@@ -10,7 +10,8 @@ class TimeSwipeEventImpl {
         TimeSwipeEvent::Bridge,
         TimeSwipeEvent::Record,
         TimeSwipeEvent::Offset,
-        TimeSwipeEvent::Mode
+        TimeSwipeEvent::Mode,
+        TimeSwipeEvent::Setting
         > events;
     friend class TimeSwipeEvent;
 };
@@ -82,6 +83,18 @@ int TimeSwipeEvent::Mode::value() const {
     return _value;
 }
 
+TimeSwipeEvent::Setting::Setting(std::string _name, std::string _value)
+    : _name(std::move(_name))
+    , _value(std::move(_value))
+{
+}
+const std::string& TimeSwipeEvent::Setting::name() const {
+    return _name;
+}
+const std::string& TimeSwipeEvent::Setting::value() const {
+    return _value;
+}
+
 template <class EVENT>
 bool TimeSwipeEvent::is() const {
     return std::holds_alternative<EVENT>(_impl->events);
@@ -93,6 +106,7 @@ template bool TimeSwipeEvent::is<TimeSwipeEvent::Bridge>() const;
 template bool TimeSwipeEvent::is<TimeSwipeEvent::Record>() const;
 template bool TimeSwipeEvent::is<TimeSwipeEvent::Offset>() const;
 template bool TimeSwipeEvent::is<TimeSwipeEvent::Mode>() const;
+template bool TimeSwipeEvent::is<TimeSwipeEvent::Setting>() const;
 
 template <class EVENT>
 const EVENT& TimeSwipeEvent::get() const {
@@ -106,6 +120,7 @@ template const TimeSwipeEvent::Bridge& TimeSwipeEvent::get<TimeSwipeEvent::Bridg
 template const TimeSwipeEvent::Record& TimeSwipeEvent::get<TimeSwipeEvent::Record>() const;
 template const TimeSwipeEvent::Offset& TimeSwipeEvent::get<TimeSwipeEvent::Offset>() const;
 template const TimeSwipeEvent::Mode& TimeSwipeEvent::get<TimeSwipeEvent::Mode>() const;
+template const TimeSwipeEvent::Setting& TimeSwipeEvent::get<TimeSwipeEvent::Setting>() const;
 
 template <class EVENT>
 TimeSwipeEvent::TimeSwipeEvent(EVENT&& ev)
@@ -120,6 +135,7 @@ template TimeSwipeEvent::TimeSwipeEvent(TimeSwipeEvent::Bridge&& ev);
 template TimeSwipeEvent::TimeSwipeEvent(TimeSwipeEvent::Record&& ev);
 template TimeSwipeEvent::TimeSwipeEvent(TimeSwipeEvent::Offset&& ev);
 template TimeSwipeEvent::TimeSwipeEvent(TimeSwipeEvent::Mode&& ev);
+template TimeSwipeEvent::TimeSwipeEvent(TimeSwipeEvent::Setting&& ev);
 
 template <class EVENT>
 TimeSwipeEvent::TimeSwipeEvent(const EVENT& ev)
@@ -134,3 +150,4 @@ template TimeSwipeEvent::TimeSwipeEvent(TimeSwipeEvent::Bridge& ev);
 template TimeSwipeEvent::TimeSwipeEvent(TimeSwipeEvent::Record& ev);
 template TimeSwipeEvent::TimeSwipeEvent(TimeSwipeEvent::Offset& ev);
 template TimeSwipeEvent::TimeSwipeEvent(TimeSwipeEvent::Mode& ev);
+template TimeSwipeEvent::TimeSwipeEvent(TimeSwipeEvent::Setting& ev);
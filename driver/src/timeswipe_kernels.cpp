@@ -0,0 +1,182 @@
+#include "timeswipe_kernels.hpp"
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+// 32-bit ARM builds get the NEON variant only when compiled with -mfpu=neon
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#define KERNELS_NEON 1
+#include <arm_neon.h>
+#if !defined(__aarch64__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#endif
+
+namespace {
+
+// the final sum of the 8 lanes, every variant reduces in this order
+inline float reduce8(const float l[8]) {
+    return ((l[0] + l[4]) + (l[2] + l[6])) + ((l[1] + l[5]) + (l[3] + l[7]));
+}
+
+void scaleScalar(const uint16_t* raw, size_t count, int offset, float mfactor, float* out) {
+    for (size_t i = 0; i < count; i++) out[i] = (float)(int(raw[i]) - offset) * mfactor;
+}
+
+float dotScalar(const float* x, const float* h, size_t count) {
+    float l[8] = {};
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        for (size_t k = 0; k < 8; k++) l[k] += x[i + k] * h[i + k];
+    }
+    float acc = reduce8(l);
+    for (; i < count; i++) acc += x[i] * h[i];
+    return acc;
+}
+
+#ifdef KERNELS_X86
+__attribute__((target("sse4.1")))
+inline float reduceSse(__m128 lo, __m128 hi) {
+    __m128 s = _mm_add_ps(lo, hi);
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+}
+
+__attribute__((target("sse4.1")))
+void scaleSse4(const uint16_t* raw, size_t count, int offset, float mfactor, float* out) {
+    const __m128i off = _mm_set1_epi32(offset);
+    const __m128 mf = _mm_set1_ps(mfactor);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(raw + i));
+        __m128i lo = _mm_sub_epi32(_mm_cvtepu16_epi32(v), off);
+        __m128i hi = _mm_sub_epi32(_mm_cvtepu16_epi32(_mm_srli_si128(v, 8)), off);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), mf));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), mf));
+    }
+    scaleScalar(raw + i, count - i, offset, mfactor, out + i);
+}
+
+__attribute__((target("sse4.1")))
+float dotSse4(const float* x, const float* h, size_t count) {
+    __m128 lo = _mm_setzero_ps();
+    __m128 hi = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        lo = _mm_add_ps(lo, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(h + i)));
+        hi = _mm_add_ps(hi, _mm_mul_ps(_mm_loadu_ps(x + i + 4), _mm_loadu_ps(h + i + 4)));
+    }
+    float acc = reduceSse(lo, hi);
+    for (; i < count; i++) acc += x[i] * h[i];
+    return acc;
+}
+
+__attribute__((target("avx2")))
+void scaleAvx2(const uint16_t* raw, size_t count, int offset, float mfactor, float* out) {
+    const __m256i off = _mm256_set1_epi32(offset);
+    const __m256 mf = _mm256_set1_ps(mfactor);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(raw + i)));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(v, off)), mf));
+    }
+    scaleScalar(raw + i, count - i, offset, mfactor, out + i);
+}
+
+__attribute__((target("avx2")))
+float dotAvx2(const float* x, const float* h, size_t count) {
+    __m256 l = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        l = _mm256_add_ps(l, _mm256_mul_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(h + i)));
+    }
+    float acc = reduceSse(_mm256_castps256_ps128(l), _mm256_extractf128_ps(l, 1));
+    for (; i < count; i++) acc += x[i] * h[i];
+    return acc;
+}
+#endif
+
+#ifdef KERNELS_NEON
+void scaleNeon(const uint16_t* raw, size_t count, int offset, float mfactor, float* out) {
+    const int32x4_t off = vdupq_n_s32(offset);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint16x8_t v = vld1q_u16(raw + i);
+        int32x4_t lo = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(v))), off);
+        int32x4_t hi = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(v))), off);
+        vst1q_f32(out + i, vmulq_n_f32(vcvtq_f32_s32(lo), mfactor));
+        vst1q_f32(out + i + 4, vmulq_n_f32(vcvtq_f32_s32(hi), mfactor));
+    }
+    scaleScalar(raw + i, count - i, offset, mfactor, out + i);
+}
+
+float dotNeon(const float* x, const float* h, size_t count) {
+    float32x4_t lo = vdupq_n_f32(0);
+    float32x4_t hi = vdupq_n_f32(0);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        lo = vaddq_f32(lo, vmulq_f32(vld1q_f32(x + i), vld1q_f32(h + i)));
+        hi = vaddq_f32(hi, vmulq_f32(vld1q_f32(x + i + 4), vld1q_f32(h + i + 4)));
+    }
+    float32x4_t s = vaddq_f32(lo, hi);
+    float32x2_t t = vadd_f32(vget_low_f32(s), vget_high_f32(s));
+    float acc = vget_lane_f32(t, 0) + vget_lane_f32(t, 1);
+    for (; i < count; i++) acc += x[i] * h[i];
+    return acc;
+}
+#endif
+
+// the best variant goes first
+const TimeSwipeKernels KERNELS[] = {
+#ifdef KERNELS_X86
+    {"avx2", scaleAvx2, dotAvx2},
+    {"sse4", scaleSse4, dotSse4},
+#endif
+#ifdef KERNELS_NEON
+    {"neon", scaleNeon, dotNeon},
+#endif
+    {"scalar", scaleScalar, dotScalar},
+};
+
+bool isSupported(const TimeSwipeKernels& k) {
+#ifdef KERNELS_X86
+    __builtin_cpu_init();
+    if (!strcmp(k.name, "avx2")) return __builtin_cpu_supports("avx2");
+    if (!strcmp(k.name, "sse4")) return __builtin_cpu_supports("sse4.1");
+#endif
+#if defined(KERNELS_NEON) && !defined(__aarch64__)
+    if (!strcmp(k.name, "neon")) return getauxval(AT_HWCAP) & HWCAP_NEON;
+#endif
+    return true;
+}
+
+const TimeSwipeKernels& select() {
+    const char* forced = getenv("TIMESWIPE_KERNELS");
+    if (forced) {
+        auto k = TimeSwipeKernels::Find(forced);
+        if (k) return *k;
+    }
+    for (const auto& k: KERNELS) {
+        if (isSupported(k)) return k;
+    }
+    return KERNELS[sizeof(KERNELS) / sizeof(KERNELS[0]) - 1];
+}
+
+}
+
+const TimeSwipeKernels* TimeSwipeKernels::Find(const char* name) {
+    for (const auto& k: KERNELS) {
+        if (!strcmp(k.name, name)) return isSupported(k) ? &k : nullptr;
+    }
+    return nullptr;
+}
+
+const TimeSwipeKernels& TimeSwipeKernels::Get() {
+    static const TimeSwipeKernels& kernels = select();
+    return kernels;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// CPU-specific implementations of the hot data path kernels.
+// The implementation is picked once at startup from the detected CPU features.
+// All variants give bit-identical results: the sums use the same 8-lane order and no FMA.
+struct TimeSwipeKernels {
+    const char* name;
+
+    // out[i] = (raw[i] - offset) * mfactor, the decoder scaling
+    void (*scale)(const uint16_t* raw, size_t count, int offset, float mfactor, float* out);
+
+    // sum of x[i] * h[i], the resampler FIR inner loop
+    float (*dot)(const float* x, const float* h, size_t count);
+
+    // the best kernels for this CPU,
+    // TIMESWIPE_KERNELS environment variable may force "scalar", "sse4", "avx2" or "neon"
+    static const TimeSwipeKernels& Get();
+
+    // kernels by name, nullptr if unknown or not supported by this CPU
+    static const TimeSwipeKernels* Find(const char* name);
+};
@@ -0,0 +1,88 @@
+#include "timeswipe_latency.hpp"
+#include <algorithm>
+
+TimeSwipeLatency LatencyDistribution(std::vector<float> us) {
+    TimeSwipeLatency res;
+    if (us.empty()) return res;
+
+    std::sort(us.begin(), us.end());
+    auto at = [&](double q) { return us[size_t(q * (us.size() - 1) + 0.5)]; };
+    res.min_us = us.front();
+    res.p50_us = at(0.5);
+    res.p90_us = at(0.9);
+    res.p99_us = at(0.99);
+    res.max_us = us.back();
+    return res;
+}
+
+void TimeSwipeLatencyTracker::Reset() {
+    samples = 0;
+    blocks.clear();
+    ready = false;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    count = 0;
+    history.clear();
+}
+
+void TimeSwipeLatencyTracker::Popped(const Stamps& stamps, size_t n, Clock::time_point popped) {
+    if (n == 0) return;
+    samples += n;
+    blocks.push_back({samples, stamps, popped});
+}
+
+void TimeSwipeLatencyTracker::Ready(uint64_t first, Clock::time_point time) {
+    if (ready) return;
+    ready = true;
+    readyFirst = first;
+    readyTime = time;
+}
+
+void TimeSwipeLatencyTracker::Delivered(Clock::time_point now) {
+    if (!ready) return;
+    ready = false;
+
+    // the blocks before the one holding the oldest sample are delivered already
+    while (!blocks.empty() && blocks.front().end <= readyFirst) blocks.pop_front();
+    if (blocks.empty()) return;
+    const auto& b = blocks.front();
+
+    auto us = [](Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<float, std::micro>(to - from).count();
+    };
+    std::array<float, STAGES> stages;
+    stages[READ] = us(b.stamps.read, b.stamps.captured);
+    stages[FETCH] = us(b.stamps.captured, b.stamps.queued);
+    stages[QUEUE] = us(b.stamps.queued, b.popped);
+    stages[PROCESS] = us(b.popped, readyTime);
+    stages[BURST] = us(readyTime, now);
+    stages[TOTAL] = us(b.stamps.read, now);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if (history.size() < HISTORY_SIZE) {
+        history.push_back(stages);
+    } else {
+        history[count % HISTORY_SIZE] = stages;
+    }
+    count++;
+}
+
+TimeSwipeLatencyStats TimeSwipeLatencyTracker::Stats() {
+    TimeSwipeLatencyStats res;
+    std::array<std::vector<float>, STAGES> stages;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        res.count = count;
+        for (auto& s: stages) s.reserve(history.size());
+        for (const auto& h: history) {
+            for (size_t i = 0; i < STAGES; i++) stages[i].push_back(h[i]);
+        }
+    }
+    res.read = LatencyDistribution(std::move(stages[READ]));
+    res.fetch = LatencyDistribution(std::move(stages[FETCH]));
+    res.queue = LatencyDistribution(std::move(stages[QUEUE]));
+    res.process = LatencyDistribution(std::move(stages[PROCESS]));
+    res.burst = LatencyDistribution(std::move(stages[BURST]));
+    res.total = LatencyDistribution(std::move(stages[TOTAL]));
+    return res;
+}
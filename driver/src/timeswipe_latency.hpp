@@ -0,0 +1,66 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include "timeswipe.hpp"
+
+// the percentiles of the latencies given in microseconds
+TimeSwipeLatency LatencyDistribution(std::vector<float> us);
+
+// Follows the samples through the pipeline: the fetcher stamps every block, the poller reports the blocks popped,
+// the data made ready for the callback and the callback calls. The oldest sample of every callback is accounted.
+class TimeSwipeLatencyTracker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // the fetcher stamps of a block
+    struct Stamps {
+        // the read started, captured and queued
+        Clock::time_point read;
+        Clock::time_point captured;
+        Clock::time_point queued;
+    };
+
+    // a new stream: the next block popped starts at sample 0, the stats are reset
+    void Reset();
+
+    // a block of n samples has been popped from the record queue
+    void Popped(const Stamps& stamps, size_t n, Clock::time_point popped);
+
+    // data starting at the input sample first is ready for the callback, the oldest one not delivered yet counts
+    void Ready(uint64_t first, Clock::time_point ready);
+
+    // the data made ready so far is passed to the callback
+    void Delivered(Clock::time_point now);
+
+    // the number of the input samples popped so far
+    uint64_t Samples() const { return samples; }
+
+    TimeSwipeLatencyStats Stats();
+
+private:
+    enum Stage { READ, FETCH, QUEUE, PROCESS, BURST, TOTAL, STAGES };
+
+    struct Block {
+        // input samples popped by the end of the block
+        uint64_t end;
+        Stamps stamps;
+        Clock::time_point popped;
+    };
+
+    // the number of the latest callbacks the distributions are taken over
+    static constexpr size_t HISTORY_SIZE = 4096;
+
+    // poller side
+    uint64_t samples = 0;
+    std::deque<Block> blocks;
+    bool ready = false;
+    uint64_t readyFirst = 0;
+    Clock::time_point readyTime;
+
+    std::mutex mtx;
+    uint64_t count = 0;
+    std::vector<std::array<float, STAGES>> history;
+};
@@ -0,0 +1,82 @@
+#include "timeswipe_markers.hpp"
+#include <algorithm>
+
+// a larger delay than the least one by this value means the board clock was restarted
+static constexpr int64_t BOARD_RESYNC_MS = 1000;
+
+void TimeSwipeMarkers::Reset() {
+    std::lock_guard<std::mutex> lock(mtx);
+    samples = 0;
+    timeline.clear();
+    timeline.emplace_back(Clock::now(), 0);
+    pending.clear();
+}
+
+void TimeSwipeMarkers::Add(Clock::time_point time, TimeSwipeEvent event) {
+    std::lock_guard<std::mutex> lock(mtx);
+    pending.push_back({true, time, 0, std::move(event)});
+}
+
+void TimeSwipeMarkers::AddAt(uint64_t sample, TimeSwipeEvent event) {
+    std::lock_guard<std::mutex> lock(mtx);
+    pending.push_back({false, Clock::time_point(), sample, std::move(event)});
+}
+
+void TimeSwipeMarkers::AddBoard(uint32_t board_ms, Clock::time_point received, TimeSwipeEvent event) {
+    const int64_t received_ms = std::chrono::duration_cast<std::chrono::milliseconds>(received.time_since_epoch()).count();
+    const int64_t delay = received_ms - board_ms;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!boardOffsetValid || delay < boardOffset_ms || delay - boardOffset_ms > BOARD_RESYNC_MS) {
+        boardOffset_ms = delay;
+        boardOffsetValid = true;
+    }
+    const Clock::time_point time(std::chrono::milliseconds(board_ms + boardOffset_ms));
+    pending.push_back({true, time, 0, std::move(event)});
+}
+
+uint64_t TimeSwipeMarkers::Samples() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return samples;
+}
+
+uint64_t TimeSwipeMarkers::sampleAt(Clock::time_point time) {
+    if (timeline.empty() || time <= timeline.front().first) return timeline.empty() ? 0 : timeline.front().second;
+
+    auto b = std::find_if(timeline.begin(), timeline.end(), [&](const auto& e) { return e.first >= time; });
+    if (b == timeline.end()) return samples;
+    auto a = std::prev(b);
+    if (b->second == a->second) return b->second;
+
+    const double part = std::chrono::duration<double>(time - a->first).count() / std::chrono::duration<double>(b->first - a->first).count();
+    return a->second + uint64_t(part * (b->second - a->second));
+}
+
+void TimeSwipeMarkers::Block(SensorsData& data) {
+    const auto now = Clock::now();
+    const auto n = data.DataSize();
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if (n) {
+        samples += n;
+        timeline.emplace_back(now, samples);
+        if (timeline.size() > TIMELINE_SIZE) timeline.pop_front();
+    }
+
+    auto& markers = data.markers();
+    const auto first = markers.size();
+    auto it = pending.begin();
+    while (it != pending.end()) {
+        if (it->timed && it->time <= now) {
+            it->sample = sampleAt(it->time);
+            it->timed = false;
+        }
+        if (!it->timed && it->sample < samples) {
+            markers.push_back({it->sample, std::move(it->event)});
+            it = pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    std::stable_sort(markers.begin() + first, markers.end(), [](const auto& a, const auto& b) { return a.sample < b.sample; });
+}
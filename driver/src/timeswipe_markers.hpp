@@ -0,0 +1,54 @@
+#pragma once
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include "timeswipe.hpp"
+
+// Places events into the sample stream: an event gets the index of the first sample taken after it.
+// The fetcher reports every read block, the end time of a block is taken as the time of its last sample
+// and the samples in between are spread evenly.
+class TimeSwipeMarkers {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // a new stream: the next block starts at sample 0, pending markers are dropped
+    void Reset();
+
+    // the event took effect at the time point
+    void Add(Clock::time_point time, TimeSwipeEvent event);
+
+    // the event took effect at the sample
+    void AddAt(uint64_t sample, TimeSwipeEvent event);
+
+    // the event took effect at the board time (milliseconds of the board clock) and was received at the time point;
+    // the board clock offset is the least delay between the board time and the reception seen so far
+    void AddBoard(uint32_t board_ms, Clock::time_point received, TimeSwipeEvent event);
+
+    // number of samples read so far
+    uint64_t Samples();
+
+    // a block has been read: moves the markers of its samples (and of the earlier ones) to the block
+    void Block(SensorsData& data);
+
+private:
+    struct Pending {
+        bool timed;
+        Clock::time_point time;
+        uint64_t sample;
+        TimeSwipeEvent event;
+    };
+
+    uint64_t sampleAt(Clock::time_point time);
+
+    // the number of block ends kept to place late events
+    static constexpr size_t TIMELINE_SIZE = 256;
+
+    std::mutex mtx;
+    uint64_t samples = 0;
+    // block end time and the samples read by then
+    std::deque<std::pair<Clock::time_point, uint64_t>> timeline;
+    std::vector<Pending> pending;
+    bool boardOffsetValid = false;
+    int64_t boardOffset_ms = 0;
+};
@@ -0,0 +1,297 @@
+#include "timeswipe_pyramid.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+// sidecar file layout, native byte order:
+//   header: "TSPY", version, factor, entries per page, sample rate, sensors (uint32 each)
+//   pages: level, entry count, entry capacity, first entry index (uint32, uint32, uint32, uint64)
+//          followed by the capacity of entries, an entry is min, max, mean (float32) of every sensor;
+//          a flushed incomplete page has the capacity of a complete one and is filled in place later
+namespace {
+
+const char MAGIC[4] = {'T', 'S', 'P', 'Y'};
+constexpr uint32_t VERSION = 2;
+constexpr uint32_t SENSORS = 4;
+constexpr uint32_t PAGE_SIZE = 1024;
+constexpr size_t ENTRY_SIZE = SENSORS * sizeof(TimeSwipePyramidValue);
+constexpr std::streamoff PAGE_HEADER_SIZE = 3 * sizeof(uint32_t) + sizeof(uint64_t);
+constexpr float NaN = std::numeric_limits<float>::quiet_NaN();
+
+// the NaN values are skipped
+inline float minOf(float a, float b) {
+    return std::isnan(a) || b < a ? b : a;
+}
+
+inline float maxOf(float a, float b) {
+    return std::isnan(a) || b > a ? b : a;
+}
+
+template <class T>
+void put(std::ofstream& f, T val) {
+    f.write(reinterpret_cast<const char*>(&val), sizeof(val));
+}
+
+template <class T>
+bool get(std::ifstream& f, T& val) {
+    return bool(f.read(reinterpret_cast<char*>(&val), sizeof(val)));
+}
+
+}
+
+TimeSwipePyramidWriter::~TimeSwipePyramidWriter() {
+    Close();
+}
+
+bool TimeSwipePyramidWriter::Open(const std::string& path, int sampleRate, unsigned f, std::string& error) {
+    Close();
+    if (f < MIN_FACTOR || f > MAX_FACTOR) {
+        error = "wrong pyramid factor";
+        return false;
+    }
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        error = "open pyramid file \"" + path + "\" failed";
+        return false;
+    }
+    factor = f;
+    levels.clear();
+    file.write(MAGIC, sizeof(MAGIC));
+    put(file, VERSION);
+    put(file, uint32_t(factor));
+    put(file, PAGE_SIZE);
+    put(file, int32_t(sampleRate));
+    put(file, SENSORS);
+    return true;
+}
+
+void TimeSwipePyramidWriter::Append(const SensorsData& data) {
+    if (!file.is_open()) return;
+    if (levels.empty()) levels.resize(1);
+
+    const size_t n = data.DataSize();
+    size_t i = 0;
+    while (i < n) {
+        auto& l = levels[0];
+        const size_t m = std::min<size_t>(factor - l.count, n - i);
+        for (size_t c = 0; c < SENSORS; c++) {
+            const auto& in = data[c];
+            if (in.empty()) continue;
+            auto& a = l.acc[c];
+            // plain compares, the loop vectorizes
+            float mn = a.n ? a.min : in[i];
+            float mx = a.n ? a.max : in[i];
+            float sum = 0;
+            for (size_t k = i; k < i + m; k++) {
+                mn = in[k] < mn ? in[k] : mn;
+                mx = in[k] > mx ? in[k] : mx;
+                sum += in[k];
+            }
+            a.min = mn;
+            a.max = mx;
+            a.sum += sum;
+            a.n += m;
+        }
+        l.count += m;
+        i += m;
+        if (l.count == factor) emit(0);
+    }
+}
+
+void TimeSwipePyramidWriter::emit(size_t level) {
+    std::array<TimeSwipePyramidValue, SENSORS> entry;
+    {
+        auto& l = levels[level];
+        for (size_t c = 0; c < SENSORS; c++) {
+            const auto& a = l.acc[c];
+            entry[c] = {a.min, a.max, a.n ? float(a.sum / a.n) : NaN};
+        }
+        l.acc.fill(Accumulator());
+        l.count = 0;
+        l.page.insert(l.page.end(), entry.begin(), entry.end());
+        if (l.page.size() == PAGE_SIZE * SENSORS) {
+            writePage(level);
+            l.pageFirst += PAGE_SIZE;
+            l.page.clear();
+            l.slot = -1;
+            l.written = 0;
+        }
+    }
+
+    if (levels.size() == level + 1) levels.emplace_back();
+    auto& next = levels[level + 1];
+    for (size_t c = 0; c < SENSORS; c++) {
+        auto& a = next.acc[c];
+        a.min = minOf(a.min, entry[c].min);
+        a.max = maxOf(a.max, entry[c].max);
+        if (!std::isnan(entry[c].mean)) {
+            a.sum += entry[c].mean;
+            a.n++;
+        }
+    }
+    if (++next.count == factor) emit(level + 1);
+}
+
+void TimeSwipePyramidWriter::writePage(size_t level) {
+    auto& l = levels[level];
+    const size_t count = l.page.size() / SENSORS;
+    if (count == l.written) return;
+
+    if (l.slot < 0) {
+        // a new slot of a complete page at the end of the file, an incomplete page has the rest NaN
+        l.slot = file.tellp();
+        put(file, uint32_t(level));
+        put(file, uint32_t(count));
+        put(file, PAGE_SIZE);
+        put(file, uint64_t(l.pageFirst));
+        std::vector<TimeSwipePyramidValue> entries(l.page);
+        entries.resize(PAGE_SIZE * SENSORS, {NaN, NaN, NaN});
+        file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(TimeSwipePyramidValue));
+    } else {
+        // the new entries first, then the count: a concurrent reader sees the complete entries only
+        file.seekp(l.slot + PAGE_HEADER_SIZE + std::streamoff(l.written * ENTRY_SIZE));
+        file.write(reinterpret_cast<const char*>(&l.page[l.written * SENSORS]), (count - l.written) * ENTRY_SIZE);
+        file.seekp(l.slot + std::streamoff(sizeof(uint32_t)));
+        put(file, uint32_t(count));
+        file.seekp(0, std::ios::end);
+    }
+    l.written = count;
+}
+
+void TimeSwipePyramidWriter::Flush() {
+    if (!file.is_open()) return;
+    for (size_t level = 0; level < levels.size(); level++) {
+        if (!levels[level].page.empty()) writePage(level);
+    }
+    file.flush();
+}
+
+void TimeSwipePyramidWriter::Close() {
+    if (!file.is_open()) return;
+    Flush();
+    file.close();
+    levels.clear();
+}
+
+bool TimeSwipePyramidReader::Open(const std::string& path, std::string& error) {
+    file.close();
+    file.clear();
+    levels.clear();
+    file.open(path, std::ios::binary);
+    if (!file) {
+        error = "open pyramid file \"" + path + "\" failed";
+        return false;
+    }
+
+    char magic[sizeof(MAGIC)];
+    uint32_t version, f, sensors;
+    int32_t rate;
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) || !get(file, version) || version != VERSION ||
+        !get(file, f) || !get(file, pageSize) || !get(file, rate) || !get(file, sensors) || sensors != SENSORS ||
+        f < TimeSwipePyramidWriter::MIN_FACTOR || f > TimeSwipePyramidWriter::MAX_FACTOR) {
+        error = "wrong pyramid file \"" + path + "\"";
+        return false;
+    }
+    factor = f;
+    sampleRate = rate;
+
+    // the page headers only, a page cut by a concurrent write is skipped
+    file.seekg(0, std::ios::end);
+    const std::streamoff size = file.tellg();
+    std::streamoff pos = sizeof(MAGIC) + 5 * sizeof(uint32_t);
+    while (true) {
+        uint32_t level, count, capacity;
+        uint64_t first;
+        file.seekg(pos);
+        if (!get(file, level) || !get(file, count) || !get(file, capacity) || !get(file, first)) break;
+        const std::streamoff offset = pos + PAGE_HEADER_SIZE;
+        pos = offset + std::streamoff(capacity) * ENTRY_SIZE;
+        if (pos > size || count > capacity || capacity > pageSize) break;
+
+        if (levels.size() <= level) levels.resize(level + 1);
+        if (count) levels[level].push_back({first, count, offset});
+    }
+    file.clear();
+
+    // the pages of a level are written in order, a gap ends the level
+    for (auto& pages: levels) {
+        std::sort(pages.begin(), pages.end(), [](const Page& a, const Page& b) { return a.first < b.first; });
+        for (size_t i = 1; i < pages.size(); i++) {
+            if (pages[i].first != pages[i - 1].first + pages[i - 1].count) {
+                pages.resize(i);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+uint64_t TimeSwipePyramidReader::Samples() const {
+    if (levels.empty() || levels[0].empty()) return 0;
+    return (levels[0].back().first + levels[0].back().count) * factor;
+}
+
+bool TimeSwipePyramidReader::read(size_t level, uint64_t begin, uint64_t end, std::vector<std::array<TimeSwipePyramidValue, 4>>& out) {
+    out.clear();
+    const auto& pages = levels[level];
+    auto it = std::upper_bound(pages.begin(), pages.end(), begin, [](uint64_t v, const Page& p) { return v < p.first + p.count; });
+    for (; it != pages.end() && it->first < end; ++it) {
+        const uint64_t from = std::max(begin, it->first);
+        const uint64_t to = std::min(end, it->first + it->count);
+        const size_t base = out.size();
+        out.resize(base + (to - from));
+        file.seekg(it->offset + std::streamoff(from - it->first) * ENTRY_SIZE);
+        if (!file.read(reinterpret_cast<char*>(out[base].data()), (to - from) * ENTRY_SIZE)) {
+            file.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TimeSwipePyramidReader::Query(uint8_t sensor, uint64_t first, uint64_t last, size_t pixels, std::vector<TimeSwipePyramidValue>& out) {
+    if (sensor >= SENSORS || first >= last || pixels == 0 || levels.empty()) return false;
+
+    out.assign(pixels, {NaN, NaN, NaN});
+    std::vector<double> sum(pixels, 0);
+    std::vector<uint64_t> weight(pixels, 0);
+
+    // the coarsest level with the entries not larger than a pixel
+    const double pixel = double(last - first) / pixels;
+    std::vector<uint64_t> span{factor};
+    while (span.size() < levels.size() && span.back() * factor <= pixel) span.push_back(span.back() * factor);
+    size_t level = span.size() - 1;
+
+    // a level ends before the finer ones, the rest of the range goes to the finer levels
+    std::vector<std::array<TimeSwipePyramidValue, 4>> entries;
+    uint64_t from = first;
+    while (from < last) {
+        const auto& pages = levels[level];
+        const uint64_t covered = pages.empty() ? 0 : (pages.back().first + pages.back().count) * span[level];
+        const uint64_t to = std::min(last, covered);
+        if (from < to) {
+            const uint64_t begin = from / span[level];
+            if (!read(level, begin, (to + span[level] - 1) / span[level], entries)) return false;
+            for (size_t e = 0; e < entries.size(); e++) {
+                const uint64_t start = std::max(first, (begin + e) * span[level]);
+                const size_t p = std::min<size_t>(pixels - 1, (start - first) * pixels / (last - first));
+                const auto& v = entries[e][sensor];
+                out[p].min = minOf(out[p].min, v.min);
+                out[p].max = maxOf(out[p].max, v.max);
+                if (!std::isnan(v.mean)) {
+                    sum[p] += double(v.mean) * span[level];
+                    weight[p] += span[level];
+                }
+            }
+            from = to;
+        }
+        if (level == 0) break;
+        level--;
+    }
+
+    for (size_t p = 0; p < pixels; p++) {
+        if (weight[p]) out[p].mean = float(sum[p] / weight[p]);
+    }
+    return true;
+}
@@ -1,5 +1,7 @@
 #include "timeswipe_resampler.hpp"
 #include "Upfirdn/upfirdn.h"
+#include "timeswipe_kernels.hpp"
+#include <algorithm>
 #include <boost/math/special_functions/bessel.hpp>
 
 static unsigned getPad(unsigned samples) {
@@ -26,9 +28,11 @@ static int getGCD ( int num1, int num2 )
   return num2;
 }
 
-TimeSwipeResampler::TimeSwipeResampler(int up, int down)
-    : upFactor(up)
+TimeSwipeResampler::TimeSwipeResampler(int up, int down, MemoryResource resource)
+    : buffer(makeSensorsData(resource))
+    , upFactor(up)
     , downFactor(down)
+    , resource(resource)
 {
     pad = getPad(upFactor);
 
@@ -39,29 +43,64 @@ TimeSwipeResampler::TimeSwipeResampler(int up, int down)
 }
 
 SensorsData TimeSwipeResampler::Resample(SensorsData&& records) {
-    if (records.empty()) return SensorsData();
+    auto& in = records.markers();
+    std::move(in.begin(), in.end(), std::back_inserter(markers));
+    in.clear();
+
+    SensorsData out = makeSensorsData(resource);
+    if (records.empty()) return out;
     buffer.append(std::move(records));
-    size_t inputSize = buffer.DataSize();
 
-    if (inputSize < sliceSizePad) return SensorsData();
-    inputSize = sliceSizePad;
+    // every complete slice in the buffer
+    while (buffer.DataSize() >= sliceSizePad) resampleSlice(out);
+    return out;
+}
+
+SensorsData TimeSwipeResampler::Flush() {
+    SensorsData out = makeSensorsData(resource);
+    const size_t rest = buffer.DataSize();
+    const uint64_t outputBefore = outputDone;
+    if (rest) {
+        // the slices holding the rest and their padding
+        const size_t slices = (rest + sliceSize - 1) / sliceSize;
+        for (size_t x = 0; x < buffer.SensorsSize(); x++) {
+            if (!buffer[x].empty()) buffer[x].resize(slices * sliceSize + 2 * pad, buffer[x].back());
+        }
+        while (buffer.DataSize() >= sliceSizePad) resampleSlice(out);
+
+        // the output of the held samples is dropped, every slice gives the same number of samples
+        const size_t keep = out.DataSize() / slices * rest / sliceSize;
+        out.erase_back(out.DataSize() - keep);
+        outputDone = outputBefore + keep;
+        inputDone -= slices * sliceSize - rest;
+        buffer.clear();
+    }
+
+    // the markers past the end go with the last sample
+    const uint64_t last = outputDone ? outputDone - 1 : 0;
+    for (auto& m: out.markers()) m.sample = std::min(m.sample, last);
+    for (auto& m: markers) out.markers().push_back({last, std::move(m.event)});
+    markers.clear();
+    return out;
+}
 
-    SensorsData out;
+void TimeSwipeResampler::resampleSlice(SensorsData& res) {
+    const size_t inputSize = sliceSizePad;
+
+    SensorsData out = makeSensorsData(resource);
     int gcd = getGCD ( upFactor, downFactor );
     int upf = upFactor / gcd;
     int downf = downFactor / gcd;
 
     std::vector<float> yy;
-#define RESAMPLE_ONE(x) \
-    yy.clear(); \
-    upfirdn2(upf, downf, buffer[x], inputSize, state->h, state->h.size(), yy); \
-    for (int i = state->delay; i < state->outputSize + state->delay; i++) { out[x].push_back ( yy[i] ); }
+    for (size_t x = 0; x < buffer.SensorsSize(); x++) {
+        // disabled sensors are empty
+        if (buffer[x].empty()) continue;
 
-    RESAMPLE_ONE(0);
-    RESAMPLE_ONE(1);
-    RESAMPLE_ONE(2);
-    RESAMPLE_ONE(3);
-#undef RESAMPLE_ONE
+        yy.clear();
+        upfirdn2(upf, downf, buffer[x], inputSize, state->h, state->h.size(), yy, TimeSwipeKernels::Get().dot);
+        for (int i = state->delay; i < state->outputSize + state->delay; i++) { out[x].push_back ( yy[i] ); }
+    }
 
     // remove processed slice from input data
     buffer.erase_front(sliceSize);
@@ -70,7 +109,24 @@ SensorsData TimeSwipeResampler::Resample(SensorsData&& records) {
     size_t rem_pad = state->outputSize * pad / inputSize;
     out.erase_front(std::min(rem_pad, out.DataSize()));
     out.erase_back(std::min(rem_pad, out.DataSize()));
-    return out;
+
+    // the output stands for the input samples [inputDone + pad, inputDone + pad + sliceSize)
+    const uint64_t produced = out.DataSize();
+    const uint64_t first = inputDone + pad;
+    auto it = markers.begin();
+    while (it != markers.end()) {
+        if (it->sample < first + sliceSize) {
+            const uint64_t pos = it->sample > first ? it->sample - first : 0;
+            out.markers().push_back({outputDone + pos * produced / sliceSize, std::move(it->event)});
+            it = markers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    std::stable_sort(out.markers().begin(), out.markers().end(), [](const auto& a, const auto& b) { return a.sample < b.sample; });
+    inputDone += sliceSize;
+    outputDone += produced;
+    res.append(std::move(out));
 }
 
 using namespace std; // TODO
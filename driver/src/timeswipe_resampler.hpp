@@ -3,6 +3,7 @@
 #include <map>
 #include <memory>
 #include "timeswipe.hpp"
+#include "timeswipe_resource.hpp"
 
 struct ResamplerState {
     std::vector<float> h;
@@ -19,7 +20,22 @@ class TimeSwipeResampler {
     size_t sliceSize;
     size_t sliceSizePad;
     std::unique_ptr<ResamplerState> state;
+    MemoryResource resource;
+    // markers waiting for the output that holds their samples
+    std::vector<SensorsData::Marker> markers;
+    uint64_t inputDone = 0;
+    uint64_t outputDone = 0;
+    void resampleSlice(SensorsData& out);
 public:
-    TimeSwipeResampler(int up, int down);
+    TimeSwipeResampler(int up, int down, MemoryResource resource = defaultMemoryResource());
     SensorsData Resample(SensorsData&& records);
+    // the end of the stream: the output of the samples left in the buffer, the last sample is held over the padding;
+    // every input sample taken has its output then, the same delay as before
+    SensorsData Flush();
+    // the input sample the next output starts from
+    uint64_t NextInput() const { return inputDone + pad; }
+    // the input is processed by slices of SliceSize() samples, each one needs Pad() more samples on both sides;
+    // the output of a slice depends on these input samples only
+    size_t SliceSize() const { return sliceSize; }
+    unsigned Pad() const { return pad; }
 };
@@ -0,0 +1,34 @@
+#pragma once
+#include "timeswipe.hpp"
+
+// the memory resource the driver buffers allocate from, see TimeSwipe::SetMemoryResource;
+// without TIMESWIPE_PMR every buffer uses the global heap
+#ifdef TIMESWIPE_PMR
+using MemoryResource = std::pmr::memory_resource*;
+
+inline MemoryResource defaultMemoryResource() {
+    return std::pmr::get_default_resource();
+}
+
+inline SensorsData makeSensorsData(MemoryResource resource) {
+    return SensorsData(resource);
+}
+
+inline MemoryResource memoryResourceOf(const SensorsData& data) {
+    return data.resource();
+}
+#else
+using MemoryResource = std::nullptr_t;
+
+inline MemoryResource defaultMemoryResource() {
+    return nullptr;
+}
+
+inline SensorsData makeSensorsData(MemoryResource) {
+    return SensorsData();
+}
+
+inline MemoryResource memoryResourceOf(const SensorsData&) {
+    return nullptr;
+}
+#endif
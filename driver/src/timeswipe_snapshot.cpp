@@ -0,0 +1,69 @@
+#include "timeswipe_snapshot.hpp"
+#include <cstring>
+
+namespace {
+
+template <class T, size_t N>
+void get(const std::vector<uint8_t>& rec, size_t offset, std::array<T, N>& arr) {
+    std::memcpy(arr.data(), rec.data() + offset, sizeof(T) * N);
+}
+
+template <class T>
+void get(const std::vector<uint8_t>& rec, size_t offset, T& val) {
+    std::memcpy(&val, rec.data() + offset, sizeof(T));
+}
+
+int nibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace
+
+bool TimeSwipeSnapshotRecord::FromHex(const std::string& hex, std::vector<uint8_t>& rec) {
+    if (hex.empty() || hex.size() % 2) return false;
+    rec.resize(hex.size() / 2);
+    for (size_t i = 0; i < rec.size(); i++) {
+        int hi = nibble(hex[2*i]);
+        int lo = nibble(hex[2*i+1]);
+        if (hi < 0 || lo < 0) return false;
+        rec[i] = static_cast<uint8_t>(hi << 4 | lo);
+    }
+    return true;
+}
+
+// record layout version 1
+bool TimeSwipeSnapshotRecord::Decode(const std::vector<uint8_t>& rec, TimeSwipeSnapshot& snap) {
+    if (rec.size() < V1_SIZE) return false;
+
+    uint16_t size;
+    get(rec, 0, snap.version);
+    get(rec, 2, size);
+    if (snap.version < 1 || size != rec.size()) return false;
+
+    uint8_t fan_on, pwm_on;
+    get(rec, 4, snap.seq);
+    get(rec, 8, snap.time_ms);
+    get(rec, 12, snap.temperature);
+    get(rec, 16, fan_on);
+    get(rec, 17, pwm_on);
+    get(rec, 20, snap.adc_raw);
+    get(rec, 28, snap.adc_filtered);
+    get(rec, 44, snap.adc_rms);
+    get(rec, 60, snap.adc_peak);
+    get(rec, 76, snap.dac_raw);
+    get(rec, 84, snap.aout_raw);
+    get(rec, 88, snap.pwm_frequency);
+    get(rec, 96, snap.pwm_repeats);
+    get(rec, 104, snap.pwm_duty_cycle);
+    get(rec, 112, snap.pwm_high);
+    get(rec, 116, snap.pwm_low);
+
+    snap.fan_on = fan_on != 0;
+    for (size_t i = 0; i < snap.pwm_active.size(); i++) {
+        snap.pwm_active[i] = (pwm_on >> i) & 1;
+    }
+    return true;
+}
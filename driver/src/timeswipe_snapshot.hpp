@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "timeswipe.hpp"
+
+// The board health snapshot as the "Snap" access point sends it: the packed little-endian record of the firmware
+// CBoardSnapshot, 2 hex chars per byte, see CommunicationProtocol.md
+class TimeSwipeSnapshotRecord {
+public:
+    // the size of the layout version 1 record, a later version only appends fields
+    static constexpr size_t V1_SIZE = 120;
+
+    // the record bytes of the hex string, false on an odd length or a non-hex char
+    static bool FromHex(const std::string& hex, std::vector<uint8_t>& rec);
+
+    // the known part of the record, false if it is shorter than version 1 or its header does not match
+    static bool Decode(const std::vector<uint8_t>& rec, TimeSwipeSnapshot& snap);
+};
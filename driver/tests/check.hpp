@@ -0,0 +1,24 @@
+#pragma once
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+// the host tests are plain executables: a failed check prints the place and exits with code 1
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << std::endl; \
+            std::exit(1); \
+        } \
+    } while (0)
+
+#define CHECK_NEAR(a, b, eps) \
+    do { \
+        const double va = (a), vb = (b); \
+        if (!(std::fabs(va - vb) <= (eps))) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #a " = " << va << ", " #b " = " << vb \
+                      << ", allowed difference " << (eps) << std::endl; \
+            std::exit(1); \
+        } \
+    } while (0)
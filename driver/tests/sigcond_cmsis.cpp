@@ -0,0 +1,22 @@
+// CSigCond with the CMSIS-DSP kernel, compiled as CSigCondCMSIS (see CMakeLists.txt) not to clash with the in-place one
+
+#include "sigcond.h"
+#include "sigcond_cmsis.hpp"
+
+SigCondOutput runSigCondCMSIS(float fs, float fc, unsigned window, float fc2, float fs2, const std::vector<float>& x)
+{
+    SigCondOutput out;
+    CSigCond cond;
+    cond.SetSampleRate(fs);
+    cond.SetCutoff(fc);
+    cond.SetWindow(window);
+    for (size_t i = 0; i < x.size(); i++) {
+        if (i == x.size() / 3) cond.SetCutoff(fc2);
+        if (i == 2 * x.size() / 3) cond.SetSampleRate(fs2);
+        cond.Process(x[i]);
+        out.val.push_back(cond.GetVal());
+        out.rms.push_back(cond.GetRMS());
+        out.peak.push_back(cond.GetPeak());
+    }
+    return out;
+}
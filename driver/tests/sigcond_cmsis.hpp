@@ -0,0 +1,13 @@
+#pragma once
+#include <vector>
+
+// the outputs of the signal conditioning kernel for every input sample
+struct SigCondOutput {
+    std::vector<float> val;
+    std::vector<float> rms;
+    std::vector<float> peak;
+};
+
+// CSigCond built with SIGCOND_CMSIS_DSP: the filter runs arm_biquad_cascade_df2T_f32;
+// the cutoff is changed to fc2 and the sample rate to fs2 in the middle of the input
+SigCondOutput runSigCondCMSIS(float fs, float fc, unsigned window, float fc2, float fs2, const std::vector<float>& x);
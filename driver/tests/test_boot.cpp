@@ -0,0 +1,95 @@
+// CBootTiming phase ordering and durations, the image size CHatsMemMan reads from the EEPROM header
+
+#include <memory>
+#include <string>
+#include "BootTiming.h"
+#include "HatsMemMan.h"
+#include "os.h"
+#include "check.hpp"
+
+namespace {
+
+const CBootTiming::phase PHASES[] = {CBootTiming::eeprom, CBootTiming::comm, CBootTiming::board,
+                                     CBootTiming::periph, CBootTiming::commands, CBootTiming::settings};
+
+unsigned phaseTime(CBootTiming::phase p) {
+    switch (p) {
+        case CBootTiming::eeprom: return CBootTiming::Get<CBootTiming::eeprom>();
+        case CBootTiming::comm: return CBootTiming::Get<CBootTiming::comm>();
+        case CBootTiming::board: return CBootTiming::Get<CBootTiming::board>();
+        case CBootTiming::periph: return CBootTiming::Get<CBootTiming::periph>();
+        case CBootTiming::commands: return CBootTiming::Get<CBootTiming::commands>();
+        case CBootTiming::settings: return CBootTiming::Get<CBootTiming::settings>();
+        case CBootTiming::total: return CBootTiming::Get<CBootTiming::total>();
+    }
+    return 0;
+}
+
+int imageSize(const std::string& image) {
+    auto buf = std::make_shared<CFIFO>();
+    *buf += image;
+    CHatsMemMan man(buf);
+    return man.GetImageSize();
+}
+
+}
+
+int main() {
+    // the phases in order: each one takes its own time, the total is their sum
+    CBootTiming::Start();
+    for (unsigned i = 0; i < 6; i++) {
+        os::uwait(1000 * (i + 1));
+        CBootTiming::Mark(PHASES[i]);
+    }
+    CBootTiming::Mark(CBootTiming::total);
+    CHECK(CBootTiming::IsOrdered());
+    unsigned sum = 0;
+    for (unsigned i = 0; i < 6; i++) {
+        CHECK(phaseTime(PHASES[i]) >= 1000 * (i + 1));
+        sum += phaseTime(PHASES[i]);
+    }
+    CHECK(phaseTime(CBootTiming::total) >= sum);
+    CHECK(phaseTime(CBootTiming::total) - sum < 100);
+
+    // a phase marked out of order
+    CBootTiming::Start();
+    CBootTiming::Mark(CBootTiming::eeprom);
+    CBootTiming::Mark(CBootTiming::board);
+    CBootTiming::Mark(CBootTiming::comm);
+    CHECK(!CBootTiming::IsOrdered());
+
+    // a phase marked twice
+    CBootTiming::Start();
+    CBootTiming::Mark(CBootTiming::eeprom);
+    CBootTiming::Mark(CBootTiming::eeprom);
+    CHECK(!CBootTiming::IsOrdered());
+
+    // the total marked before the last phase
+    CBootTiming::Start();
+    for (unsigned i = 0; i < 5; i++) CBootTiming::Mark(PHASES[i]);
+    CHECK(CBootTiming::IsOrdered());
+    CBootTiming::Mark(CBootTiming::total);
+    CHECK(!CBootTiming::IsOrdered());
+
+    // Start() begins a new measurement
+    CBootTiming::Start();
+    CHECK(CBootTiming::IsOrdered());
+
+    // the boot reads the EEPROM header first: it tells the size of the image to read
+    auto buf = std::make_shared<CFIFO>();
+    CHatsMemMan man(buf);
+    man.Reset();
+    CHatAtomCustom atom(0);
+    atom.m_data = std::string(300, 'x');
+    CHECK(man.Store(atom) == CHatsMemMan::OK);
+    const std::string image(buf->data(), buf->size());
+    CHECK(imageSize(image) == int(image.size()));
+    CHECK(imageSize(image.substr(0, CHatsMemMan::GetHeaderSize())) == int(image.size()));
+    CHECK(imageSize(image.substr(0, CHatsMemMan::GetHeaderSize() - 1)) == 0);
+    CHECK(imageSize("") == 0);
+    std::string wrong = image;
+    wrong[0] ^= 1;
+    CHECK(imageSize(wrong.substr(0, CHatsMemMan::GetHeaderSize())) == 0);
+
+    return 0;
+}
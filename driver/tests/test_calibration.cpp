@@ -0,0 +1,173 @@
+// the calibration tables against the formulas they are built from, the decoder with and without a table,
+// and the decoding throughput of the linear scaling against the table
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <random>
+#include <vector>
+#include "timeswipe.hpp"
+#include "reader.hpp"
+#include "check.hpp"
+
+namespace {
+
+// the sensors of the reader output: SensorsData lives in timeswipe.cpp, the reader includes its own copy of the code
+using Sensors = std::array<std::vector<float>, 4>;
+
+bool same(float a, float b)
+{
+    return !memcmp(&a, &b, sizeof(float));
+}
+
+void checkLinear()
+{
+    for (const auto& p: {std::make_pair(32768, 0.000153f), std::make_pair(0, 1.0f), std::make_pair(-1000, -2.5e-3f)}) {
+        const auto table = TimeSwipeCalibration::Linear(p.first, p.second);
+        CHECK(table && table->size() == TimeSwipeCalibration::TABLE_SIZE);
+
+        // the default decoder path gives the same bits
+        std::vector<uint16_t> raw(TimeSwipeCalibration::TABLE_SIZE);
+        for (size_t i = 0; i < raw.size(); i++) raw[i] = uint16_t(i);
+        std::vector<float> scaled(raw.size());
+        TimeSwipeKernels::Get().scale(raw.data(), raw.size(), p.first, p.second, scaled.data());
+        for (size_t raw = 0; raw < TimeSwipeCalibration::TABLE_SIZE; raw++) {
+            CHECK(same((*table)[raw], float(int(raw) - p.first) * p.second));
+            CHECK(same((*table)[raw], scaled[raw]));
+        }
+    }
+}
+
+void checkPolynomial()
+{
+    CHECK(!TimeSwipeCalibration::Polynomial({}));
+
+    const std::vector<double> coeffs = {-12.5, 3.1e-4, -2.2e-9, 7.0e-15};
+    const auto table = TimeSwipeCalibration::Polynomial(coeffs);
+    CHECK(table && table->size() == TimeSwipeCalibration::TABLE_SIZE);
+    for (size_t raw = 0; raw < TimeSwipeCalibration::TABLE_SIZE; raw++) {
+        const double x = double(raw);
+        const double val = ((coeffs[3] * x + coeffs[2]) * x + coeffs[1]) * x + coeffs[0];
+        CHECK(same((*table)[raw], float(val)));
+    }
+
+    // a constant
+    const auto c = TimeSwipeCalibration::Polynomial({4.25});
+    CHECK((*c)[0] == 4.25f && (*c)[65535] == 4.25f);
+}
+
+void checkPiecewise()
+{
+    CHECK(!TimeSwipeCalibration::Piecewise({}));
+
+    // a single point holds everywhere
+    const auto single = TimeSwipeCalibration::Piecewise({{1000, 2.5f}});
+    CHECK((*single)[0] == 2.5f && (*single)[1000] == 2.5f && (*single)[65535] == 2.5f);
+
+    // the ends are held, a duplicate x steps: the first point ends the segment before, the second one starts the next
+    const std::vector<std::pair<uint16_t, float>> points = {{100, 1}, {200, 2}, {200, 5}, {300, 6}, {65000, -4}};
+    const auto table = TimeSwipeCalibration::Piecewise(points);
+    const auto& t = *table;
+    CHECK(t[0] == 1 && t[99] == 1 && t[100] == 1);
+    CHECK_NEAR(t[150], 1.5, 1e-6);
+    CHECK(t[200] == 2);
+    CHECK_NEAR(t[201], 5.01, 1e-6);
+    CHECK_NEAR(t[250], 5.5, 1e-6);
+    CHECK(t[300] == 6);
+    CHECK(t[65000] == -4 && t[65001] == -4 && t[65535] == -4);
+    for (size_t raw = 301; raw < 65000; raw++) CHECK(t[raw] <= t[raw - 1]);
+
+    // the points are sorted by x, the duplicates keep their order
+    const auto unsorted = TimeSwipeCalibration::Piecewise({{300, 6}, {65000, -4}, {200, 2}, {100, 1}, {200, 5}});
+    CHECK(*unsorted == t);
+}
+
+// random chunks decoded by the reader: the channels with a table take its values, the others are scaled linearly
+void checkDecoder()
+{
+    std::mt19937 gen(20200601);
+    std::uniform_int_distribution<unsigned> byteDist(0, 255);
+    std::vector<std::array<uint8_t, CHUNK_SIZE_IN_BYTE>> chunks(10000);
+    for (auto& c: chunks) {
+        for (auto& b: c) b = byteDist(gen);
+    }
+
+    SensorsRaw raw;
+    for (const auto& c: chunks) convertChunkToRecord(c, ALL_CHANNELS_MASK, raw);
+
+    const std::array<int, 4> offset = {32768, 32000, 33000, 100};
+    const std::array<float, 4> mfactor = {0.000153f, 0.001f, -0.002f, 1.0f};
+    SensorsLUT lut;
+    lut[1] = TimeSwipeCalibration::Polynomial({-1, 1e-4, 1e-9});
+    lut[3] = TimeSwipeCalibration::Piecewise({{0, -10}, {65535, 10}});
+
+    Sensors data;
+    scaleRecords(raw, offset, mfactor, lut, data);
+    CHECK(data[0].size() == chunks.size());
+    for (size_t n = 0; n < 4; n++) {
+        CHECK(data[n].size() == raw[n].size());
+        for (size_t i = 0; i < raw[n].size(); i++) {
+            const float expected = lut[n] ? (*lut[n])[raw[n][i]] : float(int(raw[n][i]) - offset[n]) * mfactor[n];
+            CHECK(same(data[n][i], expected));
+        }
+    }
+}
+
+// ns per 4-channel record of the reader decoding, the best of the runs
+double decodeTime(const std::vector<std::array<uint8_t, CHUNK_SIZE_IN_BYTE>>& chunks, const SensorsLUT& lut)
+{
+    const std::array<int, 4> offset = {32768, 32768, 32768, 32768};
+    const std::array<float, 4> mfactor = {0.000153f, 0.000153f, 0.000153f, 0.000153f};
+    double best = 1e9;
+    for (int run = 0; run < 20; run++) {
+        SensorsRaw raw;
+        Sensors data;
+        for (auto& r: raw) r.reserve(chunks.size());
+        for (auto& d: data) d.reserve(chunks.size());
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto& c: chunks) convertChunkToRecord(c, ALL_CHANNELS_MASK, raw);
+        scaleRecords(raw, offset, mfactor, lut, data);
+        const auto end = std::chrono::steady_clock::now();
+        CHECK(data[3].size() == chunks.size());
+        best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count() / chunks.size());
+    }
+    return best;
+}
+
+// the table costs about the same as the linear scaling: the decoding is bound by the bit extraction
+void checkThroughput()
+{
+    std::mt19937 gen(20200602);
+    std::uniform_int_distribution<unsigned> byteDist(0, 255);
+    std::vector<std::array<uint8_t, CHUNK_SIZE_IN_BYTE>> chunks(65536);
+    for (auto& c: chunks) {
+        for (auto& b: c) b = byteDist(gen);
+    }
+
+    const double linear = decodeTime(chunks, SensorsLUT());
+    SensorsLUT lut;
+    for (auto& t: lut) t = TimeSwipeCalibration::Polynomial({-12.5, 3.1e-4, -2.2e-9, 7.0e-15});
+    const double table = decodeTime(chunks, lut);
+    std::cout << "linear scaling " << linear << " ns per record, 3rd order polynomial table " << table
+              << " ns per record" << std::endl;
+    // a loose bound, the test machines are shared
+    CHECK(table < 3 * linear);
+}
+
+} // namespace
+
+int main()
+{
+    checkLinear();
+    checkPolynomial();
+    checkPiecewise();
+    checkDecoder();
+    checkThroughput();
+    return 0;
+}
@@ -0,0 +1,131 @@
+// the sensor data with disabled sensors: the size and the erasing, then the emulated acquisition with a channel mask,
+// at the board rate and resampled
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include "timeswipe.hpp"
+#include "check.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+SensorsData masked(uint8_t mask, size_t size)
+{
+    SensorsData data;
+    for (size_t n = 0; n < data.SensorsSize(); n++) {
+        if (!(mask & (1 << n))) continue;
+        for (size_t i = 0; i < size; i++) data[n].push_back(float(n * 1000 + i));
+    }
+    return data;
+}
+
+void checkData()
+{
+    for (uint8_t mask: {uint8_t(0x1), uint8_t(0x5), uint8_t(0x8), uint8_t(0xE), uint8_t(0xF)}) {
+        auto data = masked(mask, 10);
+        CHECK(data.DataSize() == 10);
+        CHECK(!data.empty());
+
+        data.erase_front(3);
+        CHECK(data.DataSize() == 7);
+        data.erase_back(2);
+        CHECK(data.DataSize() == 5);
+        for (size_t n = 0; n < data.SensorsSize(); n++) {
+            if (mask & (1 << n)) {
+                CHECK(data[n].size() == 5);
+                CHECK(data[n].front() == float(n * 1000 + 3) && data[n].back() == float(n * 1000 + 7));
+            } else {
+                CHECK(data[n].empty());
+            }
+        }
+
+        // the disabled sensors stay empty when appended to
+        auto more = masked(mask, 4);
+        data.append(std::move(more));
+        CHECK(data.DataSize() == 9);
+        for (size_t n = 0; n < data.SensorsSize(); n++) CHECK(data[n].size() == ((mask & (1 << n)) ? 9u : 0u));
+
+        // more than there is
+        data.erase_front(100);
+        CHECK(data.DataSize() == 0 && data.empty());
+        data = masked(mask, 3);
+        data.erase_back(100);
+        CHECK(data.DataSize() == 0 && data.empty());
+    }
+    SensorsData none;
+    CHECK(none.DataSize() == 0 && none.empty());
+}
+
+struct Run {
+    SensorsData data;
+    float min = 0;
+    float max = 0;
+};
+
+// a bit more than a period of the emulated sine
+Run run(uint8_t mask, int rate)
+{
+    Run r;
+    std::mutex mtx;
+    TimeSwipe tswipe;
+    CHECK(tswipe.SetChannelMask(mask));
+    CHECK(tswipe.GetChannelMask() == mask);
+    if (rate != 48000) CHECK(tswipe.SetSampleRate(rate));
+    CHECK(tswipe.Start([&](SensorsData data, uint64_t) {
+        std::lock_guard<std::mutex> lock(mtx);
+        r.data.append(std::move(data));
+    }));
+    // the mask can't be changed while started
+    CHECK(!tswipe.SetChannelMask(0xF));
+    std::this_thread::sleep_for(1300ms);
+    CHECK(tswipe.Stop());
+
+    for (size_t n = 0; n < r.data.SensorsSize(); n++) {
+        if (r.data[n].empty()) continue;
+        r.min = *std::min_element(r.data[n].begin(), r.data[n].end());
+        r.max = *std::max_element(r.data[n].begin(), r.data[n].end());
+        break;
+    }
+    return r;
+}
+
+void checkEmulated(int rate)
+{
+    // every sensor gets the same emulated signal
+    const auto full = run(0xF, rate);
+    CHECK(full.data.DataSize() > size_t(rate));
+    for (size_t n = 0; n < full.data.SensorsSize(); n++) CHECK(full.data[n] == full.data[0]);
+
+    for (uint8_t mask: {uint8_t(0x1), uint8_t(0x5)}) {
+        const auto r = run(mask, rate);
+        std::cout << "rate " << rate << ", mask " << int(mask) << ": " << r.data.DataSize() << " samples, range "
+                  << r.min << ".." << r.max << ", all sensors " << full.min << ".." << full.max << std::endl;
+        CHECK(r.data.DataSize() > size_t(rate));
+        for (size_t n = 0; n < r.data.SensorsSize(); n++) {
+            if (mask & (1 << n)) {
+                CHECK(r.data[n].size() == r.data.DataSize());
+                CHECK(r.data[n] == r.data[0]);
+            } else {
+                CHECK(r.data[n].empty());
+            }
+        }
+        // the enabled sensors are not changed: the same signal range, a code or so apart with the phase of the run
+        const float code = (full.max - full.min) / (2 * 3276);
+        CHECK_NEAR(r.min, full.min, 2 * code);
+        CHECK_NEAR(r.max, full.max, 2 * code);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    checkData();
+    checkEmulated(48000);
+    checkEmulated(10000);
+    return 0;
+}
@@ -0,0 +1,134 @@
+// the board clock estimate and the clock lock: synthetic block arrivals of a known clock error and read jitter,
+// then the emulated board run with TIMESWIPE_EMUL_PPM and TIMESWIPE_EMUL_JITTER_US
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include "timeswipe_clock.hpp"
+#include "check.hpp"
+
+namespace {
+
+using Clock = TimeSwipeClock::Clock;
+using namespace std::chrono_literals;
+
+double micros(Clock::duration d)
+{
+    return std::chrono::duration<double, std::micro>(d).count();
+}
+
+// 60 s of 2 ms blocks: every block arrives 100 us after its last sample plus up to jitterUs, every 2 s one stalls for 20 ms
+void checkSynthetic(double ppm, double jitterUs, int outputRate)
+{
+    constexpr int NOMINAL = 48000;
+    constexpr double SECONDS = 60;
+    const double rate = NOMINAL * (1 + ppm * 1e-6);
+    std::mt19937 gen(20200601);
+    std::uniform_real_distribution<double> jitter(0, jitterUs);
+
+    TimeSwipeClock c;
+    c.Reset(NOMINAL, outputRate);
+    const auto t0 = Clock::now();
+    uint64_t input = 0;
+    uint64_t streamed = 0;
+    uint64_t delivered = 0;
+    const int blocks = int(SECONDS / 0.002);
+    for (int b = 1; b <= blocks; b++) {
+        const uint64_t end = uint64_t(b * 0.002 * rate);
+        const size_t n = end - input;
+        input = end;
+        double delayUs = 100 + jitter(gen);
+        if (b % 1000 == 0) delayUs += 20000;
+        c.Block(n, t0 + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(input / rate + delayUs * 1e-6)));
+
+        // the stream at the output rate
+        const uint64_t out = input * outputRate / NOMINAL;
+        SensorsData data;
+        for (uint64_t i = streamed; i < out; i++) data[0].push_back(float(i));
+        streamed = out;
+        c.Lock(data);
+        delivered += data.DataSize();
+    }
+
+    const auto st = c.Stats();
+    std::cout << ppm << " ppm, jitter " << jitterUs << " us, output " << outputRate << ": estimated " << st.ppm
+              << " ppm, jitter " << st.jitter_us << " us, slips " << st.slips << std::endl;
+    CHECK(st.valid);
+    CHECK(st.nominal_rate == NOMINAL);
+    CHECK_NEAR(st.rate, rate, 0.5e-6 * NOMINAL);
+    CHECK_NEAR(st.ppm, ppm, 0.5);
+    // the median deviation of a uniform delay is a quarter of its range
+    CHECK_NEAR(st.jitter_us, jitterUs / 4, 5 + 0.1 * jitterUs);
+
+    // the fit follows the earliest arrivals: the input samples are mapped 100 us late at most
+    Clock::time_point time;
+    for (uint64_t k: {uint64_t(0), input / 2, input - 1}) {
+        CHECK(c.InputTime(double(k), time));
+        const auto exact = t0 + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>((k + 1) / rate));
+        CHECK_NEAR(micros(time - exact), 100, 10 + 0.05 * jitterUs);
+    }
+
+    // the locked stream ends within a sample of the fitted clock: the slips make up the clock error since the first sample
+    CHECK(delivered == streamed + st.slips);
+    CHECK(c.LockedTime(delivered - 1, time));
+    Clock::time_point last;
+    CHECK(c.InputTime(double(input - 1), last));
+    CHECK(std::fabs(micros(time - last)) < 1.5e6 / outputRate);
+    const double expected = -ppm * 1e-6 * outputRate * SECONDS;
+    CHECK_NEAR(double(st.slips), expected, 2 + 0.05 * std::fabs(expected));
+}
+
+// the emulated board runs its clock ppm fast and delays every read by up to jitterUs
+void checkEmulated(double ppm, double jitterUs)
+{
+    setenv("TIMESWIPE_EMUL_PPM", std::to_string(ppm).c_str(), 1);
+    setenv("TIMESWIPE_EMUL_JITTER_US", std::to_string(jitterUs).c_str(), 1);
+
+    TimeSwipeClockStats st;
+    std::atomic<uint64_t> delivered{0};
+    std::chrono::system_clock::time_point start, sampleTime;
+    bool mapped = false;
+    {
+        TimeSwipe tswipe;
+        start = std::chrono::system_clock::now();
+        CHECK(tswipe.Start([&](SensorsData data, uint64_t) { delivered += data.DataSize(); }));
+        std::this_thread::sleep_for(14s);
+        st = tswipe.GetClockStats();
+        mapped = tswipe.GetSampleTime(480000, sampleTime);
+        CHECK(tswipe.Stop());
+    }
+    unsetenv("TIMESWIPE_EMUL_PPM");
+    unsetenv("TIMESWIPE_EMUL_JITTER_US");
+
+    std::cout << "emulated " << ppm << " ppm, jitter " << jitterUs << " us: estimated " << st.ppm << " ppm, jitter "
+              << st.jitter_us << " us, " << delivered << " samples" << std::endl;
+    CHECK(st.valid);
+    CHECK_NEAR(st.ppm, ppm, 50);
+    CHECK(st.jitter_us > 0.1 * jitterUs / 4);
+
+    // the emulated sample k is generated at Start + k / the fast rate: the nominal rate would map
+    // the sample 10 s in ppm * 10 us early
+    CHECK(mapped);
+    const auto exact = start + std::chrono::duration_cast<std::chrono::system_clock::duration>(
+        std::chrono::duration<double>(480001 / (48000 * (1 + ppm * 1e-6))));
+    const double errorUs = std::chrono::duration<double, std::micro>(sampleTime - exact).count();
+    std::cout << "    sample 480000 mapped " << errorUs << " us off" << std::endl;
+    CHECK(std::fabs(errorUs) < std::fabs(ppm) * 10 / 3);
+}
+
+} // namespace
+
+int main()
+{
+    for (double ppm: {0.0, 150.0, -300.0}) {
+        for (double jitterUs: {0.0, 500.0}) checkSynthetic(ppm, jitterUs, 48000);
+    }
+    checkSynthetic(150, 500, 10000);
+
+    checkEmulated(500, 400);
+    return 0;
+}
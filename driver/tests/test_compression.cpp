@@ -0,0 +1,135 @@
+// the sensor stream compression: the reconstruction error bound, the point intervals and the block split
+// of the compressors, then the delivery of the emulated board with and without the points consumer
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "timeswipe_compression.hpp"
+#include "check.hpp"
+
+namespace {
+
+using Mode = TimeSwipe::Compression;
+
+std::vector<float> signal(size_t n)
+{
+    std::mt19937 gen(20200901);
+    std::normal_distribution<float> step(0, 0.002f);
+    std::vector<float> s(n);
+    float walk = 0;
+    for (size_t i = 0; i < n; i++) {
+        walk += step(gen);
+        // flat parts, ramps and steps
+        const float shape = (i / 5000) % 3 == 0 ? 0 : (i / 5000) % 3 == 1 ? (i % 5000) * 0.001f : 3;
+        s[i] = std::sin(i * 0.002f) + walk + shape;
+    }
+    return s;
+}
+
+// the points of the stream processed by blocks of random size, flushed at the end
+std::vector<TimeSwipePoint> compress(const std::vector<float>& s, Mode mode, float bound, uint32_t maxInterval, unsigned seed)
+{
+    TimeSwipeCompressor c;
+    c.Configure(mode, bound, maxInterval);
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<size_t> size(1, 3000);
+    std::vector<TimeSwipePoint> points;
+    for (size_t b = 0; b < s.size();) {
+        const size_t n = std::min(s.size() - b, size(gen));
+        c.Process(s.data() + b, n, b, points);
+        b += n;
+    }
+    c.Flush(points);
+    return points;
+}
+
+void checkCompressor(Mode mode)
+{
+    const auto s = signal(60000);
+    const float bound = 0.05f;
+    const uint32_t maxInterval = 2000;
+    const auto points = compress(s, mode, bound, maxInterval, 1);
+
+    CHECK(points.front().sample == 0 && points.front().value == s[0]);
+    CHECK(points.back().sample == s.size() - 1);
+    CHECK(points.size() < s.size() / 10);
+    for (size_t p = 1; p < points.size(); p++) {
+        CHECK(points[p].sample > points[p - 1].sample);
+        CHECK(points[p].sample - points[p - 1].sample <= maxInterval);
+    }
+
+    // the stream reconstructed from the points: sample-and-hold or linear
+    double worst = 0;
+    for (size_t p = 1; p < points.size(); p++) {
+        const auto& a = points[p - 1];
+        const auto& b = points[p];
+        for (uint64_t i = a.sample; i < b.sample; i++) {
+            const double v = mode == Mode::Deadband ? a.value
+                                                    : a.value + double(b.value - a.value) * (i - a.sample) / (b.sample - a.sample);
+            worst = std::max(worst, std::fabs(v - s[i]));
+        }
+    }
+    CHECK(worst <= bound * 1.0001);
+
+    // the same points however the stream is split into blocks
+    const auto other = compress(s, mode, bound, maxInterval, 2);
+    CHECK(other.size() == points.size());
+    for (size_t p = 0; p < points.size(); p++)
+        CHECK(other[p].sample == points[p].sample && other[p].value == points[p].value);
+}
+
+// the emulated board with sensor 0 compressed, with or without the onCompressed callback
+void checkDelivery(bool consumer)
+{
+    std::atomic<size_t> raw0{0}, raw1{0};
+    std::mutex mtx;
+    std::vector<TimeSwipePoint> points;
+    size_t calls = 0;
+    {
+        TimeSwipe tswipe;
+        CHECK(tswipe.SetCompression(0, Mode::Deadband, 10));
+        if (consumer) {
+            CHECK(tswipe.onCompressed([&](std::array<std::vector<TimeSwipePoint>, 4>&& p) {
+                std::lock_guard<std::mutex> lock(mtx);
+                calls++;
+                CHECK(p[1].empty() && p[2].empty() && p[3].empty());
+                points.insert(points.end(), p[0].begin(), p[0].end());
+            }));
+        }
+        CHECK(tswipe.Start([&](SensorsData data, uint64_t) {
+            raw0 += data[0].size();
+            raw1 += data[1].size();
+        }));
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        CHECK(tswipe.Stop());
+    }
+
+    CHECK(raw1 > 10000);
+    if (!consumer) {
+        // nobody takes the points: sensor 0 is delivered as is
+        CHECK(raw0 == raw1);
+        return;
+    }
+    CHECK(raw0 == 0);
+    CHECK(calls > 1);
+    CHECK(points.size() > 10 && points.size() < raw1 / 5);
+    CHECK(points.front().sample == 0);
+    // the last sample is a point at Stop
+    CHECK(points.back().sample == raw1 - 1);
+}
+
+} // namespace
+
+int main()
+{
+    checkCompressor(Mode::Deadband);
+    checkCompressor(Mode::SwingingDoor);
+    checkDelivery(false);
+    checkDelivery(true);
+    return 0;
+}
@@ -0,0 +1,196 @@
+// the control path: the setpoints request encoding, the merging and the stats of the control thread
+// against a gated sender, then the emulated acquisition driving the loopback board (LOOPBACK build)
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "timeswipe_control.hpp"
+#include "check.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+void checkJson()
+{
+    TimeSwipeSetpoints sp;
+    CHECK(sp.empty());
+    CHECK(sp.json() == "{}");
+
+    // a setting queued twice keeps its place and the last value
+    sp.Set("AOUT3.raw", 5);
+    sp.Set("PWM1.duty", 0.25);
+    sp.Set("PWM1", true);
+    sp.Set("AOUT3.raw", 7);
+    CHECK(sp.json() == R"({"AOUT3.raw":7,"PWM1.duty":0.25,"PWM1":true})");
+
+    // the values and the names are JSON
+    TimeSwipeSetpoints other;
+    other.Set("PWM1", false);
+    other.Set("PWM2.duty", 0.1);
+    other.Set("PWM2.repeats", -3);
+    other.Set("quoted\"name", 1e-7);
+    sp.merge(other);
+    CHECK(sp.json() == R"({"AOUT3.raw":7,"PWM1.duty":0.25,"PWM1":false,"PWM2.duty":0.1,"PWM2.repeats":-3,"quoted\"name":1e-07})");
+    const auto parsed = nlohmann::json::parse(sp.json());
+    CHECK(parsed.size() == 6);
+    CHECK(parsed["PWM2.duty"].get<double>() == 0.1);
+    CHECK(parsed["quoted\"name"].get<double>() == 1e-7);
+
+    sp.clear();
+    CHECK(sp.empty() && sp.json() == "{}");
+}
+
+// the sender is held until released, the results are scripted
+class GatedSender {
+public:
+    explicit GatedSender(std::vector<bool> results) : results(std::move(results)) {}
+
+    bool send(const std::string& request) {
+        std::unique_lock<std::mutex> lock(mtx);
+        requests.push_back(request);
+        cv.notify_all();
+        cv.wait(lock, [&] { return released >= requests.size(); });
+        return results[requests.size() - 1];
+    }
+
+    void waitRequests(size_t n) {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait_for(lock, 5s, [&] { return requests.size() >= n; });
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lock(mtx);
+        released++;
+        cv.notify_all();
+    }
+
+    std::vector<std::string> sent() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return requests;
+    }
+
+private:
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<bool> results;
+    std::vector<std::string> requests;
+    size_t released = 0;
+};
+
+void checkStats()
+{
+    GatedSender sender({true, false, true});
+    TimeSwipeControl control;
+    control.Start([&](const std::string& request) { return sender.send(request); });
+
+    SensorsData data;
+    auto block = [&](std::function<void(TimeSwipeSetpoints&)> hook) {
+        control.Block(data, TimeSwipeControl::Clock::now(), [&](const SensorsData&, TimeSwipeSetpoints& sp) { hook(sp); });
+    };
+
+    // the first block goes out at once
+    block([](TimeSwipeSetpoints& sp) { sp.Set("AOUT3.raw", 1); });
+    sender.waitRequests(1);
+
+    // the next ones wait for it: the second one starts a request, the third one is merged into it, the empty one is counted only
+    block([](TimeSwipeSetpoints& sp) { sp.Set("AOUT3.raw", 2); sp.Set("PWM1.duty", 0.5); });
+    block([](TimeSwipeSetpoints& sp) { sp.Set("AOUT3.raw", 3); });
+    block([](TimeSwipeSetpoints&) {});
+    auto st = control.Stats();
+    CHECK(st.blocks == 4 && st.sent == 0 && st.merged == 1 && st.errors == 0);
+
+    // the merged request fails
+    sender.release();
+    sender.waitRequests(2);
+    sender.release();
+    block([](TimeSwipeSetpoints& sp) { sp.Set("PWM1", true); });
+    sender.waitRequests(3);
+    sender.release();
+    control.Stop();
+
+    st = control.Stats();
+    CHECK(st.blocks == 5);
+    CHECK(st.sent == 2);
+    CHECK(st.merged == 1);
+    CHECK(st.errors == 1);
+    CHECK(st.latency.max_us > 0);
+    const auto requests = sender.sent();
+    CHECK(requests.size() == 3);
+    CHECK(requests[0] == R"({"AOUT3.raw":1})");
+    CHECK(requests[1] == R"({"AOUT3.raw":3,"PWM1.duty":0.5})");
+    CHECK(requests[2] == R"({"PWM1":true})");
+
+    // the stats start over
+    control.Start([](const std::string&) { return true; });
+    control.Stop();
+    st = control.Stats();
+    CHECK(st.blocks == 0 && st.sent == 0 && st.merged == 0 && st.errors == 0);
+}
+
+// the emulated blocks drive AOUT3 of the loopback board while another thread keeps asking for the settings
+void checkEmulated()
+{
+    constexpr int DECOY = 100000;
+    std::atomic_int blocks{0};
+    std::atomic_int rejected{0};
+    std::atomic_bool stop{false};
+    TimeSwipeControlStats st;
+    int aout3 = -1;
+    {
+        TimeSwipe tswipe;
+        CHECK(tswipe.onControl([&](const SensorsData&, TimeSwipeSetpoints& sp) {
+            const int n = ++blocks;
+            sp.Set("AOUT3.raw", n + DECOY);
+            sp.Set("PWM2.duty", 0.5);
+            sp.Set("AOUT3.raw", n);
+            if (n % 50 == 0) {
+                sp.Set("NoSuchSetting", 1);
+                ++rejected;
+            }
+        }));
+        CHECK(tswipe.Start([](SensorsData, uint64_t) {}));
+        std::thread reader([&] {
+            std::string error;
+            while (!stop) tswipe.GetSettings(R"(["Gain", "Mode", "AOUT3.raw"])", error);
+        });
+        std::this_thread::sleep_for(1500ms);
+        stop = true;
+        reader.join();
+        CHECK(tswipe.Stop());
+        st = tswipe.GetControlStats();
+
+        std::string error;
+        const auto answer = nlohmann::json::parse(tswipe.GetSettings(R"(["AOUT3.raw", "PWM2.duty"])", error), nullptr, false);
+        aout3 = answer.value("AOUT3.raw", -1);
+        CHECK(answer.value("PWM2.duty", 0.0) == 0.5);
+    }
+
+    std::cout << "blocks " << st.blocks << ", sent " << st.sent << ", merged " << st.merged << ", errors " << st.errors
+              << ", latency p50 " << st.latency.p50_us << " us, AOUT3 " << aout3 << std::endl;
+    CHECK(st.blocks == uint64_t(blocks));
+    CHECK(st.blocks > 100);
+    // every block queued setpoints: sent, failed or merged, the last request may be dropped by Stop
+    const uint64_t accounted = st.sent + st.errors + st.merged;
+    CHECK(accounted == st.blocks || accounted + 1 == st.blocks);
+    CHECK(st.errors > 0 && st.errors <= uint64_t(rejected));
+    CHECK(st.sent > 0);
+    // the last value queued by a block, never the one it replaced
+    CHECK(aout3 > 0 && aout3 <= blocks);
+}
+
+} // namespace
+
+int main()
+{
+    checkJson();
+    checkStats();
+    checkEmulated();
+    return 0;
+}
@@ -0,0 +1,144 @@
+// the control setpoints on a loaded board bus: BoardSetControl against the readBoardGetSettings traffic of the
+// other callers, over the loopback board (LOOPBACK build)
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "timeswipe.hpp"
+#include "board.hpp"
+#include "check.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+int getAOUT3()
+{
+    std::string error;
+    const auto answer = nlohmann::json::parse(readBoardGetSettings(R"(["AOUT3.raw"])", error), nullptr, false);
+    CHECK(error.empty());
+    return answer.value("AOUT3.raw", -1);
+}
+
+void waitFor(const std::function<bool()>& cond)
+{
+    for (int i = 0; i < 1000 && !cond(); i++) std::this_thread::sleep_for(1ms);
+}
+
+// the bus is held while the readers queue up, then a control request comes: it is served first,
+// so every reader sees its value
+void checkPriority()
+{
+    constexpr int READERS = 8;
+    for (int round = 1; round <= 20; round++) {
+        std::atomic_int waiting{0};
+        std::vector<int> seen(READERS, -1);
+        std::vector<std::thread> readers;
+        std::thread control;
+        {
+            BoardLock hold;
+            for (int r = 0; r < READERS; r++) {
+                readers.emplace_back([&, r] {
+                    ++waiting;
+                    seen[r] = getAOUT3();
+                });
+            }
+            waitFor([&] { return waiting == READERS; });
+            std::this_thread::sleep_for(5ms);
+
+            control = std::thread([&] {
+                std::string error;
+                CHECK(BoardSetControl("{\"AOUT3.raw\":" + std::to_string(round) + "}", error));
+                CHECK(error.empty());
+            });
+            waitFor([] {
+                std::lock_guard<std::mutex> lock(boardMtx);
+                return boardControlWaiters == 1;
+            });
+        }
+        control.join();
+        for (auto& t: readers) t.join();
+
+        for (int v: seen) CHECK(v == round);
+    }
+}
+
+// the readers keep the bus busy: every control request waits for one request in progress at most
+void checkLoaded()
+{
+    std::atomic_bool stop{false};
+    std::atomic<uint64_t> reads{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; r++) {
+        readers.emplace_back([&] {
+            std::string error;
+            while (!stop) {
+                readBoardGetSettings(R"(["Gain", "Mode", "PWM1.freq", "ADC1.raw"])", error);
+                ++reads;
+            }
+        });
+    }
+
+    double readUs = 0;
+    {
+        const uint64_t before = reads;
+        const auto start = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(200ms);
+        readUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / (reads - before);
+    }
+
+    std::vector<double> waitUs;
+    for (int i = 0; i < 500; i++) {
+        std::string error;
+        const auto start = std::chrono::steady_clock::now();
+        CHECK(BoardSetControl("{\"AOUT4.raw\":" + std::to_string(i) + "}", error));
+        waitUs.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        std::this_thread::sleep_for(100us);
+    }
+    const uint64_t loaded = reads;
+    std::this_thread::sleep_for(50ms);
+    stop = true;
+    for (auto& t: readers) t.join();
+
+    std::sort(waitUs.begin(), waitUs.end());
+    const double p50 = waitUs[waitUs.size() / 2];
+    std::cout << "bus request " << readUs << " us per read, control p50 " << p50 << " us, "
+              << reads << " reads" << std::endl;
+    // a read in progress and the own request, with the slack of a shared machine
+    CHECK(p50 < 4 * readUs + 200);
+    // the readers are not starved between the control requests
+    CHECK(reads > loaded);
+
+    std::string error;
+    const auto answer = nlohmann::json::parse(readBoardGetSettings(R"(["AOUT4.raw"])", error), nullptr, false);
+    CHECK(answer.value("AOUT4.raw", -1) == 499);
+}
+
+// a setting the board rejects fails the request
+void checkRejected()
+{
+    std::string error;
+    CHECK(!BoardSetControl(R"({"AOUT3.raw":5,"NoSuchSetting":1})", error));
+    CHECK(!error.empty());
+    error.clear();
+    CHECK(BoardSetControl(R"({"AOUT3.raw":6})", error));
+    CHECK(getAOUT3() == 6);
+}
+
+} // namespace
+
+int main()
+{
+    checkPriority();
+    checkLoaded();
+    checkRejected();
+    return 0;
+}
@@ -0,0 +1,115 @@
+// the chunked parallel conversion against the single-threaded one and against a single resampler run
+// over the whole stream: byte-identical output, every input sample converted
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include "timeswipe_convert.hpp"
+#include "timeswipe_resampler.hpp"
+#include "check.hpp"
+
+namespace {
+
+using Format = TimeSwipeConverter::Format;
+
+// an f32 recording: a sine per sensor with noise
+std::string recording(size_t samples)
+{
+    std::mt19937 gen(20200715);
+    std::normal_distribution<float> noise(0, 0.05f);
+    std::string rec(samples * 4 * sizeof(float), '\0');
+    char* p = &rec[0];
+    for (size_t i = 0; i < samples; i++) {
+        for (size_t c = 0; c < 4; c++) {
+            const float v = std::sin(2 * M_PI * (50.0 * (c + 1)) * i / 48000.0) + noise(gen);
+            std::memcpy(p, &v, sizeof(v));
+            p += sizeof(v);
+        }
+    }
+    return rec;
+}
+
+std::string convert(const std::string& rec, int outputRate, bool serial, unsigned threads, size_t chunk)
+{
+    TimeSwipeConverter conv;
+    CHECK(conv.SetSampleRates(48000, outputRate));
+    conv.SetSerial(serial);
+    conv.SetThreads(threads);
+    conv.SetChunkSize(chunk);
+    std::istringstream in(rec);
+    std::ostringstream out;
+    std::string error;
+    CHECK(conv.Convert(in, Format::F32, out, Format::F32, error) == rec.size() / 16);
+    CHECK(error.empty());
+    return out.str();
+}
+
+// one resampler over the whole stream, fed by odd-sized blocks and flushed
+std::string reference(const std::string& rec, int outputRate)
+{
+    TimeSwipeResampler r(outputRate, 48000);
+    const size_t n = rec.size() / 16;
+    SensorsData res;
+    for (size_t b = 0; b < n; b += 4321) {
+        SensorsData block;
+        for (size_t i = b; i < std::min(n, b + 4321); i++) {
+            for (size_t c = 0; c < 4; c++) {
+                float v;
+                std::memcpy(&v, rec.data() + (i * 4 + c) * sizeof(float), sizeof(v));
+                block[c].push_back(v);
+            }
+        }
+        res.append(r.Resample(std::move(block)));
+    }
+    res.append(r.Flush());
+    std::string out(res.DataSize() * 16, '\0');
+    for (size_t i = 0; i < res.DataSize(); i++)
+        for (size_t c = 0; c < 4; c++) std::memcpy(&out[(i * 4 + c) * sizeof(float)], &res[c][i], sizeof(float));
+    return out;
+}
+
+} // namespace
+
+int main()
+{
+    // 30 s at 48 kHz
+    const size_t samples = 30 * 48000;
+    const std::string rec = recording(samples);
+
+    for (int rate : {24000, 44100, 48000}) {
+        const std::string serial = convert(rec, rate, true, 1, 48000);
+        const size_t out = serial.size() / 16;
+        std::cout << "48000 -> " << rate << ": " << out << " samples" << std::endl;
+
+        // the tail is flushed: every input sample has its output
+        if (rate == 24000) CHECK(out == samples / 2);
+        if (rate == 48000) CHECK(serial == rec);
+        CHECK(double(out) > samples * double(rate) / 48000 - rate / 48.0);
+        if (rate != 48000) CHECK(serial == reference(rec, rate));
+
+        for (size_t chunk : {48000, 7777, 1000}) {
+            for (unsigned threads : {1, 4}) {
+                CHECK(convert(rec, rate, false, threads, chunk) == serial);
+            }
+        }
+    }
+
+    // a recording shorter than a slice and its padding goes through the flush only
+    const std::string shortRec = recording(700);
+    const std::string shortSerial = convert(shortRec, 24000, true, 1, 48000);
+    CHECK(shortSerial.size() / 16 == 350);
+    CHECK(convert(shortRec, 24000, false, 4, 48000) == shortSerial);
+
+    // the wall time per thread count, the speedup depends on the cores of the machine
+    for (unsigned threads : {1, 2, 4}) {
+        const auto t0 = std::chrono::steady_clock::now();
+        convert(rec, 44100, false, threads, 48000);
+        const std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - t0;
+        std::cout << threads << " threads: " << ms.count() << " ms" << std::endl;
+    }
+    return 0;
+}
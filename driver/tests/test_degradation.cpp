@@ -0,0 +1,129 @@
+// the degradation policy: its level steps and reductions, and a slow consumer of the emulated board
+// that must not overflow the record queue while the policy is active
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "timeswipe_degradation.hpp"
+#include "check.hpp"
+
+namespace {
+
+using Level = TimeSwipe::Degradation;
+using namespace std::chrono_literals;
+
+void checkLevels()
+{
+    TimeSwipeDegradation d;
+    d.Reset();
+    auto t = TimeSwipeDegradation::Clock::now();
+
+    // a short lag is ignored
+    CHECK(!d.Update(0.5, t));
+    CHECK(!d.Update(0.5, t + 200ms));
+    CHECK(!d.Update(0.05, t + 300ms));
+    CHECK(d.GetLevel() == Level::None);
+
+    // a sustained lag steps down once per LAG_TIME
+    t += 1s;
+    CHECK(!d.Update(0.5, t));
+    CHECK(d.Update(0.5, t + 250ms) && d.GetLevel() == Level::Batch);
+    CHECK(!d.Update(0.5, t + 400ms));
+    CHECK(d.Update(0.5, t + 500ms) && d.GetLevel() == Level::Decimate);
+    CHECK(d.Update(0.5, t + 750ms) && d.GetLevel() == Level::Envelope);
+    CHECK(!d.Update(0.5, t + 5s) && d.GetLevel() == Level::Envelope);
+
+    // recovery takes RECOVER_TIME per level below RECOVER_FILL
+    t += 10s;
+    CHECK(!d.Update(0.01, t));
+    CHECK(!d.Update(0.01, t + 1900ms));
+    CHECK(d.Update(0.01, t + 2s) && d.GetLevel() == Level::Decimate);
+    // a fill between the thresholds holds the level
+    CHECK(!d.Update(0.05, t + 3s));
+    CHECK(!d.Update(0.01, t + 4s));
+    CHECK(!d.Update(0.01, t + 5900ms) && d.GetLevel() == Level::Decimate);
+    CHECK(d.Update(0.01, t + 6s) && d.GetLevel() == Level::Batch);
+}
+
+SensorsData ramp(size_t n, float from)
+{
+    SensorsData data;
+    for (size_t i = 0; i < n; i++) data[0].push_back(from + i);
+    return data;
+}
+
+void checkReduction()
+{
+    TimeSwipeDegradation d;
+    d.Reset();
+    auto t = TimeSwipeDegradation::Clock::now();
+    d.Update(0.5, t);
+    d.Update(0.5, t + 250ms);
+    d.Update(0.5, t + 500ms);
+    CHECK(d.GetLevel() == Level::Decimate);
+
+    // the windows go on across the blocks: 0..11 and 12..19 make the averages of 0..7 and 8..15
+    auto out = d.Process(ramp(12, 0));
+    CHECK(out[0].size() == 1 && out[0][0] == 3.5f);
+    CHECK(out[1].empty());
+    out = d.Process(ramp(8, 12));
+    CHECK(out[0].size() == 1 && out[0][0] == 11.5f);
+
+    // min and max of every window
+    d.Update(0.5, t + 750ms);
+    CHECK(d.GetLevel() == Level::Envelope);
+    out = d.Process(ramp(2 * TimeSwipeDegradation::ENVELOPE_WINDOW, 100));
+    CHECK(out[0].size() == 4);
+    CHECK(out[0][0] == 100 && out[0][1] == 163 && out[0][2] == 164 && out[0][3] == 227);
+}
+
+// costs 100 us per delivered sample: about 5 times slower than the emulated board
+void checkSlowConsumer()
+{
+    std::atomic<uint64_t> errors{0};
+    std::atomic<uint64_t> delivered{0};
+    std::mutex levelsMtx;
+    std::vector<Level> levels;
+    {
+        TimeSwipe tswipe;
+        CHECK(tswipe.onDegradation([&](Level level) {
+            std::lock_guard<std::mutex> lock(levelsMtx);
+            levels.push_back(level);
+        }));
+        CHECK(tswipe.onError([&](uint64_t e) { errors += e; }));
+        CHECK(tswipe.Start([&](SensorsData data, uint64_t e) {
+            errors += e;
+            delivered += data.DataSize();
+            std::this_thread::sleep_for(std::chrono::microseconds(100) * data.DataSize());
+        }));
+        std::this_thread::sleep_for(6s);
+        CHECK(tswipe.Stop());
+    }
+
+    std::cout << "delivered " << delivered << " samples, levels:";
+    for (auto l: levels) std::cout << " " << int(l);
+    std::cout << ", overflows " << errors << std::endl;
+
+    // the policy steps one level at a time and gets far enough for the consumer to keep up
+    CHECK(!levels.empty());
+    Level last = Level::None;
+    for (auto l: levels) {
+        CHECK(int(l) == int(last) + 1 || int(l) == int(last) - 1);
+        last = l;
+    }
+    CHECK(int(last) >= int(Level::Decimate));
+    CHECK(errors == 0);
+}
+
+} // namespace
+
+int main()
+{
+    checkLevels();
+    checkReduction();
+    checkSlowConsumer();
+    return 0;
+}
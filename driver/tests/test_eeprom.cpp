@@ -0,0 +1,173 @@
+// the settings atom of the EEPROM image files: read, store, the size limits of the board and the chip
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include "HatsMemMan.h"
+#include "timeswipe_eeprom.hpp"
+#include "check.hpp"
+
+namespace {
+
+const char* SETTINGS = R"({"timeswipe": 1, "mode": "Norm", "profiles": {"Norm": {"offsets": [1, 2, 3, 4], "gains": [1.5, 1.5, 1.5, 1.5]}}})";
+
+// the image the firmware makes on a blank chip, with the GPIO map atom or without it
+std::string defaultImage(bool gpioMap)
+{
+    auto buf = std::make_shared<CFIFO>();
+    CHatsMemMan man(buf);
+    man.Reset();
+    CHatAtomVendorInfo vinf;
+    vinf.m_uuid = {1, 2, 3, 4};
+    vinf.m_PID = 0;
+    vinf.m_pver = 2;
+    vinf.m_vstr = "PANDA";
+    vinf.m_pstr = "TimeSwipe";
+    man.Store(vinf);
+    if (gpioMap) {
+        CHatAtomGPIOmap map;
+        man.Store(map);
+    }
+    return std::string(buf->data(), buf->size());
+}
+
+void writeFile(const std::string& path, const std::string& data)
+{
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    f.write(data.data(), data.size());
+}
+
+std::string readFile(const std::string& path)
+{
+    std::ifstream f(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+}
+
+// the declared image size of the header: signature, version, reserved, atoms count, then the length
+void setImageSize(std::string& image, uint32_t size)
+{
+    std::memcpy(&image[8], &size, sizeof(size));
+}
+
+uint32_t imageSize(const std::string& image)
+{
+    uint32_t size;
+    std::memcpy(&size, &image[8], sizeof(size));
+    return size;
+}
+
+} // namespace
+
+int main()
+{
+    std::string error;
+
+    for (bool gpioMap: {false, true}) {
+        // no settings atom: nothing is applied
+        const auto blank = defaultImage(gpioMap);
+        writeFile("eeprom.bin", blank);
+        TimeSwipeEEPROM::Settings settings;
+        CHECK(TimeSwipeEEPROM::Read(settings, error, "eeprom.bin"));
+        CHECK(settings.mode == -1);
+
+        // stored, then read back from the file
+        std::string image = blank;
+        CHECK(TimeSwipeEEPROM::Store(image, SETTINGS, error));
+        CHECK(image.size() > blank.size());
+        writeFile("eeprom.bin", image);
+        CHECK(TimeSwipeEEPROM::Read(settings, error, "eeprom.bin"));
+        CHECK(settings.mode == 1);
+        CHECK(settings.profiles[1] && settings.profiles[1]->offsets);
+        CHECK((*settings.profiles[1]->offsets)[3] == 4);
+        CHECK(!settings.profiles[0]);
+
+        // the atom is replaced, not added
+        std::string replaced = image;
+        CHECK(TimeSwipeEEPROM::Store(replaced, R"({"timeswipe": 1, "mode": "Digital"})", error));
+        CHECK(TimeSwipeEEPROM::Parse(replaced, settings, error));
+        CHECK(settings.mode == 2);
+        CHECK(!settings.profiles[1]);
+        {
+            auto buf = std::make_shared<CFIFO>();
+            *buf += image;
+            CHatsMemMan before(buf);
+            auto buf2 = std::make_shared<CFIFO>();
+            *buf2 += replaced;
+            CHatsMemMan after(buf2);
+            CHECK(before.GetAtomsCount() == after.GetAtomsCount());
+        }
+
+        // written into the file: the other atoms are kept
+        writeFile("eeprom.bin", blank);
+        CHECK(TimeSwipeEEPROM::Write(SETTINGS, error, "eeprom.bin"));
+        CHECK(readFile("eeprom.bin") == image);
+        CHECK(TimeSwipeEEPROM::Write(R"({"timeswipe": 1, "mode": "Digital"})", error, "eeprom.bin"));
+        CHECK(TimeSwipeEEPROM::Read(settings, error, "eeprom.bin"));
+        CHECK(settings.mode == 2);
+
+        // a smaller image written over a larger one: the declared size follows it, the stale tail is not read back
+        std::string note = std::string(R"({"timeswipe": 1, "mode": "Primary", "note": ")") + std::string(400, 'x') + "\"}";
+        std::string larger = image;
+        CHECK(TimeSwipeEEPROM::Store(larger, note, error));
+        writeFile("eeprom.bin", larger);
+        CHECK(TimeSwipeEEPROM::Write(SETTINGS, error, "eeprom.bin"));
+        const auto written = readFile("eeprom.bin");
+        CHECK(written.size() == larger.size());
+        CHECK(written.compare(0, image.size(), image) == 0);
+        CHECK(imageSize(written) == image.size());
+        CHECK(TimeSwipeEEPROM::Read(settings, error, "eeprom.bin"));
+        CHECK(settings.mode == 1);
+
+        // the board reads 1024 bytes at most: a larger image is refused and the file is kept
+        writeFile("eeprom.bin", image);
+        std::string large = std::string(R"({"timeswipe": 1, "mode": "Norm", "note": ")") + std::string(1024, 'x') + "\"}";
+        std::string refused = image;
+        CHECK(!TimeSwipeEEPROM::Store(refused, large, error));
+        CHECK(error.find("1024") != std::string::npos);
+        CHECK(refused == image);
+        CHECK(!TimeSwipeEEPROM::Write(large, error, "eeprom.bin"));
+        CHECK(readFile("eeprom.bin") == image);
+
+        // the largest one that fits
+        std::string fits = std::string(R"({"timeswipe": 1, "note": ")") + std::string(1024, 'x') + "\"}";
+        std::string stored = image;
+        while (!TimeSwipeEEPROM::Store(stored, fits, error)) fits.erase(fits.size() - 3, 1);
+        CHECK(stored.size() <= TimeSwipeEEPROM::IMAGE_SIZE_MAX);
+        CHECK(stored.size() > TimeSwipeEEPROM::IMAGE_SIZE_MAX - 4);
+
+        // a header declaring more than the chip: the read stops at the chip size, the image fails to verify
+        std::string huge = image + std::string(TimeSwipeEEPROM::CHIP_SIZE * 2, '\xff');
+        setImageSize(huge, 0x7fffffff);
+        writeFile("eeprom.bin", huge);
+        error.clear();
+        CHECK(!TimeSwipeEEPROM::Read(settings, error, "eeprom.bin"));
+        CHECK(!error.empty());
+        CHECK(settings.mode == -1);
+
+        // a corrupted atom
+        std::string corrupted = image;
+        corrupted[corrupted.size() - 5] ^= 0x55;
+        writeFile("eeprom.bin", corrupted);
+        error.clear();
+        CHECK(!TimeSwipeEEPROM::Read(settings, error, "eeprom.bin"));
+        CHECK(!error.empty());
+        CHECK(!TimeSwipeEEPROM::Write(SETTINGS, error, "eeprom.bin"));
+        CHECK(readFile("eeprom.bin") == corrupted);
+    }
+
+    // a wrong atom is not stored
+    std::string image = defaultImage(true);
+    CHECK(!TimeSwipeEEPROM::Store(image, R"({"mode": "Norm"})", error));
+    CHECK(!TimeSwipeEEPROM::Store(image, R"({"timeswipe": 1, "mode": "Fast"})", error));
+    CHECK(image == defaultImage(true));
+
+    // no file
+    error.clear();
+    TimeSwipeEEPROM::Settings settings;
+    CHECK(!TimeSwipeEEPROM::Read(settings, error, "missing.bin"));
+    CHECK(!error.empty());
+    CHECK(!TimeSwipeEEPROM::Write(SETTINGS, error, "missing.bin"));
+    return 0;
+}
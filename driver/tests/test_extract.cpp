@@ -0,0 +1,148 @@
+// the data byte gather, the sensor extraction and the masked chunk conversion against the former per-bit code
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <random>
+#include <vector>
+#include "timeswipe.hpp"
+#include "reader.hpp"
+#include "check.hpp"
+
+namespace {
+
+// the byte gather as it was written by hand before the pin table
+uint8_t referenceByte(unsigned int allGPIO)
+{
+    return ((allGPIO & (1UL << DATA0)) >> 17) |
+           ((allGPIO & (1UL << DATA1)) >> 19) |
+           ((allGPIO & (1UL << DATA2)) >> 2) |
+           ((allGPIO & (1UL << DATA3)) >> 1) |
+           ((allGPIO & (1UL << DATA4)) >> 3) |
+           ((allGPIO & (1UL << DATA5)) >> 10) |
+           ((allGPIO & (1UL << DATA6)) >> 12) |
+           ((allGPIO & (1UL << DATA7)) >> 16);
+}
+
+// the per-bit sensor loop of the former convertChunkToRecord
+std::array<uint16_t, 4> referenceSensors(const std::array<uint8_t, CHUNK_SIZE_IN_BYTE>& chunk)
+{
+    std::array<uint16_t, 4> sensors{};
+    size_t count = 0;
+    auto setBit = [](uint16_t& word, size_t N, bool bit) { word = (word & ~(1UL << N)) | (bit << N); };
+    auto getBit = [](uint8_t byte, size_t N) -> bool { return byte & (1UL << N); };
+    for (size_t i = 0; i < CHUNK_SIZE_IN_BYTE; ++i)
+    {
+        for (size_t n = 0; n < 4; ++n) setBit(sensors[n], 15 - count, getBit(chunk[i], 3 - n));
+        count++;
+        for (size_t n = 0; n < 4; ++n) setBit(sensors[n], 15 - count, getBit(chunk[i], 7 - n));
+        count++;
+    }
+    return sensors;
+}
+
+// the former conversion of a chunk with its clipping fix, the disabled sensors are skipped
+void referenceRecord(const std::array<uint8_t, CHUNK_SIZE_IN_BYTE>& chunk, uint8_t mask, std::array<uint16_t, 4>& old, SensorsRaw& raw)
+{
+    const auto sensors = referenceSensors(chunk);
+    for (size_t n = 0; n < 4; ++n)
+    {
+        if (!(mask & (1 << n))) continue;
+        uint16_t sensor = sensors[n];
+        if (sensor % 64 == 7 || sensor % 64 == 56) sensor = old[n];
+        old[n] = sensor;
+        raw[n].push_back(sensor);
+    }
+}
+
+// the GPIO word with the byte on the data pins
+uint32_t gpioWord(uint8_t byte)
+{
+    uint32_t word = 0;
+    for (size_t i = 0; i < DATA_PINS.size(); ++i)
+        if (byte & (0x80 >> i)) word |= 1UL << DATA_PINS[i];
+    return word;
+}
+
+} // namespace
+
+int main()
+{
+    std::mt19937 gen(20200506);
+
+    // every byte value, alone and with noise on the other pins
+    uint32_t dataMask = 0;
+    for (auto pin : DATA_PINS) dataMask |= 1UL << pin;
+    for (unsigned b = 0; b < 256; ++b)
+    {
+        const uint32_t word = gpioWord(b);
+        CHECK(gatherDataByte(word) == b);
+        CHECK(referenceByte(word) == b);
+        for (int k = 0; k < 16; ++k)
+        {
+            const uint32_t noisy = word | (gen() & ~dataMask);
+            CHECK(gatherDataByte(noisy) == b);
+            CHECK(gatherDataByte(noisy) == referenceByte(noisy));
+        }
+    }
+
+    // single bits of every byte of the chunk
+    for (size_t i = 0; i < CHUNK_SIZE_IN_BYTE; ++i)
+    {
+        for (unsigned bit = 0; bit < 8; ++bit)
+        {
+            std::array<uint8_t, CHUNK_SIZE_IN_BYTE> chunk{};
+            chunk[i] = 1 << bit;
+            const auto ref = referenceSensors(chunk);
+            const uint64_t word = chunkToWord(chunk);
+            for (size_t n = 0; n < 4; ++n) CHECK(extractSensor(word, n) == ref[n]);
+        }
+    }
+
+    // random chunks
+    std::uniform_int_distribution<unsigned> byteDist(0, 255);
+    for (int k = 0; k < 100000; ++k)
+    {
+        std::array<uint8_t, CHUNK_SIZE_IN_BYTE> chunk;
+        for (auto& b : chunk) b = byteDist(gen);
+        const auto ref = referenceSensors(chunk);
+        const uint64_t word = chunkToWord(chunk);
+        for (size_t n = 0; n < 4; ++n) CHECK(extractSensor(word, n) == ref[n]);
+    }
+
+    // the masked conversion: the enabled sensors get the values of the full conversion, the disabled ones nothing
+    std::vector<std::array<uint8_t, CHUNK_SIZE_IN_BYTE>> chunks(20000);
+    for (auto& c : chunks)
+        for (auto& b : c) b = byteDist(gen);
+    SensorsRaw full;
+    for (uint8_t mask : {uint8_t(ALL_CHANNELS_MASK), uint8_t(0x1), uint8_t(0x5), uint8_t(0xF)})
+    {
+        // the clipping fix holds the last value of every sensor: start from zeros
+        SensorsRaw reset;
+        convertChunkToRecord(std::array<uint8_t, CHUNK_SIZE_IN_BYTE>{}, ALL_CHANNELS_MASK, reset);
+        std::array<uint16_t, 4> old{};
+
+        SensorsRaw raw, ref;
+        for (const auto& c : chunks)
+        {
+            convertChunkToRecord(c, mask, raw);
+            referenceRecord(c, mask, old, ref);
+        }
+        if (mask == ALL_CHANNELS_MASK) full = raw;
+        for (size_t n = 0; n < 4; ++n)
+        {
+            CHECK(raw[n] == ref[n]);
+            if (mask & (1 << n))
+            {
+                CHECK(raw[n].size() == chunks.size());
+                CHECK(raw[n] == full[n]);
+            }
+            else
+            {
+                CHECK(raw[n].empty());
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+// every kernel variant this CPU supports against the scalar one: the results must be bit-identical
+
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "timeswipe_kernels.hpp"
+#include "check.hpp"
+
+int main()
+{
+    const TimeSwipeKernels* scalar = TimeSwipeKernels::Find("scalar");
+    CHECK(scalar != nullptr);
+    CHECK(TimeSwipeKernels::Find("unknown") == nullptr);
+
+    std::mt19937 gen(20200601);
+    std::uniform_int_distribution<unsigned> rawDist(0, 65535);
+    std::uniform_real_distribution<float> valDist(-1000.0f, 1000.0f);
+
+    // counts around the 8-lane blocks, buffers at odd offsets to catch aligned loads
+    const size_t maxCount = 1031;
+    std::vector<uint16_t> raw(maxCount + 1);
+    std::vector<float> x(maxCount + 1), h(maxCount + 1);
+    std::vector<float> out(maxCount + 1), ref(maxCount + 1);
+    for (auto& v : raw) v = rawDist(gen);
+    for (auto& v : x) v = valDist(gen);
+    for (auto& v : h) v = valDist(gen) / 1000.0f;
+
+    int tested = 0;
+    for (const char* name : {"sse4", "avx2", "neon", "scalar"})
+    {
+        const TimeSwipeKernels* k = TimeSwipeKernels::Find(name);
+        if (!k)
+        {
+            std::cout << name << ": not supported, skipped" << std::endl;
+            continue;
+        }
+        CHECK(!strcmp(k->name, name));
+        for (size_t count = 0; count <= maxCount; count += (count < 40 ? 1 : 97))
+        {
+            for (size_t shift = 0; shift < 2; ++shift)
+            {
+                const int offset = 32768 - int(count);
+                const float mfactor = 0.000153f * (1 + shift);
+                scalar->scale(raw.data() + shift, count, offset, mfactor, ref.data() + shift);
+                k->scale(raw.data() + shift, count, offset, mfactor, out.data() + shift);
+                CHECK(!memcmp(ref.data() + shift, out.data() + shift, count * sizeof(float)));
+
+                const float r = scalar->dot(x.data() + shift, h.data() + shift, count);
+                const float d = k->dot(x.data() + shift, h.data() + shift, count);
+                CHECK(!memcmp(&r, &d, sizeof(float)));
+            }
+        }
+        std::cout << name << ": bit-identical" << std::endl;
+        tested++;
+    }
+    CHECK(tested > 0);
+
+    // the selected variant is one of the listed ones
+    CHECK(TimeSwipeKernels::Find(TimeSwipeKernels::Get().name) == &TimeSwipeKernels::Get());
+    return 0;
+}
@@ -0,0 +1,127 @@
+// the latency accounting: the stages of synthetic blocks, then the emulated board, whose samples are generated
+// on a known schedule, against the age of the oldest sample seen by the read callback
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "timeswipe_latency.hpp"
+#include "check.hpp"
+
+namespace {
+
+using Clock = TimeSwipeLatencyTracker::Clock;
+using namespace std::chrono_literals;
+
+void checkTracker()
+{
+    TimeSwipeLatencyTracker t;
+    t.Reset();
+    const auto t0 = Clock::now();
+
+    // two blocks of 100 samples: read 1 ms, fetch 0.5 ms, each one 10 ms after the other
+    for (int i = 0; i < 2; i++) {
+        const auto read = t0 + i * 10ms;
+        TimeSwipeLatencyTracker::Stamps s{read, read + 1ms, read + 1500us};
+        t.Popped(s, 100, read + 4ms);
+    }
+    CHECK(t.Samples() == 200);
+
+    // the data from sample 0: the first block holds the oldest sample
+    t.Ready(0, t0 + 16ms);
+    t.Ready(150, t0 + 17ms);    // the first ready one counts
+    t.Delivered(t0 + 20ms);
+    auto st = t.Stats();
+    CHECK(st.count == 1);
+    CHECK_NEAR(st.read.p50_us, 1000, 1);
+    CHECK_NEAR(st.fetch.p50_us, 500, 1);
+    CHECK_NEAR(st.queue.p50_us, 2500, 1);
+    CHECK_NEAR(st.process.p50_us, 12000, 1);
+    CHECK_NEAR(st.burst.p50_us, 4000, 1);
+    CHECK_NEAR(st.total.p50_us, 20000, 1);
+
+    // the data from sample 150 lies in the second block
+    t.Ready(150, t0 + 30ms);
+    t.Delivered(t0 + 31ms);
+    st = t.Stats();
+    CHECK(st.count == 2);
+    CHECK_NEAR(st.total.max_us, 21000, 1);
+    CHECK_NEAR(st.total.min_us, 20000, 1);
+    CHECK_NEAR(st.process.max_us, 16000, 1);
+
+    // nothing ready, nothing counted
+    t.Delivered(t0 + 40ms);
+    CHECK(t.Stats().count == 2);
+}
+
+// the emulated board generates sample k at Start + k / 48 kHz: the oldest sample of a callback is that old
+// when the callback gets it, the driver's total must agree
+void checkEmulated(size_t burst, double& p50, double& burstP50)
+{
+    std::mutex mtx;
+    std::vector<float> ages;
+    uint64_t delivered = 0;
+    TimeSwipeLatencyStats st;
+    {
+        TimeSwipe tswipe;
+        tswipe.SetBurstSize(burst);
+        const auto start = Clock::now();
+        CHECK(tswipe.Start([&](SensorsData data, uint64_t) {
+            const auto now = Clock::now();
+            std::lock_guard<std::mutex> lock(mtx);
+            if (data.DataSize()) {
+                const auto generated = start + std::chrono::duration<double>(delivered / 48000.0);
+                ages.push_back(std::chrono::duration<float, std::micro>(now - generated).count());
+            }
+            delivered += data.DataSize();
+        }));
+        std::this_thread::sleep_for(2s);
+        st = tswipe.GetLatencyStats();
+        CHECK(tswipe.Stop());
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    CHECK(st.count > 10);
+    CHECK(st.count <= ages.size());
+    std::cout << "burst " << burst << ": " << st.count << " callbacks, total p50 " << st.total.p50_us
+              << " us, read " << st.read.p50_us << ", fetch " << st.fetch.p50_us << ", queue " << st.queue.p50_us
+              << ", process " << st.process.p50_us << ", burst " << st.burst.p50_us << std::endl;
+
+    // every stage is part of the total
+    for (const auto* s: {&st.read, &st.fetch, &st.queue, &st.process, &st.burst}) {
+        CHECK(s->min_us >= 0);
+        CHECK(s->max_us <= st.total.max_us);
+    }
+    CHECK(st.total.min_us >= st.read.min_us);
+
+    // the emulated read waits up to 2 ms for new samples and the block is generated at its end,
+    // so the driver's total is within a few milliseconds of the sample age
+    std::sort(ages.begin(), ages.end());
+    const double ageP50 = ages[ages.size() / 2];
+    std::cout << "    sample age p50 " << ageP50 << " us" << std::endl;
+    CHECK_NEAR(st.total.p50_us, ageP50, 5000 + 0.1 * ageP50);
+
+    p50 = st.total.p50_us;
+    burstP50 = st.burst.p50_us;
+}
+
+} // namespace
+
+int main()
+{
+    checkTracker();
+
+    double p50, burstP50;
+    checkEmulated(0, p50, burstP50);
+    CHECK(burstP50 < 5000);
+
+    // 100 ms bursts: the oldest sample waits for the burst to fill, the burst stage accounts it
+    double burstTotalP50, burstBurstP50;
+    checkEmulated(4800, burstTotalP50, burstBurstP50);
+    CHECK(burstBurstP50 > 50000 && burstBurstP50 < 150000);
+    CHECK(burstTotalP50 > p50 + 50000);
+    return 0;
+}
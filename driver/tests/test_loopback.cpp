@@ -0,0 +1,121 @@
+// the access points of the in-process loopback board through the driver: the monitor ADCs and offset DACs,
+// the boot timing and the board health snapshot (LOOPBACK build)
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <nlohmann/json.hpp>
+#include "timeswipe.hpp"
+#include "check.hpp"
+
+namespace {
+
+nlohmann::json get(TimeSwipe& tswipe, const std::string& request)
+{
+    std::string error;
+    const auto answer = tswipe.GetSettings(request, error);
+    CHECK(error.empty());
+    return nlohmann::json::parse(answer, nullptr, false);
+}
+
+nlohmann::json set(TimeSwipe& tswipe, const std::string& request)
+{
+    std::string error;
+    const auto answer = tswipe.SetSettings(request, error);
+    CHECK(error.empty());
+    return nlohmann::json::parse(answer, nullptr, false);
+}
+
+void checkADC(TimeSwipe& tswipe)
+{
+    // the levels of the model: 1000 per channel number
+    const auto raw = get(tswipe, R"(["ADC1.raw", "ADC2.raw", "ADC3.raw", "ADC4.raw"])");
+    for (int i = 0; i < 4; i++) CHECK(raw["ADC" + std::to_string(i + 1) + ".raw"] == 1000 * (i + 1));
+
+    // the conversion profile is fitted the firmware way
+    auto profile = set(tswipe, R"({"ADC1.avg": 5, "ADC1.presc": 100, "ADC1.samplen": 100})");
+    CHECK(profile["ADC1.avg"] == 4);
+    CHECK(profile["ADC1.presc"] == 64);
+    CHECK(profile["ADC1.samplen"] == 64);
+    profile = set(tswipe, R"({"ADC1.avg": 1, "ADC1.presc": 2, "ADC1.samplen": 0})");
+    CHECK(profile["ADC1.avg"] == 1 && profile["ADC1.presc"] == 2 && profile["ADC1.samplen"] == 1);
+
+    CHECK(set(tswipe, R"({"ADC.win": 0})")["ADC.win"] == 1);
+    CHECK(set(tswipe, R"({"ADC.win": 100})")["ADC.win"] == 100);
+    CHECK(set(tswipe, R"({"ADC2.fc": 50})")["ADC2.fc"] == 50);
+
+    CHECK(set(tswipe, R"({"DAC3.raw": 5000})")["DAC3.raw"] == 4095);
+    CHECK(set(tswipe, R"({"DAC3.raw": 1234})")["DAC3.raw"] == 1234);
+
+    // the conditioning follows the constant levels, the 100 samples window completes in 100 ms
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    get(tswipe, R"(["ADC1.raw"])");
+    const auto cond = get(tswipe, R"(["ADC2.flt", "ADC2.rms", "ADC2.peak"])");
+    CHECK_NEAR(cond["ADC2.flt"].get<float>(), 2000, 1);
+    CHECK_NEAR(cond["ADC2.rms"].get<float>(), 2000, 1);
+    CHECK_NEAR(cond["ADC2.peak"].get<float>(), 2000, 1);
+}
+
+void checkBoot(TimeSwipe& tswipe)
+{
+    const auto boot = get(tswipe, R"(["Boot.eeprom", "Boot.comm", "Boot.board", "Boot.periph", "Boot.cmd", "Boot.settings", "Boot.total", "Boot.ordered"])");
+    std::cout << "boot: " << boot.dump() << std::endl;
+    CHECK(boot["Boot.ordered"] == true);
+    unsigned sum = 0;
+    for (const char* phase: {"Boot.eeprom", "Boot.comm", "Boot.board", "Boot.periph", "Boot.cmd", "Boot.settings"}) {
+        sum += boot[phase].get<unsigned>();
+    }
+    // every phase is truncated to microseconds
+    CHECK(sum <= boot["Boot.total"].get<unsigned>());
+    CHECK(boot["Boot.total"].get<unsigned>() <= sum + 6);
+}
+
+void checkSnapshot(TimeSwipe& tswipe)
+{
+    std::string error;
+    set(tswipe, R"({"Snap.period": 5})");
+    CHECK(get(tswipe, R"(["Snap.period"])")["Snap.period"] == 10);
+    CHECK(set(tswipe, R"({"Fan": true, "AOUT3.raw": 100, "AOUT4.raw": 200, "DAC1.raw": 300})")["Fan"] == true);
+    CHECK(tswipe.StartPWM(1, 1000, 3000, 200, 5, 0.25));
+
+    // the record is rebuilt by the board loop when the period is elapsed
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    get(tswipe, R"(["Fan"])");
+    TimeSwipeSnapshot first;
+    CHECK(tswipe.GetSnapshot(first));
+    CHECK(first.version == 1);
+    CHECK(first.fan_on);
+    CHECK(first.temperature == 25);
+    for (int i = 0; i < 4; i++) CHECK(first.adc_raw[i] == 1000 * (i + 1));
+    CHECK_NEAR(first.adc_filtered[1], 2000, 1);
+    CHECK_NEAR(first.adc_rms[1], 2000, 1);
+    CHECK(first.dac_raw[0] == 300 && first.dac_raw[2] == 1234 && first.dac_raw[3] == 2048);
+    CHECK(first.aout_raw[0] == 100 && first.aout_raw[1] == 200);
+    CHECK(!first.pwm_active[0] && first.pwm_active[1]);
+    CHECK(first.pwm_frequency[1] == 1000 && first.pwm_repeats[1] == 5);
+    CHECK(first.pwm_high[1] == 3000 && first.pwm_low[1] == 200);
+    CHECK_NEAR(first.pwm_duty_cycle[1], 0.25, 1e-6);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    get(tswipe, R"(["Fan"])");
+    TimeSwipeSnapshot second;
+    CHECK(tswipe.GetSnapshot(second));
+    CHECK(second.seq > first.seq);
+    CHECK(second.time_ms >= first.time_ms + 10);
+
+    CHECK(tswipe.StopPWM(1));
+    set(tswipe, R"({"Fan": false, "Snap.period": 100})");
+}
+
+} // namespace
+
+int main()
+{
+    TimeSwipe tswipe;
+    checkADC(tswipe);
+    checkBoot(tswipe);
+    checkSnapshot(tswipe);
+    return 0;
+}
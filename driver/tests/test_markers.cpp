@@ -0,0 +1,339 @@
+// the event markers through the stream: placed by time and by the board clock, then moved by the resampler,
+// the degradation and the clock lock; at last a mid-stream offset change of the emulated board
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "timeswipe_markers.hpp"
+#include "timeswipe_resampler.hpp"
+#include "timeswipe_degradation.hpp"
+#include "timeswipe_clock.hpp"
+#include "check.hpp"
+
+namespace {
+
+using Clock = TimeSwipeMarkers::Clock;
+using Level = TimeSwipe::Degradation;
+using namespace std::chrono_literals;
+
+TimeSwipeEvent mark(uint64_t id)
+{
+    return TimeSwipeEvent::Setting("Mark", std::to_string(id));
+}
+
+uint64_t markId(const SensorsData::Marker& m)
+{
+    return std::stoull(m.event.get<TimeSwipeEvent::Setting>().value());
+}
+
+// n samples of sensor 0 counting from the first one
+SensorsData ramp(uint64_t first, size_t n)
+{
+    SensorsData data;
+    for (size_t i = 0; i < n; i++) data[0].push_back(float(first + i));
+    return data;
+}
+
+// the block ends as seen around the Block calls
+struct Timeline {
+    std::vector<Clock::time_point> before, after;
+    std::vector<uint64_t> samples;
+};
+
+// the sample of the time: the block end times are known within the Block calls, the sample within their bounds
+void checkSampleAt(const Timeline& t, Clock::time_point time, uint64_t sample)
+{
+    size_t b = 0;
+    while (b < t.before.size() && t.after[b] < time) b++;
+    CHECK(b > 0 && b < t.before.size());
+    const auto a = b - 1;
+    auto part = [](Clock::time_point x, Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<double>(x - from).count() / std::chrono::duration<double>(to - from).count();
+    };
+    const double lo = std::max(0.0, part(time, t.after[a], t.after[b]));
+    const double hi = std::min(1.0, part(time, t.before[a], t.before[b]));
+    const double n = double(t.samples[b] - t.samples[a]);
+    CHECK(sample + 1 >= t.samples[a] + uint64_t(lo * n));
+    CHECK(sample <= t.samples[a] + uint64_t(hi * n) + 1);
+}
+
+void checkPlacement()
+{
+    TimeSwipeMarkers m;
+    m.Reset();
+    Timeline t;
+    t.before.push_back(Clock::now());
+    t.after.push_back(t.before.back());
+    t.samples.push_back(0);
+
+    // 20 blocks of 100 samples every 5 ms
+    for (int b = 0; b < 20; b++) {
+        std::this_thread::sleep_for(5ms);
+        auto data = ramp(m.Samples(), 100);
+        t.before.push_back(Clock::now());
+        m.Block(data);
+        t.after.push_back(Clock::now());
+        t.samples.push_back(m.Samples());
+        CHECK(data.markers().empty());
+    }
+    CHECK(m.Samples() == 2000);
+
+    // timed events between the block ends, sample ones, a future one and one older than the timeline
+    std::vector<Clock::time_point> times;
+    for (int i = 1; i <= 5; i++) times.push_back(t.after[i * 3] + (t.before[i * 3 + 1] - t.after[i * 3]) / 2);
+    for (size_t i = 0; i < times.size(); i++) m.Add(times[i], mark(i));
+    m.AddAt(1234, mark(10));
+    m.AddAt(5000, mark(11));
+    m.Add(Clock::now() + 1h, mark(12));
+    m.Add(t.before[0] - 1s, mark(13));
+
+    SensorsData empty;
+    m.Block(empty);
+    const auto& markers = empty.markers();
+    CHECK(markers.size() == 7);
+    for (size_t i = 1; i < markers.size(); i++) CHECK(markers[i - 1].sample <= markers[i].sample);
+    for (const auto& mk: markers) {
+        const auto id = markId(mk);
+        if (id < times.size()) checkSampleAt(t, times[id], mk.sample);
+        else if (id == 10) CHECK(mk.sample == 1234);
+        else if (id == 13) CHECK(mk.sample == 0);
+        else CHECK(false);
+    }
+
+    // the later sample is delivered with the block that holds it
+    auto data = ramp(2000, 2999);
+    m.Block(data);
+    CHECK(data.markers().empty());
+    data = ramp(4999, 2);
+    m.Block(data);
+    CHECK(data.markers().size() == 1 && data.markers()[0].sample == 5000);
+    CHECK(markId(data.markers()[0]) == 11);
+}
+
+// board time: the offset is the least delay seen, a delay a second longer means the board clock restarted
+void checkBoard()
+{
+    TimeSwipeMarkers m;
+    m.Reset();
+    const auto start = Clock::now();
+    for (int b = 0; b < 40; b++) {
+        std::this_thread::sleep_for(5ms);
+        auto data = ramp(m.Samples(), 100);
+        m.Block(data);
+    }
+
+    // received times in whole milliseconds: the event times are exact then
+    const auto r = std::chrono::time_point_cast<std::chrono::milliseconds>(start) + 20ms;
+    m.AddBoard(1000, r, mark(0));                   // the offset is r - 1000
+    m.Add(r, mark(100));
+    m.AddBoard(1100, r + 150ms, mark(1));           // 50 ms late: r + 100
+    m.Add(r + 100ms, mark(101));
+    m.AddBoard(1160, r + 140ms, mark(2));           // 20 ms earlier than the offset: the new offset, r + 140
+    m.Add(r + 140ms, mark(102));
+    m.AddBoard(1170, r + 160ms, mark(3));           // 10 ms late on the new offset: r + 150
+    m.Add(r + 150ms, mark(103));
+    m.AddBoard(5, r + 170ms, mark(4));              // restarted board clock: resynced, r + 170
+    m.Add(r + 170ms, mark(104));
+
+    SensorsData empty;
+    m.Block(empty);
+    CHECK(empty.markers().size() == 10);
+    std::vector<uint64_t> board(5, ~uint64_t(0)), ref(5, ~uint64_t(0));
+    for (const auto& mk: empty.markers()) {
+        const auto id = markId(mk);
+        if (id < 100) board[id] = mk.sample;
+        else ref[id - 100] = mk.sample;
+    }
+    for (size_t i = 0; i < board.size(); i++) CHECK(board[i] == ref[i]);
+    CHECK(board[0] < board[1] && board[1] < board[2] && board[2] < board[3] && board[3] < board[4]);
+}
+
+// a marker is held until its slice is resampled, then goes to the output sample of its input sample.
+// A slice stands for the input samples [1000 s + pad, 1000 (s + 1) + pad), pad is 20 at these rates:
+// the resampled ramp has the input index there, scaled by the filter gain (0.9994 at DC), except next to
+// the slice edges, where the slices ring
+void checkResampler(int outputRate)
+{
+    TimeSwipeResampler r(outputRate, 48000);
+    CHECK(r.SliceSize() == 1000 && r.Pad() == 20);
+    const double step = 48000.0 / outputRate;
+    const std::vector<uint64_t> at = {100, 520, 1019, 1020, 4521, 23517, 30533};
+    std::vector<float> out;
+    std::vector<SensorsData::Marker> markers;
+    size_t firstSlice = 0;
+    uint64_t input = 0;
+    for (int b = 0; b < 50; b++) {
+        auto data = ramp(input, 777);
+        for (size_t i = 0; i < at.size(); i++) {
+            if (at[i] >= input && at[i] < input + 777) data.markers().push_back({at[i], mark(i)});
+        }
+        input += 777;
+        auto o = r.Resample(std::move(data));
+        if (!firstSlice) firstSlice = o.DataSize();
+        for (auto& m: o.markers()) {
+            CHECK(m.sample >= out.size() && m.sample < out.size() + o.DataSize());
+            markers.push_back(std::move(m));
+        }
+        out.insert(out.end(), o[0].begin(), o[0].end());
+    }
+    CHECK(markers.size() == at.size());
+    for (const auto& m: markers) {
+        const auto k = at[markId(m)];
+        CHECK(m.sample < out.size());
+        if (k == 1019) CHECK(m.sample == firstSlice - 1);
+        else if (k == 1020) CHECK(m.sample == firstSlice);
+        else CHECK_NEAR(out[m.sample], double(k), 2 * step + 1e-3 * k);
+    }
+
+    // the flush maps the markers of the buffered samples, the ones past the end go with the last sample
+    auto data = ramp(input, 300);
+    data.markers().push_back({input + 150, mark(0)});
+    data.markers().push_back({input + 1000, mark(1)});
+    auto o = r.Resample(std::move(data));
+    o.append(r.Flush());
+    out.insert(out.end(), o[0].begin(), o[0].end());
+    CHECK(o.markers().size() == 2);
+    CHECK(markId(o.markers()[0]) == 0 && markId(o.markers()[1]) == 1);
+    CHECK_NEAR(out[o.markers()[0].sample], double(input + 150), 2 * step + 1e-3 * input);
+    CHECK(o.markers()[1].sample == out.size() - 1);
+}
+
+// the reduced stream: a marker goes to the window of its sample
+void checkDegradation()
+{
+    TimeSwipeDegradation d;
+    d.Reset();
+    auto t = TimeSwipeDegradation::Clock::now();
+
+    auto process = [&](uint64_t first, size_t n, uint64_t markAt, std::vector<float>& out) {
+        auto data = ramp(first, n);
+        data.markers().push_back({markAt, mark(markAt)});
+        auto o = d.Process(std::move(data));
+        out.insert(out.end(), o[0].begin(), o[0].end());
+        CHECK(o.markers().size() == 1);
+        return o.markers()[0].sample;
+    };
+
+    std::vector<float> out;
+    uint64_t in = 0;
+    // undegraded: the same index
+    auto s = process(in, 100, 42, out);
+    CHECK(s == 42 && out[s] == 42);
+    in += 100;
+
+    d.Update(0.5, t);
+    d.Update(0.5, t + 250ms);
+    d.Update(0.5, t + 500ms);
+    CHECK(d.GetLevel() == Level::Decimate);
+    for (uint64_t markAt: {uint64_t(103), uint64_t(250), uint64_t(390)}) {
+        s = process(in, 100, markAt, out);
+        in += 100;
+        // the average of the window holding the sample
+        CHECK(s < out.size());
+        CHECK(std::fabs(out[s] - float(markAt)) <= TimeSwipeDegradation::DECIMATION / 2.0);
+    }
+
+    d.Update(0.5, t + 750ms);
+    CHECK(d.GetLevel() == Level::Envelope);
+    for (uint64_t markAt: {uint64_t(500), uint64_t(850)}) {
+        const auto first = out.size();
+        s = process(in, 300, markAt, out);
+        in += 300;
+        // the min and max of the window holding the sample
+        CHECK(s >= first && (s - first) % 2 == 0 && s + 1 < out.size());
+        CHECK(out[s] <= float(markAt) && float(markAt) <= out[s + 1]);
+    }
+}
+
+// the locked stream: a marker stays on its sample when the lock drops or repeats samples before it
+void checkLock(double ppm)
+{
+    constexpr int RATE = 48000;
+    const double rate = RATE * (1 + ppm * 1e-6);
+    TimeSwipeClock c;
+    c.Reset(RATE, RATE);
+    const auto t0 = Clock::now();
+    uint64_t input = 0;
+    uint64_t delivered = 0;
+    int checked = 0;
+    for (int b = 1; b <= 15000; b++) {
+        const uint64_t end = uint64_t(b * 0.002 * rate);
+        auto data = ramp(input, end - input);
+        const uint64_t markAt = input + (end - input) / 2;
+        data.markers().push_back({markAt, mark(markAt)});
+        input = end;
+        c.Block(data.DataSize(), t0 + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(input / rate + 1e-4)));
+        c.Lock(data);
+        CHECK(data.markers().size() == 1);
+        const auto& m = data.markers()[0];
+        CHECK(m.sample >= delivered && m.sample < delivered + data.DataSize());
+        if (m.sample >= delivered && m.sample < delivered + data.DataSize()) {
+            CHECK(data[0][m.sample - delivered] == float(markAt));
+            checked++;
+        }
+        delivered += data.DataSize();
+    }
+    CHECK(checked == 15000);
+    const auto slips = c.Stats().slips;
+    std::cout << ppm << " ppm: " << slips << " slips" << std::endl;
+    CHECK(ppm > 0 ? slips < -50 : slips > 50);
+}
+
+// a mid-stream offset change of the emulated board: the marker is on the first sample scaled the new way
+void checkEmulated(int rate)
+{
+    std::mutex mtx;
+    std::vector<float> values;
+    std::vector<uint64_t> changes;
+    {
+        TimeSwipe tswipe;
+        CHECK(tswipe.SetSampleRate(rate));
+        CHECK(tswipe.Start([&](SensorsData data, uint64_t) {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (const auto& m: data.markers()) {
+                if (m.event.is<TimeSwipeEvent::Setting>() && m.event.get<TimeSwipeEvent::Setting>().name() == "SensorOffsets")
+                    changes.push_back(m.sample);
+            }
+            values.insert(values.end(), data[0].begin(), data[0].end());
+        }));
+        std::this_thread::sleep_for(700ms);
+        tswipe.SetSensorOffsets(20000, 0, 0, 0);
+        std::this_thread::sleep_for(500ms);
+        CHECK(tswipe.Stop());
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    CHECK(changes.size() == 1);
+    if (changes.size() != 1) return;
+    const auto marker = changes[0];
+    CHECK(marker > 0 && marker < values.size());
+
+    // the emulated sine changes by less than a unit per sample, the offset steps the values down by 20000:
+    // the first sample below the middle of the step
+    const float middle = values[0] - 10000;
+    size_t changed = 0;
+    while (changed < values.size() && values[changed] > middle) changed++;
+    std::cout << rate << " Hz: the marker at " << marker << ", the first changed sample " << changed << std::endl;
+    if (rate == 48000) CHECK(changed == marker);
+    else CHECK(changed + 1 >= marker && changed <= marker + 1);
+}
+
+} // namespace
+
+int main()
+{
+    checkPlacement();
+    checkBoard();
+    checkResampler(10000);
+    checkResampler(44100);
+    checkDegradation();
+    checkLock(300);
+    checkLock(-300);
+    checkEmulated(48000);
+    checkEmulated(10000);
+    return 0;
+}
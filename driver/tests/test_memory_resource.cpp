@@ -0,0 +1,82 @@
+// every sensor buffer of the driver allocates from the memory resource set by SetMemoryResource
+
+#include <atomic>
+#include <chrono>
+#include <memory_resource>
+#include <thread>
+#include "timeswipe.hpp"
+#include "check.hpp"
+
+namespace {
+
+// counts the allocations and the outstanding bytes, the memory comes from the global heap
+class CountingResource : public std::pmr::memory_resource {
+public:
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<int64_t> outstanding{0};
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        allocations++;
+        outstanding += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        outstanding -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// runs the emulated board for a while, the delivered data must come from the resource
+void run(CountingResource& resource, int rate) {
+    std::atomic<size_t> delivered{0};
+    std::atomic<bool> foreign{false};
+    {
+        TimeSwipe tswipe;
+        CHECK(tswipe.SetMemoryResource(&resource));
+        CHECK(tswipe.SetSampleRate(rate));
+        CHECK(tswipe.Start([&](SensorsData data, uint64_t) {
+            if (data.resource() != &resource) foreign = true;
+            delivered += data.DataSize();
+        }));
+        // the resource can't change under the running reader
+        CHECK(!tswipe.SetMemoryResource(std::pmr::new_delete_resource()));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+        CHECK(tswipe.Stop());
+    }
+    CHECK(!foreign);
+    CHECK(delivered > size_t(rate));
+    CHECK(resource.allocations > 0);
+    // nothing is left behind once the driver is gone
+    CHECK(resource.outstanding == 0);
+}
+
+} // namespace
+
+int main()
+{
+    // a copy keeps the resource of its source
+    {
+        CountingResource resource;
+        SensorsData data(&resource);
+        data[0].assign(100, 1.0f);
+        CHECK(resource.allocations == 1);
+        SensorsData copy(data);
+        CHECK(copy.resource() == &resource);
+        CHECK(resource.allocations == 2);
+        CHECK(SensorsData().resource() == std::pmr::get_default_resource());
+    }
+
+    CountingResource direct;
+    run(direct, 48000);
+
+    // the resampler buffers too
+    CountingResource resampled;
+    run(resampled, 10000);
+    return 0;
+}
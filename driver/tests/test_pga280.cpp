@@ -0,0 +1,139 @@
+// CPGA280batch: the transfers of a committed batch and the cached mode and gains after a failed one
+
+#include <memory>
+#include "PGA280.h"
+#include "check.hpp"
+
+namespace {
+
+// the chip side of the bus: the register file, decodes the command frames of CPGA280cmd (no checksum mode)
+class Chip : public CSPI {
+public:
+    uint8_t regs[32] = {};
+    unsigned frames = 0;
+    unsigned failFrame = 0;     // the frame number to fail, 0 - none
+    bool dropWrites = false;    // the frames pass, the registers are not written
+    bool dead = false;          // all frames fail
+
+    bool send(CFIFO&) override { return false; }
+    bool receive(CFIFO&) override { return false; }
+    void set_phpol(bool, bool) override {}
+    void set_baud_div(unsigned char) override {}
+    void set_tprofile_divs(unsigned char, unsigned char, unsigned char) override {}
+
+    bool transfer(CFIFO& out, CFIFO& in) override {
+        if (++frames == failFrame || dead) return false;
+
+        in.reset();
+        for (size_t i = 0; i < out.size();) {
+            const uint8_t b = out[i];
+            const uint8_t addr = b & 0x1f;
+            if ((b & 0xc0) == CPGA280cmd::write) {
+                if (!dropWrites) regs[addr] = out[i + 1];
+                in << 0 << 0;
+                i += 2;
+                // a write inside the chain is padded to three bytes
+                if (i < out.size()) {
+                    in << 0;
+                    i++;
+                }
+            } else {
+                in << 0 << regs[addr] << uint8_t(0x9b + b + regs[addr]);
+                i += 3;
+            }
+        }
+        return true;
+    }
+};
+
+class CSPin : public CPin {
+protected:
+    void impl_Set(bool how) override { value = how; }
+    bool impl_RbSet() override { return value; }
+    bool impl_Get() override { return value; }
+
+private:
+    bool value = false;
+};
+
+// the cache agrees with the registers
+void checkCache(CPGA280& pga, const Chip& chip)
+{
+    typeCPGA280GainMuxReg gain;
+    gain.reg = chip.regs[CPGA280::gain_mux];
+    CHECK(pga.CmGetIGain() == gain.bit.IGAIN);
+    CHECK(pga.CmGetOGain() == gain.bit.OGAIN);
+    typeCPGA280ISw1Reg sw1;
+    sw1.reg = chip.regs[CPGA280::ISw1];
+    CHECK(pga.CmGetMode() == (sw1.bit.SW_B1 ? CPGA280::Current : CPGA280::Voltage));
+}
+
+// the batch of a channel setting: the mode and both gains
+bool setChannel(CPGA280& pga, CPGA280::mode mode, CPGA280::igain ig, CPGA280::ogain og)
+{
+    CPGA280batch::Begin();
+    pga.SetMode(mode);
+    pga.SetGains(ig, og);
+    return CPGA280batch::Commit();
+}
+
+}
+
+int main() {
+    auto chip = std::make_shared<Chip>();
+    CPGA280 pga(chip, std::make_shared<CSPin>());
+    CHECK(pga.CmGetMode() == CPGA280::Voltage);
+
+    // one write frame, one readback frame
+    chip->frames = 0;
+    CHECK(setChannel(pga, CPGA280::Current, CPGA280::ig8, CPGA280::og1_3_8));
+    CHECK(chip->frames == 2);
+    CHECK(CPGA280batch::GetLastXfers() == 2);
+    CHECK(CPGA280batch::GetErrors() == 0);
+    CHECK(pga.CmGetMode() == CPGA280::Current && pga.CmGetIGain() == CPGA280::ig8);
+    checkCache(pga, *chip);
+
+    // the writes are lost: the readback fails, the cache is read back from the chip
+    chip->dropWrites = true;
+    chip->frames = 0;
+    CHECK(!setChannel(pga, CPGA280::Voltage, CPGA280::ig64, CPGA280::og1));
+    CHECK(chip->frames == 3);
+    CHECK(CPGA280batch::GetLastXfers() == 3);
+    CHECK(CPGA280batch::GetErrors() == 1);
+    CHECK(pga.CmGetMode() == CPGA280::Current && pga.CmGetIGain() == CPGA280::ig8);
+    checkCache(pga, *chip);
+    chip->dropWrites = false;
+
+    // the write frame fails
+    chip->frames = 0;
+    chip->failFrame = 1;
+    CHECK(!setChannel(pga, CPGA280::Voltage, CPGA280::ig2, CPGA280::og1));
+    CHECK(pga.CmGetIGain() == CPGA280::ig8);
+    checkCache(pga, *chip);
+
+    // the readback frame fails after the chip took the writes: the cache gets them
+    chip->frames = 0;
+    chip->failFrame = 2;
+    CHECK(!setChannel(pga, CPGA280::Voltage, CPGA280::ig2, CPGA280::og1));
+    CHECK(pga.CmGetMode() == CPGA280::Voltage && pga.CmGetIGain() == CPGA280::ig2);
+    checkCache(pga, *chip);
+    CHECK(CPGA280batch::GetErrors() == 3);
+
+    // the chip does not answer at all: the requested values stay, nothing better is known
+    chip->failFrame = 0;
+    chip->dead = true;
+    CHECK(!setChannel(pga, CPGA280::Current, CPGA280::ig16, CPGA280::og1));
+    CHECK(pga.CmGetMode() == CPGA280::Current && pga.CmGetIGain() == CPGA280::ig16);
+    chip->dead = false;
+
+    // back to normal
+    CHECK(setChannel(pga, CPGA280::Current, CPGA280::ig4, CPGA280::og1));
+    checkCache(pga, *chip);
+
+    // unbatched: the cache is only updated by a successful write
+    chip->frames = 0;
+    chip->failFrame = 1;
+    CHECK(!pga.SetIGain(CPGA280::ig128));
+    CHECK(pga.CmGetIGain() == CPGA280::ig4);
+    return 0;
+}
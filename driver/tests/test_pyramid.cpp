@@ -0,0 +1,158 @@
+// the pyramid sidecar: the same file however often it is flushed, a growing file read back while written,
+// and the queries against the min/max/mean of the samples themselves
+
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include "timeswipe_pyramid.hpp"
+#include "check.hpp"
+
+namespace {
+
+const unsigned FACTOR = 4;
+
+std::vector<float> signal(size_t n)
+{
+    std::mt19937 gen(20200801);
+    std::normal_distribution<float> noise(0, 1);
+    std::vector<float> s(n);
+    for (size_t i = 0; i < n; i++) s[i] = 10 * std::sin(i * 0.001f) + noise(gen);
+    return s;
+}
+
+// the samples by blocks of the given size, sensor 0 and 2 only
+void write(const std::string& path, const std::vector<float>& s, size_t block, bool flushEach)
+{
+    TimeSwipePyramidWriter w;
+    std::string error;
+    CHECK(w.Open(path, 48000, FACTOR, error));
+    for (size_t b = 0; b < s.size(); b += block) {
+        SensorsData data;
+        data[0].assign(s.begin() + b, s.begin() + std::min(s.size(), b + block));
+        data[2] = data[0];
+        for (auto& v: data[2]) v = -v;
+        w.Append(data);
+        if (flushEach) w.Flush();
+    }
+    w.Close();
+}
+
+// NaN is the same as NaN: pixels without an entry
+bool same(float a, float b)
+{
+    return a == b || (std::isnan(a) && std::isnan(b));
+}
+
+std::string contents(const std::string& path)
+{
+    std::ifstream f(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+int main()
+{
+    // not a whole number of pages on any level
+    const size_t n = 3 * 1024 * FACTOR * FACTOR + 12345;
+    const auto s = signal(n);
+
+    // flushing fills the incomplete pages in place: the pages are the same, only their order in the file
+    // follows the flushes, so the files have the same size and answer the same
+    write("once.pyr", s, 4800, false);
+    write("each.pyr", s, 4800, true);
+    write("small.pyr", s, 7, true);
+    const size_t size = contents("once.pyr").size();
+    CHECK(size > 0);
+    CHECK(contents("each.pyr").size() == size);
+    CHECK(contents("small.pyr").size() == size);
+    for (const char* path : {"each.pyr", "small.pyr"}) {
+        TimeSwipePyramidReader a, b;
+        std::string error;
+        CHECK(a.Open("once.pyr", error) && b.Open(path, error));
+        CHECK(a.Samples() == b.Samples());
+        for (size_t pixels : {1, 13, 1000, 20000}) {
+            std::vector<TimeSwipePyramidValue> va, vb;
+            CHECK(a.Query(0, 0, a.Samples(), pixels, va) && b.Query(0, 0, b.Samples(), pixels, vb));
+            for (size_t p = 0; p < pixels; p++) {
+                CHECK(same(va[p].min, vb[p].min) && same(va[p].max, vb[p].max));
+                // the entry sums are split by the blocks appended
+                CHECK(same(va[p].mean, vb[p].mean) || std::fabs(va[p].mean - vb[p].mean) < 1e-5);
+            }
+        }
+    }
+
+    TimeSwipePyramidReader r;
+    std::string error;
+    CHECK(r.Open("once.pyr", error));
+    CHECK(r.Factor() == FACTOR && r.SampleRate() == 48000);
+    CHECK(r.Samples() == n / FACTOR * FACTOR);
+
+    // from sample 0 every entry read starts in the range and the entries cover it: the pixels together have
+    // the min, max and mean of all the samples
+    double sum = 0;
+    float mn = s[0], mx = s[0];
+    for (uint64_t i = 0; i < r.Samples(); i++) {
+        mn = std::min(mn, s[i]);
+        mx = std::max(mx, s[i]);
+        sum += s[i];
+    }
+    for (size_t pixels : {1, 7, 100, 5000}) {
+        std::vector<TimeSwipePyramidValue> out, neg, none;
+        CHECK(r.Query(0, 0, r.Samples(), pixels, out));
+        CHECK(r.Query(2, 0, r.Samples(), pixels, neg));
+        CHECK(r.Query(1, 0, r.Samples(), pixels, none));
+        CHECK(out.size() == pixels);
+        float pmn = out[0].min, pmx = out[0].max;
+        for (size_t p = 0; p < pixels; p++) {
+            pmn = std::min(pmn, out[p].min);
+            pmx = std::max(pmx, out[p].max);
+            CHECK(neg[p].min == -out[p].max && neg[p].max == -out[p].min);
+            CHECK(std::isnan(none[p].min) && std::isnan(none[p].mean));
+        }
+        CHECK(pmn == mn && pmx == mx);
+        if (pixels == 1) CHECK_NEAR(out[0].mean, sum / r.Samples(), 1e-4);
+    }
+
+    // the exact level 0 entries
+    std::vector<TimeSwipePyramidValue> out;
+    CHECK(r.Query(0, 0, 40 * FACTOR, 40, out));
+    for (size_t e = 0; e < 40; e++) {
+        mn = s[e * FACTOR];
+        mx = mn;
+        sum = 0;
+        for (size_t k = 0; k < FACTOR; k++) {
+            mn = std::min(mn, s[e * FACTOR + k]);
+            mx = std::max(mx, s[e * FACTOR + k]);
+            sum += s[e * FACTOR + k];
+        }
+        CHECK(out[e].min == mn && out[e].max == mx);
+        CHECK_NEAR(out[e].mean, sum / FACTOR, 1e-5);
+    }
+
+    // a growing file: the reader takes what has been flushed so far
+    TimeSwipePyramidWriter w;
+    CHECK(w.Open("growing.pyr", 48000, FACTOR, error));
+    size_t appended = 0;
+    for (int round = 0; round < 5; round++) {
+        SensorsData data;
+        data[0].assign(s.begin() + appended, s.begin() + appended + 3000 + round * 5000);
+        appended += data.DataSize();
+        w.Append(data);
+        w.Flush();
+        TimeSwipePyramidReader g;
+        CHECK(g.Open("growing.pyr", error));
+        CHECK(g.Samples() == appended / FACTOR * FACTOR);
+        std::vector<TimeSwipePyramidValue> v;
+        CHECK(g.Query(0, 0, g.Samples(), 1, v));
+        float mx = s[0];
+        for (size_t i = 0; i < g.Samples(); i++) mx = std::max(mx, s[i]);
+        CHECK(v[0].max == mx);
+    }
+    w.Close();
+    return 0;
+}
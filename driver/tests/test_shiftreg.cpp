@@ -0,0 +1,121 @@
+// CShiftRegBatch: the number of shift-outs and the register values seen by the chip
+
+#include <memory>
+#include "ShiftReg.h"
+#include "check.hpp"
+
+namespace {
+
+// the chip side of the register: collects the bits shifted in and latches them on the strobe
+struct Chip {
+    bool data = false;
+    unsigned bit = 0;
+    unsigned long shifting = 0;
+    unsigned long latched = 0;
+    unsigned strobes = 0;
+};
+
+class ChipPin : public CPin {
+public:
+    enum Role { DATA, CLOCK, STROBE };
+
+    ChipPin(Chip& chip, Role role) : chip(chip), role(role) {}
+
+protected:
+    void impl_Set(bool how) override {
+        if (how && role == CLOCK) {
+            if (chip.data) chip.shifting |= 1ul << chip.bit;
+            chip.bit++;
+        } else if (how && role == STROBE) {
+            chip.latched = chip.shifting;
+            chip.shifting = 0;
+            chip.bit = 0;
+            chip.strobes++;
+        } else if (role == DATA) {
+            chip.data = how;
+        }
+        value = how;
+    }
+    bool impl_RbSet() override { return value; }
+    bool impl_Get() override { return value; }
+
+private:
+    Chip& chip;
+    Role role;
+    bool value = false;
+};
+
+}
+
+int main() {
+    Chip chip;
+    auto sr = std::make_shared<CDMSsr>(std::make_shared<ChipPin>(chip, ChipPin::DATA),
+                                       std::make_shared<ChipPin>(chip, ChipPin::CLOCK),
+                                       std::make_shared<ChipPin>(chip, ChipPin::STROBE));
+    CDMSsr::pins iepePins[] = {CDMSsr::IEPE1_On, CDMSsr::IEPE2_On, CDMSsr::IEPE3_On, CDMSsr::IEPE4_On};
+    std::shared_ptr<CShiftRegPin> iepe[4];
+    for (int i = 0; i < 4; i++) iepe[i] = sr->FactoryPin(iepePins[i]);
+    auto cs = sr->FactoryPin(CDMSsr::QSPI_CS1, true);
+    CHECK(!sr->FactoryPin(CDMSsr::IEPE1_On));
+
+    // without a batch every pin change is a shift-out
+    for (auto& p: iepe) p->Set(true);
+    CHECK(sr->GetShiftCount() == 4);
+    CHECK(chip.strobes == 4);
+    CHECK(chip.latched == 0xf);
+
+    // a batch shifts out once at the commit
+    {
+        CShiftRegBatchLock batch;
+        for (auto& p: iepe) p->Set(false);
+        CHECK(sr->GetShiftCount() == 4);
+        CHECK(chip.latched == 0xf);
+    }
+    CHECK(sr->GetShiftCount() == 5);
+    CHECK(chip.latched == 0);
+
+    // nested batches: only the outermost commit shifts out
+    {
+        CShiftRegBatchLock outer;
+        iepe[0]->Set(true);
+        {
+            CShiftRegBatchLock inner;
+            iepe[1]->Set(true);
+        }
+        CHECK(sr->GetShiftCount() == 5);
+        iepe[2]->Set(true);
+    }
+    CHECK(sr->GetShiftCount() == 6);
+    CHECK(chip.latched == 0x7);
+
+    // a batch without changes does not shift out
+    {
+        CShiftRegBatchLock batch;
+    }
+    CHECK(sr->GetShiftCount() == 6);
+
+    // a chip select is not deferred: it goes out at once with the pending changes, the commit has nothing left
+    {
+        CShiftRegBatchLock batch;
+        iepe[3]->Set(true);
+        cs->Set(true);
+        CHECK(sr->GetShiftCount() == 7);
+        CHECK(chip.latched == (0xful | 1ul << CDMSsr::QSPI_CS1));
+        cs->Set(false);
+        CHECK(sr->GetShiftCount() == 8);
+    }
+    CHECK(sr->GetShiftCount() == 8);
+    CHECK(chip.latched == 0xf);
+
+    // a direct register write inside a batch clears the pending changes
+    {
+        CShiftRegBatchLock batch;
+        iepe[0]->Set(false);
+        sr->SetShiftReg(0x100);
+        CHECK(sr->GetShiftCount() == 9);
+    }
+    CHECK(sr->GetShiftCount() == 9);
+    CHECK(chip.latched == 0x100);
+
+    return 0;
+}
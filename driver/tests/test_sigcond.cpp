@@ -0,0 +1,131 @@
+// CSigCond: the float biquad kernel against a double reference, the Butterworth response and the window values
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include "sigcond.h"
+#include "check.hpp"
+
+namespace {
+
+// the same 4th order Butterworth low-pass in double precision, Direct Form I
+class Reference {
+public:
+    Reference(double fs, double fc) {
+        const double q[2] = {0.54119610014619698, 1.3065629648763766};
+        const double w0 = 2 * M_PI * fc / fs;
+        for (int i = 0; i < 2; i++) {
+            const double alpha = std::sin(w0) / (2 * q[i]);
+            const double a0 = 1 + alpha;
+            b[i][0] = (1 - std::cos(w0)) / 2 / a0;
+            b[i][1] = (1 - std::cos(w0)) / a0;
+            b[i][2] = b[i][0];
+            a[i][1] = -2 * std::cos(w0) / a0;
+            a[i][2] = (1 - alpha) / a0;
+        }
+    }
+
+    double Filter(double x) {
+        if (first) {
+            // the steady state of the input value, like the kernel preload
+            for (auto& s: st) s = {x, x, x, x};
+            first = false;
+        }
+        for (int i = 0; i < 2; i++) {
+            auto& s = st[i];
+            const double y = b[i][0] * x + b[i][1] * s[0] + b[i][2] * s[1] - a[i][1] * s[2] - a[i][2] * s[3];
+            s = {x, s[0], y, s[2]};
+            x = y;
+        }
+        return x;
+    }
+
+private:
+    double b[2][3];
+    double a[2][3];
+    std::array<double, 4> st[2] = {};
+    bool first = true;
+};
+
+// the Butterworth magnitude of the bilinear transform at the frequency
+double butterworth(double fs, double fc, double f) {
+    return 1 / std::sqrt(1 + std::pow(std::tan(M_PI * f / fs) / std::tan(M_PI * fc / fs), 8));
+}
+
+// the amplitude of the filtered sine from its RMS over whole periods after the transient
+double amplitude(CSigCond& cond, double fs, double f) {
+    double sumSq = 0;
+    const int n = int(fs * 4);
+    for (int i = 0; i < n; i++) {
+        const float y = cond.Filter(float(1000 * std::sin(2 * M_PI * f * i / fs)));
+        if (i >= n / 2) sumSq += double(y) * y;
+    }
+    return std::sqrt(2 * sumSq / (n / 2)) / 1000;
+}
+
+}
+
+int main() {
+    // the kernel follows the double reference, the input is an ADC-like signal around mid-scale
+    {
+        CSigCond cond;
+        cond.SetCutoff(50);
+        Reference ref(1000, 50);
+        double maxErr = 0;
+        uint32_t seed = 1;
+        for (int i = 0; i < 100000; i++) {
+            seed = seed * 1664525 + 1013904223;
+            const double x = 2048 + 1500 * std::sin(2 * M_PI * 7 * i / 1000.0) + (seed >> 22) - 512;
+            maxErr = std::max(maxErr, std::fabs(cond.Filter(float(x)) - ref.Filter(float(x))));
+        }
+        CHECK(maxErr < 0.05);
+    }
+
+    // no startup transient: a constant input comes out unchanged from the first sample,
+    // within the DC gain error of the float coefficients
+    {
+        CSigCond cond;
+        cond.SetCutoff(10);
+        for (int i = 0; i < 1000; i++) CHECK_NEAR(cond.Filter(3000), 3000, 0.3);
+    }
+
+    // the magnitude response is the Butterworth one: the pass band, -3 dB at the cutoff, 80 dB/decade beyond
+    for (double f: {5.0, 50.0, 100.0, 200.0}) {
+        CSigCond cond;
+        cond.SetCutoff(50);
+        CHECK_NEAR(amplitude(cond, 1000, f), butterworth(1000, 50, f), 0.002);
+    }
+
+    // the cutoff follows the sample rate: it is fitted to the new range and the response is for the new rate
+    {
+        CSigCond cond;
+        cond.SetCutoff(400);
+        CHECK(cond.GetCutoff() == 400);
+        cond.SetSampleRate(250);
+        CHECK(cond.GetCutoff() == 100);
+        cond.SetCutoff(25);
+        CHECK_NEAR(amplitude(cond, 250, 25), M_SQRT1_2, 0.002);
+        CHECK_NEAR(amplitude(cond, 250, 50), butterworth(250, 25, 50), 0.002);
+    }
+
+    // the RMS and the peak of a long window: a small ripple on a large offset needs a double sum of squares
+    {
+        CSigCond cond;
+        const unsigned window = 60000;
+        cond.SetWindow(window);
+        double sumSq = 0;
+        float peak = 0;
+        for (unsigned i = 0; i < window; i++) {
+            const float x = float(3000 + 3 * std::sin(2 * M_PI * i / 100.0)) + (i % 7) * 0.1f;
+            cond.Process(x);
+            sumSq += double(x) * x;
+            peak = std::max(peak, std::fabs(x));
+            if (i + 1 < window) CHECK(cond.GetRMS() == 0);
+        }
+        CHECK_NEAR(cond.GetRMS(), std::sqrt(sumSq / window), 1e-3);
+        CHECK(cond.GetPeak() == peak);
+    }
+
+    return 0;
+}
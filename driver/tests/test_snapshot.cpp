@@ -0,0 +1,173 @@
+// the board health snapshot from the firmware record to the driver: the record encoded as the "Snap" access point
+// sends it, decoded by the driver at the layout version 1 offsets, the size, version and hex checks
+
+#include <cctype>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "BoardSnapshot.h"
+#include "timeswipe_snapshot.hpp"
+#include "check.hpp"
+
+namespace {
+
+using Record = CBoardSnapshot::record;
+
+// every field gets a value of its own, the floats are not representable as integers
+Record makeRecord()
+{
+    Record r = {};
+    r.m_Version = CBoardSnapshot::m_Version;
+    r.m_Size = sizeof(Record);
+    r.m_nSeq = 0x01020304;
+    r.m_Time_mS = 0xa0b0c0d0;
+    r.m_TempC = 41.25f;
+    r.m_FanOn = 1;
+    r.m_PWMon = 2;
+    r.m_Reserved = 0xffff;
+    for (int i = 0; i < CBoardSnapshot::nADC; i++) {
+        r.m_ADCraw[i] = uint16_t(1000 + i);
+        r.m_ADCflt[i] = 1.5f + i;
+        r.m_ADCrms[i] = 0.125f * (i + 1);
+        r.m_ADCpeak[i] = -3.75f - i;
+    }
+    for (int i = 0; i < CBoardSnapshot::nDAC; i++) r.m_DACraw[i] = uint16_t(2000 + i);
+    for (int i = 0; i < CBoardSnapshot::nAOUT; i++) r.m_AOUTraw[i] = uint16_t(3000 + i);
+    for (int i = 0; i < CBoardSnapshot::nPWM; i++) {
+        r.m_PWMfreq[i] = 50000 + i;
+        r.m_PWMrepeats[i] = 7 + i;
+        r.m_PWMduty[i] = 0.25f + 0.5f * i;
+        r.m_PWMhigh[i] = uint16_t(4000 + i);
+        r.m_PWMlow[i] = uint16_t(100 + i);
+    }
+    return r;
+}
+
+bool decode(const std::string& hex, TimeSwipeSnapshot& snap)
+{
+    std::vector<uint8_t> rec;
+    return TimeSwipeSnapshotRecord::FromHex(hex, rec) && TimeSwipeSnapshotRecord::Decode(rec, snap);
+}
+
+// the firmware record puts its fields where the driver reads them
+void checkOffsets()
+{
+    CHECK(sizeof(Record) == TimeSwipeSnapshotRecord::V1_SIZE);
+    CHECK(offsetof(Record, m_Version) == 0);
+    CHECK(offsetof(Record, m_Size) == 2);
+    CHECK(offsetof(Record, m_nSeq) == 4);
+    CHECK(offsetof(Record, m_Time_mS) == 8);
+    CHECK(offsetof(Record, m_TempC) == 12);
+    CHECK(offsetof(Record, m_FanOn) == 16);
+    CHECK(offsetof(Record, m_PWMon) == 17);
+    CHECK(offsetof(Record, m_ADCraw) == 20);
+    CHECK(offsetof(Record, m_ADCflt) == 28);
+    CHECK(offsetof(Record, m_ADCrms) == 44);
+    CHECK(offsetof(Record, m_ADCpeak) == 60);
+    CHECK(offsetof(Record, m_DACraw) == 76);
+    CHECK(offsetof(Record, m_AOUTraw) == 84);
+    CHECK(offsetof(Record, m_PWMfreq) == 88);
+    CHECK(offsetof(Record, m_PWMrepeats) == 96);
+    CHECK(offsetof(Record, m_PWMduty) == 104);
+    CHECK(offsetof(Record, m_PWMhigh) == 112);
+    CHECK(offsetof(Record, m_PWMlow) == 116);
+}
+
+void checkRoundTrip()
+{
+    const Record r = makeRecord();
+    const std::string hex = CBoardSnapshot::Encode(r);
+    CHECK(hex.size() == 2 * sizeof(Record));
+    CHECK(hex.substr(0, 8) == "01007800");
+    CHECK(hex.substr(8, 8) == "04030201");
+
+    TimeSwipeSnapshot snap;
+    CHECK(decode(hex, snap));
+    CHECK(snap.version == 1);
+    CHECK(snap.seq == r.m_nSeq);
+    CHECK(snap.time_ms == r.m_Time_mS);
+    CHECK(snap.temperature == r.m_TempC);
+    CHECK(snap.fan_on);
+    CHECK(!snap.pwm_active[0] && snap.pwm_active[1]);
+    for (int i = 0; i < CBoardSnapshot::nADC; i++) {
+        CHECK(snap.adc_raw[i] == r.m_ADCraw[i]);
+        CHECK(snap.adc_filtered[i] == r.m_ADCflt[i]);
+        CHECK(snap.adc_rms[i] == r.m_ADCrms[i]);
+        CHECK(snap.adc_peak[i] == r.m_ADCpeak[i]);
+    }
+    for (int i = 0; i < CBoardSnapshot::nDAC; i++) CHECK(snap.dac_raw[i] == r.m_DACraw[i]);
+    for (int i = 0; i < CBoardSnapshot::nAOUT; i++) CHECK(snap.aout_raw[i] == r.m_AOUTraw[i]);
+    for (int i = 0; i < CBoardSnapshot::nPWM; i++) {
+        CHECK(snap.pwm_frequency[i] == r.m_PWMfreq[i]);
+        CHECK(snap.pwm_repeats[i] == r.m_PWMrepeats[i]);
+        CHECK(snap.pwm_duty_cycle[i] == r.m_PWMduty[i]);
+        CHECK(snap.pwm_high[i] == r.m_PWMhigh[i]);
+        CHECK(snap.pwm_low[i] == r.m_PWMlow[i]);
+    }
+
+    // the other fan and PWM states
+    Record off = r;
+    off.m_FanOn = 0;
+    off.m_PWMon = 3;
+    CHECK(decode(CBoardSnapshot::Encode(off), snap));
+    CHECK(!snap.fan_on && snap.pwm_active[0] && snap.pwm_active[1]);
+
+    // the upper case hex is taken too
+    std::string upper = hex;
+    for (auto& c: upper) c = char(std::toupper(c));
+    TimeSwipeSnapshot snapUpper;
+    CHECK(decode(upper, snapUpper));
+    CHECK(snapUpper.time_ms == r.m_Time_mS && snapUpper.pwm_low[1] == r.m_PWMlow[1]);
+}
+
+void checkRejected()
+{
+    const Record r = makeRecord();
+    const std::string hex = CBoardSnapshot::Encode(r);
+    TimeSwipeSnapshot snap;
+
+    // the hex string
+    std::vector<uint8_t> rec;
+    CHECK(!TimeSwipeSnapshotRecord::FromHex("", rec));
+    CHECK(!TimeSwipeSnapshotRecord::FromHex(hex.substr(1), rec));
+    for (char bad: {'g', 'G', ' ', '-', 'x'}) {
+        std::string corrupted = hex;
+        corrupted[101] = bad;
+        CHECK(!TimeSwipeSnapshotRecord::FromHex(corrupted, rec));
+    }
+
+    // shorter than version 1
+    CHECK(!decode(hex.substr(0, hex.size() - 2), snap));
+    CHECK(!decode("01000200", snap));
+
+    // the header size does not match the record
+    Record wrongSize = r;
+    wrongSize.m_Size = sizeof(Record) + 1;
+    CHECK(!decode(CBoardSnapshot::Encode(wrongSize), snap));
+    wrongSize.m_Size = sizeof(Record) - 1;
+    CHECK(!decode(CBoardSnapshot::Encode(wrongSize), snap));
+
+    // no version
+    Record noVersion = r;
+    noVersion.m_Version = 0;
+    CHECK(!decode(CBoardSnapshot::Encode(noVersion), snap));
+
+    // a later version appends fields: the known part is decoded
+    Record v2 = r;
+    v2.m_Version = 2;
+    v2.m_Size = sizeof(Record) + 4;
+    CHECK(decode(CBoardSnapshot::Encode(v2) + "deadbeef", snap));
+    CHECK(snap.version == 2);
+    CHECK(snap.seq == r.m_nSeq && snap.pwm_low[1] == r.m_PWMlow[1]);
+}
+
+} // namespace
+
+int main()
+{
+    checkOffsets();
+    checkRoundTrip();
+    checkRejected();
+    return 0;
+}
@@ -26,6 +26,13 @@ public:
      * \return Immediately measured analog value in raw-binary format
      */
     virtual int DirectMeasure(){return CADchan::GetRawBinVal(); }
+
+    /*!
+     * \brief Selects a fast (coarse) or a precise conversion mode for the direct measurements
+     * \param how true=fast, false=precise (default)
+     * \details Used by calibration procedures: the coarse steps can be made faster. Does nothing by default
+     */
+    virtual void SetFastMode(bool how){}
     //virtual ~CAdc(){}  //just to keep polymorphic behaviour, should be never called
 
 };
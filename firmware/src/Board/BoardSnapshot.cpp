@@ -0,0 +1,93 @@
+/*
+This Source Code Form is subject to the terms of the GNU General Public License v3.0.
+If a copy of the GPL was not distributed with this
+file, You can obtain one at https://www.gnu.org/licenses/gpl-3.0.html
+Copyright (c) 2019-2020 Panda Team
+*/
+
+#include "BoardSnapshot.h"
+#include "os.h"
+#include "SamADCcntr.h"
+#include "SamTempSensor.h"
+#include "SigCond.h"
+#include "DAC.h"
+#include "DACPWMht.h"
+#include "FanControlSimple.h"
+
+void CBoardSnapshot::SetPeriod(unsigned int nPeriod_mS)
+{
+    if(nPeriod_mS<10)
+        nPeriod_mS=10;
+    if(nPeriod_mS>60000)
+        nPeriod_mS=60000;
+
+    m_Period_mS=nPeriod_mS;
+}
+
+std::string CBoardSnapshot::GetSnapshot()
+{
+    //build the first record on demand:
+    if(0==m_Record.m_Size)
+        Snap();
+
+    return Encode(m_Record);
+}
+
+void CBoardSnapshot::Snap()
+{
+    record &r=m_Record;
+
+    r.m_Version=m_Version;
+    r.m_Size=sizeof(record);
+    r.m_nSeq++;
+    r.m_Time_mS=os::get_tick_mS();
+
+    r.m_TempC=m_pTempSens ? m_pTempSens->GetTempCD():0;
+    r.m_FanOn=(m_pFan && m_pFan->IsOn()) ? 1:0;
+
+    r.m_PWMon=0;
+    for(int i=0; i<nPWM; i++)
+    {
+        if(!m_pPWM[i])
+            continue;
+
+        if(m_pPWM[i]->IsStarted())
+            r.m_PWMon|=(1<<i);
+        r.m_PWMfreq[i]=m_pPWM[i]->GetFrequency();
+        r.m_PWMrepeats[i]=m_pPWM[i]->GetRepeats();
+        r.m_PWMduty[i]=m_pPWM[i]->GetDutyCycle();
+        r.m_PWMhigh[i]=m_pPWM[i]->GetHighLevel();
+        r.m_PWMlow[i]=m_pPWM[i]->GetLowLevel();
+    }
+    for(int i=0; i<nADC; i++)
+    {
+        if(m_pADC[i])
+            r.m_ADCraw[i]=m_pADC[i]->GetRawBinVal();
+        if(m_pSigCond[i])
+        {
+            r.m_ADCflt[i]=m_pSigCond[i]->GetVal();
+            r.m_ADCrms[i]=m_pSigCond[i]->GetRMS();
+            r.m_ADCpeak[i]=m_pSigCond[i]->GetPeak();
+        }
+    }
+    for(int i=0; i<nDAC; i++)
+    {
+        if(m_pDAC[i])
+            r.m_DACraw[i]=m_pDAC[i]->GetRawBinVal();
+    }
+    for(int i=0; i<nAOUT; i++)
+    {
+        if(m_pAOUT[i])
+            r.m_AOUTraw[i]=m_pAOUT[i]->GetRawBinVal();
+    }
+}
+
+void CBoardSnapshot::Update()
+{
+    unsigned long CurTime=os::get_tick_mS();
+    if( (CurTime-m_LastSnap_mS)<m_Period_mS )
+        return;
+
+    m_LastSnap_mS=CurTime;
+    Snap();
+}
@@ -0,0 +1,204 @@
+/*
+This Source Code Form is subject to the terms of the GNU General Public License v3.0.
+If a copy of the GPL was not distributed with this
+file, You can obtain one at https://www.gnu.org/licenses/gpl-3.0.html
+Copyright (c) 2019-2020 Panda Team
+*/
+
+/*!
+*   \file
+*   \brief A definition file for
+*   CBoardSnapshot
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <stdint.h>
+
+//the record and its encoding do not depend on the hardware, the sources are only referenced:
+class CSamTempSensor;
+class CFanControlSimple;
+class CSamADCchan;
+class CSigCondChan;
+class CDac;
+class CDacPWMht;
+
+/*!
+ * \brief The periodic board health snapshot
+ * \details Packs all monitor readings (core temperature, monitor ADC channels with their conditioning results),
+ *  fan state, DAC and PWM state into one versioned binary record. The record is rebuilt periodically in Update()
+ *  and can be read as a whole in a single "Snap" access point transaction.
+ *  Since the communication protocol is text-based the record is transferred as a hexadecimal string (2 chars per byte).
+ *  The record layout is little-endian and packed. New fields must be added only to the end of the record
+ *  with incrementing m_Version, thus a reader can always decode the known part of the record.
+ */
+class CBoardSnapshot
+{
+public:
+
+    /*!
+     * \brief The number of monitor ADC, DAC and PWM channels in the record
+     */
+    enum{
+
+        nADC=4,
+        nDAC=4,
+        nAOUT=2,
+        nPWM=2
+    };
+
+    /*!
+     * \brief The current record layout version
+     */
+    static constexpr uint16_t m_Version=1;
+
+    /*!
+     * \brief The snapshot binary record (layout version 1)
+     */
+    struct __attribute__((packed)) record{
+
+        uint16_t m_Version;             //!<the record layout version
+        uint16_t m_Size;                //!<the record size in bytes
+        uint32_t m_nSeq;                //!<the snapshot sequence number
+        uint32_t m_Time_mS;             //!<the snapshot time stamp, milliseconds
+        float    m_TempC;               //!<the core temperature, degrees Celsius
+        uint8_t  m_FanOn;               //!<the fan state: 1=on, 0=off
+        uint8_t  m_PWMon;               //!<the PWM states: bit0=PWM1, bit1=PWM2
+        uint16_t m_Reserved;            //!<reserved for alignment
+        uint16_t m_ADCraw[nADC];        //!<the monitor ADC values in the raw-binary format
+        float    m_ADCflt[nADC];        //!<the filtered monitor ADC values in the raw-binary format
+        float    m_ADCrms[nADC];        //!<the RMS of the filtered monitor ADC values in the raw-binary format
+        float    m_ADCpeak[nADC];       //!<the peak of the filtered monitor ADC values in the raw-binary format
+        uint16_t m_DACraw[nDAC];        //!<the offset DAC values in the raw-binary format
+        uint16_t m_AOUTraw[nAOUT];      //!<the analog outputs #3,#4 values in the raw-binary format
+        uint32_t m_PWMfreq[nPWM];       //!<the PWM frequencies, Hz
+        uint32_t m_PWMrepeats[nPWM];    //!<the PWM repeats setting
+        float    m_PWMduty[nPWM];       //!<the PWM duty cycles
+        uint16_t m_PWMhigh[nPWM];       //!<the PWM high levels in the raw-binary format
+        uint16_t m_PWMlow[nPWM];        //!<the PWM low levels in the raw-binary format
+    };
+    static_assert(sizeof(record)==120, "the layout version 1 record is 120 bytes, see CommunicationProtocol.md");
+
+    /*!
+     * \brief Encodes a record for the transfer
+     * \param r The record
+     * \return The record in the hexadecimal string format (lowercase, 2 chars per byte)
+     */
+    static std::string Encode(const record &r)
+    {
+        static const char hex[]="0123456789abcdef";
+
+        const uint8_t *pData=reinterpret_cast<const uint8_t*>(&r);
+        std::string str;
+        str.reserve(2*sizeof(record));
+        for(std::size_t i=0; i<sizeof(record); i++)
+        {
+            str+=hex[pData[i]>>4];
+            str+=hex[pData[i]&0x0f];
+        }
+        return str;
+    }
+
+protected:
+
+    /*!
+     * \brief The last built record
+     */
+    record m_Record={};
+
+    /*!
+     * \brief The snapshot period, milliseconds
+     */
+    unsigned int m_Period_mS=100;
+
+    /*!
+     * \brief The time stamp of the last snapshot, milliseconds
+     */
+    unsigned long m_LastSnap_mS=0;
+
+    std::shared_ptr<CSamTempSensor>    m_pTempSens;               //!<the core temperature sensor
+    std::shared_ptr<CFanControlSimple> m_pFan;                    //!<the fan control
+    std::shared_ptr<CSamADCchan>       m_pADC[nADC];              //!<the monitor ADC channels
+    std::shared_ptr<CSigCondChan>      m_pSigCond[nADC];          //!<the monitor ADC signal conditioning
+    std::shared_ptr<CDac>              m_pDAC[nDAC];              //!<the offset DACs
+    std::shared_ptr<CDac>              m_pAOUT[nAOUT];            //!<the analog outputs #3,#4
+    std::shared_ptr<CDacPWMht>         m_pPWM[nPWM];              //!<the PWMs
+
+    /*!
+     * \brief Builds a new record from the current board state
+     */
+    void Snap();
+
+public:
+
+    /*!
+     * \brief Sets the monitor sources
+     * \param pTempSens The core temperature sensor
+     * \param pFan The fan control
+     */
+    void SetMonitor(const std::shared_ptr<CSamTempSensor> &pTempSens, const std::shared_ptr<CFanControlSimple> &pFan)
+    {
+        m_pTempSens=pTempSens;
+        m_pFan=pFan;
+    }
+
+    /*!
+     * \brief Sets a monitor ADC channel source
+     * \param nCh The channel index (from 0)
+     * \param pADC The monitor ADC channel
+     * \param pSigCond The signal conditioning of the channel
+     */
+    void SetADC(int nCh, const std::shared_ptr<CSamADCchan> &pADC, const std::shared_ptr<CSigCondChan> &pSigCond)
+    {
+        m_pADC[nCh]=pADC;
+        m_pSigCond[nCh]=pSigCond;
+    }
+
+    /*!
+     * \brief Sets an offset DAC source
+     * \param nCh The channel index (from 0)
+     * \param pDAC The DAC channel
+     */
+    void SetDAC(int nCh, const std::shared_ptr<CDac> &pDAC){ m_pDAC[nCh]=pDAC; }
+
+    /*!
+     * \brief Sets an analog output source
+     * \param nCh The output index (from 0 that means the analog output #3)
+     * \param pAOUT The DAC channel
+     */
+    void SetAOUT(int nCh, const std::shared_ptr<CDac> &pAOUT){ m_pAOUT[nCh]=pAOUT; }
+
+    /*!
+     * \brief Sets a PWM source
+     * \param nCh The PWM index (from 0)
+     * \param pPWM The PWM
+     */
+    void SetPWM(int nCh, const std::shared_ptr<CDacPWMht> &pPWM){ m_pPWM[nCh]=pPWM; }
+
+    /*!
+     * \brief Returns the last built record
+     * \return The record in the hexadecimal string format
+     */
+    std::string GetSnapshot();
+
+    /*!
+     * \brief Returns the snapshot period
+     * \return The period, milliseconds
+     */
+    unsigned int GetPeriod(){ return m_Period_mS; }
+
+    /*!
+     * \brief Sets the snapshot period
+     * \param nPeriod_mS The period, milliseconds (fitted to the 10..60000 range)
+     */
+    void SetPeriod(unsigned int nPeriod_mS);
+
+    /*!
+     * \brief The object state update method
+     * \details Rebuilds the record when the snapshot period is elapsed.
+     *  Must be called from a "super loop" or from corresponding thread
+     */
+    void Update();
+};
@@ -28,6 +28,8 @@
  *
  * CPinPWM - the class implements a PWM which output is controlled by the SAM's pin with DMA support
  *
+ * CBootTiming - the firmware boot phases profiler: measures the startup phases duration with the CPU cycle counter
+ *
  * CFanControl - the class implements control of fan in PWM mode with several fixed speeds
  *
  * CFanControlSimple - the class implements simple control of fan in ON/OFF mode
@@ -36,6 +38,10 @@
  *
  * CSPIcomm - provides functionality for external communication via SPI with integrated flow-control (CSyncSerComFSM)
  *
+ * CSetpointSeq - the timed setpoint sequencer: executes an uploaded sequence of access point writes at given time offsets
+ *
+ * CSigCondChan - onboard signal-conditioning of a monitor ADC channel: low-pass biquad filtering, RMS and peak detection
+ *
  */
  
  
@@ -0,0 +1,40 @@
+/*
+This Source Code Form is subject to the terms of the GNU General Public License v3.0.
+If a copy of the GPL was not distributed with this
+file, You can obtain one at https://www.gnu.org/licenses/gpl-3.0.html
+Copyright (c) 2019-2020 Panda Team
+*/
+
+#include "BootTiming.h"
+#include "os.h"
+
+unsigned long   CBootTiming::m_StartCycles=0;
+unsigned long   CBootTiming::m_LastMarkCycles=0;
+unsigned int    CBootTiming::m_Phase_uS[CBootTiming::total+1];
+int             CBootTiming::m_nNextPhase=0;
+bool            CBootTiming::m_bOrdered=true;
+
+void CBootTiming::Start()
+{
+    m_StartCycles=os::get_cycles();
+    m_LastMarkCycles=m_StartCycles;
+    m_nNextPhase=0;
+    m_bOrdered=true;
+}
+
+void CBootTiming::Mark(phase nPhase)
+{
+    unsigned long CurCycles=os::get_cycles();
+
+    if(nPhase!=m_nNextPhase)
+        m_bOrdered=false;
+
+    if(total==nPhase)
+    {
+        m_Phase_uS[total]=os::cycles_to_uS(CurCycles-m_StartCycles);
+        return;
+    }
+    m_Phase_uS[nPhase]=os::cycles_to_uS(CurCycles-m_LastMarkCycles);
+    m_LastMarkCycles=CurCycles;
+    m_nNextPhase=nPhase+1;
+}
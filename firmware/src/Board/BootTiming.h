@@ -0,0 +1,94 @@
+/*
+This Source Code Form is subject to the terms of the GNU General Public License v3.0.
+If a copy of the GPL was not distributed with this
+file, You can obtain one at https://www.gnu.org/licenses/gpl-3.0.html
+Copyright (c) 2019-2020 Panda Team
+*/
+
+/*!
+*   \file
+*   \brief A definition file for
+*   CBootTiming
+*/
+
+#pragma once
+
+/*!
+ * \brief The firmware boot phases profiler
+ * \details Measures the duration of the firmware startup phases with the CPU cycle counter.
+ *  Start() is called once the CPU clock is set up, then Mark() is called at the end of each phase in the phase order.
+ *  The duration of a phase is the time between its mark and the previous one.
+ *  A phase marked out of order, twice or skipped makes the durations meaningless: IsOrdered() tells about this.
+ *  The results are exposed via "Boot.*" access points
+ */
+class CBootTiming
+{
+public:
+
+    /*!
+     * \brief The boot phases in the order of execution
+     */
+    enum phase{
+
+        eeprom,         //!<HAT EEPROM image readout and verification
+        comm,           //!<communication bus and the command dispatcher creation
+        board,          //!<board pins, ADCs and DACs creation
+        periph,         //!<measurement channels and amplifiers setup
+        commands,       //!<access points registration
+        settings,       //!<loading persistent settings and the default mode setup
+        total           //!<the total boot time (the sum of all phases)
+    };
+
+protected:
+
+    /*!
+     * \brief The cycle counter value at the boot start
+     */
+    static unsigned long m_StartCycles;
+
+    /*!
+     * \brief The cycle counter value at the last mark
+     */
+    static unsigned long m_LastMarkCycles;
+
+    /*!
+     * \brief The measured phase durations, microseconds
+     */
+    static unsigned int m_Phase_uS[total+1];
+
+    /*!
+     * \brief The phase expected to be marked next
+     */
+    static int m_nNextPhase;
+
+    /*!
+     * \brief All phases were marked once in the order of execution so far
+     */
+    static bool m_bOrdered;
+
+public:
+
+    /*!
+     * \brief Starts the boot time measurement
+     */
+    static void Start();
+
+    /*!
+     * \brief Marks the end of a boot phase
+     * \param nPhase The finished phase. Marking the "total" phase finishes the measurement
+     */
+    static void Mark(phase nPhase);
+
+    /*!
+     * \brief Returns the measured duration of a boot phase
+     * \return The duration, microseconds
+     */
+    template<phase nPhase>
+    static unsigned int Get(){ return m_Phase_uS[nPhase]; }
+
+    /*!
+     * \brief Were the phases marked in the order of execution?
+     * \return true=each phase was marked once in the order of execution (and no phase is missing once "total" is marked)
+     */
+    static bool IsOrdered(){ return m_bOrdered; }
+};
@@ -20,8 +20,51 @@ CDac5715sa::CDac5715sa(CSPI *pBus, std::shared_ptr<IPin> pCS, typeDac5715chan nC
 	SetRange(RangeMin, RangeMax);
 }
 
-//driver function:
-void CDac5715sa::DriverSetVal(float val, int out_bin)
+int                         CDac5715batch::m_nOpenCnt=0;
+std::vector<CDac5715sa*>    CDac5715batch::m_Pending;
+
+void CDac5715batch::Enqueue(CDac5715sa *pDAC)
+{
+    for(auto *p : m_Pending)
+    {
+        if(p==pDAC)
+            return;
+    }
+    m_Pending.emplace_back(pDAC);
+}
+
+void CDac5715batch::Commit()
+{
+    if(m_nOpenCnt>0)
+        m_nOpenCnt--;
+
+    if(m_nOpenCnt>0)
+        return;
+
+    //! flush chip by chip: the channels of the same chip share the chip select
+    while(!m_Pending.empty())
+    {
+        IPin *pCS=m_Pending.front()->m_pCS.get();
+        m_Pending.front()->SetupBus();
+
+        CDac5715sa *pLast=nullptr;
+        for(auto it=m_Pending.begin(); it!=m_Pending.end();)
+        {
+            if((*it)->m_pCS.get()!=pCS)
+            {
+                it++; continue;
+            }
+            if(pLast)
+                pLast->SendCmd(CDac5715sa::cmd::CODEn, pLast->m_RawBinaryVal);
+
+            pLast=*it;
+            it=m_Pending.erase(it);
+        }
+        pLast->SendCmd(CDac5715sa::cmd::CODEn_LOAD_ALL, pLast->m_RawBinaryVal);
+    }
+}
+
+void CDac5715sa::SetupBus()
 {
     /*!
      * m_pBus->set_phpol(false, true);
@@ -37,20 +80,38 @@ void CDac5715sa::DriverSetVal(float val, int out_bin)
     //! m_pBus->set_baud_div(0xff);
     //! setup the bus buadrate divisor: rate=clock_speed/255;
 	m_pBus->set_baud_div(0xff);
+}
 
-    //! cmd<<(0x30+(int)m_chan)<<((out_bin>>4)&0xff)<<((out_bin<<4)&0xff);
+void CDac5715sa::SendCmd(cmd nCmd, int out_bin)
+{
+    //! cmd<<(nCmd+(int)m_chan)<<((out_bin>>4)&0xff)<<((out_bin<<4)&0xff);
     //! forms a controlling message to be sent via SPI(MAX5715 manual, page 18)
-    //! 1st byte: command 3(code value and load value "CODEn_LOADn")+channel number
+    //! 1st byte: command+channel number
     //! 2nd byte: control word high-byte
     //! 3nd byte: control word low byte
-	CFIFO cmd;
-	cmd<<(0x30+(int)m_chan)<<((out_bin>>4)&0xff)<<((out_bin<<4)&0xff);
+	CFIFO msg;
+	msg<<(nCmd+(int)m_chan)<<((out_bin>>4)&0xff)<<((out_bin<<4)&0xff);
 
     m_pCS->Set(true);
     //os::uwait(80);
 
-	m_pBus->send(cmd);
+	m_pBus->send(msg);
 
     m_pCS->Set(false);
     //os::uwait(80);
 }
+
+//driver function:
+void CDac5715sa::DriverSetVal(float val, int out_bin)
+{
+    if(CDac5715batch::IsOpen())
+    {
+        CDac5715batch::Enqueue(this);
+        return;
+    }
+
+    SetupBus();
+
+    //! command 3(code value and load value "CODEn_LOADn")
+    SendCmd(cmd::CODEn_LOADn, out_bin);
+}
@@ -10,7 +10,7 @@ Copyright (c) 2019 Panda Team
 /*!
 *   \file
 *   \brief A definition file for MAX5715 DAC's channel
-*   CDac5715sa
+*   CDac5715sa, CDac5715batch, CDac5715batchLock
 *
 */
 
@@ -26,10 +26,72 @@ enum class typeDac5715chan : int
     DACD    //!<channel D, #3
 };
 
+#include <memory>
+#include <vector>
 #include "SPI.h"
 #include "DAC.h"
 #include "Pin.h"
 
+class CDac5715sa;
+
+/*!
+ * \brief The MAX5715 simultaneous update builder
+ * \details While the batch is open (Begin() was called) output changes of all CDac5715sa channels are queued
+ *  instead of being sent immediately. Commit() flushes the queue chip by chip (channels sharing the same chip select):
+ *  the bus is configured once, all channels but the last one receive CODEn command (code register only) and the last one
+ *  receives CODEn_LOAD_ALL command, so all outputs of the chip change at the same moment.
+ *  The batches can be nested, the queue is flushed when the outermost batch is committed.
+ */
+class CDac5715batch
+{
+protected:
+
+    /*!
+     * \brief The batch nesting counter
+     */
+    static int m_nOpenCnt;
+
+    /*!
+     * \brief The list of channels having queued output values
+     */
+    static std::vector<CDac5715sa*> m_Pending;
+
+public:
+
+    /*!
+     * \brief Opens the batch: all following output changes are queued
+     */
+    static void Begin(){ m_nOpenCnt++; }
+
+    /*!
+     * \brief Closes the batch. Flushes the queue if this is the outermost batch
+     */
+    static void Commit();
+
+    /*!
+     * \brief Is the batch open?
+     * \return true=output changes are queued, false=output changes are sent immediately
+     */
+    static bool IsOpen(){ return m_nOpenCnt>0; }
+
+    /*!
+     * \brief Adds the channel to the list of channels to be flushed
+     * \param pDAC - the pointer to the channel
+     */
+    static void Enqueue(CDac5715sa *pDAC);
+};
+
+/*!
+ * \brief The MAX5715 batch auto-committer
+ * \details Opens the batch in the constructor and commits it when leaving the scope
+ */
+class CDac5715batchLock
+{
+public:
+    CDac5715batchLock(){ CDac5715batch::Begin(); }
+    ~CDac5715batchLock(){ CDac5715batch::Commit(); }
+};
+
 /*!
  * \brief The CDac5715sa class implements MAX5715 DAC's channel functionality
  *
@@ -46,8 +108,19 @@ enum class typeDac5715chan : int
 
 class CDac5715sa : public CDac //dac chan 5715 stand-alone version
 {
+friend class CDac5715batch;
 protected:
 
+    /*!
+     * \brief The MAX5715 commands used by the class (MAX5715 manual, page 18), channel number is added to the command
+     */
+    enum cmd{
+
+        CODEn=0x00,             //!<write the code register only
+        CODEn_LOAD_ALL=0x20,    //!<write the code register and load all DAC registers from their code registers
+        CODEn_LOADn=0x30        //!<write the code register and load the DAC register
+    };
+
     /*!
      * \brief m_pBus a pointer to SPI bus.
      */
@@ -68,6 +141,18 @@ protected:
      * \param out_bin output value in raw binary format - used directly by MAX5715
      */
 	virtual void DriverSetVal(float val, int out_bin);
+
+    /*!
+     * \brief Setups the SPI bus phase, polarity, timing profile and baudrate for MAX5715
+     */
+    void SetupBus();
+
+    /*!
+     * \brief Sends a single command to MAX5715 framed by the chip select
+     * \param nCmd - the command
+     * \param out_bin - the output value in raw binary format
+     */
+    void SendCmd(cmd nCmd, int out_bin);
 	
 public:
     /*!
@@ -41,3 +41,8 @@ void CFanControlSimple::Update()
         PORT->Group[m_PortGroup].OUTCLR.reg=(1L<<m_PortPin);
     }
 }
+
+bool CFanControlSimple::IsOn()
+{
+    return (PORT->Group[m_PortGroup].OUT.reg & (1L<<m_PortPin)) ? true:false;
+}
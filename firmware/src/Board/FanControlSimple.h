@@ -79,4 +79,10 @@ public:
      *  Must be called from a "super loop" or from corresponding thread
      */
     void Update();
+
+    /*!
+     * \brief Returns the fan state
+     * \return true=the fan is on, false=the fan is off
+     */
+    bool IsOn();
 };
@@ -37,6 +37,48 @@ bool CPGA280cmdBuf::transfer(CSPI &spi_bus, IPin &CS)
     return true;
 }
 
+int                     CPGA280batch::m_nOpenCnt=0;
+std::vector<CPGA280*>   CPGA280batch::m_Pending;
+unsigned int            CPGA280batch::m_LastCommit_uS=0;
+unsigned int            CPGA280batch::m_LastXfers=0;
+unsigned int            CPGA280batch::m_Errors=0;
+
+void CPGA280batch::Enqueue(CPGA280 *pPGA)
+{
+    for(auto *p : m_Pending)
+    {
+        if(p==pPGA)
+            return;
+    }
+    m_Pending.emplace_back(pPGA);
+}
+
+bool CPGA280batch::Commit()
+{
+    if(m_nOpenCnt>0)
+        m_nOpenCnt--;
+
+    if(m_nOpenCnt>0 || m_Pending.empty())
+        return true;
+
+    unsigned long StartCycles=os::get_cycles();
+    unsigned int nXfers=0;
+    bool bRes=true;
+    for(auto *pPGA : m_Pending)
+    {
+        if(!pPGA->FlushBatch(nXfers))
+        {
+            m_Errors++;
+            bRes=false;
+        }
+    }
+    m_Pending.clear();
+
+    m_LastCommit_uS=os::cycles_to_uS(os::get_cycles()-StartCycles);
+    m_LastXfers=nXfers;
+    return bRes;
+}
+
 CPGA280::CPGA280(std::shared_ptr<CSPI> pSPIbus, std::shared_ptr<IPin> pCS)
 {
     m_pSPIbus=pSPIbus;
@@ -59,11 +101,94 @@ bool CPGA280::ReadRegister(reg nReg, uint8_t &RegValue)
 }
 bool CPGA280::WriteRegister(reg nReg, uint8_t RegValue, bool TBUF)
 {
+    if(CPGA280batch::IsOpen())
+    {
+        if(m_BatchBuf.m_cmd.empty())
+            CPGA280batch::Enqueue(this);
+
+        m_BatchBuf.m_cmd.emplace_back(CPGA280cmd::cmd::write, nReg, RegValue, TBUF);
+        return true;
+    }
+
     m_CmdBuf.reset();
     m_CmdBuf.m_cmd.emplace_back(CPGA280cmd::cmd::write, nReg, RegValue, TBUF);
     return m_CmdBuf.transfer(*m_pSPIbus, *m_pCS);
 }
 
+bool CPGA280::FlushBatch(unsigned int &nXfers)
+{
+    if(m_BatchBuf.m_cmd.empty())
+        return true;
+
+    //all writes in one frame:
+    bool bRes=m_BatchBuf.transfer(*m_pSPIbus, *m_pCS);
+    nXfers++;
+
+    //collect the last written value of each register:
+    uint8_t ExpVal[8];
+    bool    bWritten[8]={false};
+    for(const auto &cmd : m_BatchBuf.m_cmd)
+    {
+        //write-only and self-clearing registers cannot be verified:
+        if(reg::soft_reset==cmd.m_Addr || reg::error==cmd.m_Addr)
+            continue;
+
+        ExpVal[cmd.m_Addr]=cmd.m_OutData;
+        bWritten[cmd.m_Addr]=true;
+    }
+    m_BatchBuf.reset();
+
+    if(!bRes)
+    {
+        ReloadCache(nXfers);
+        return false;
+    }
+
+    //all readbacks in one frame:
+    m_CmdBuf.reset();
+    for(uint8_t nReg=0; nReg<8; nReg++)
+    {
+        if(bWritten[nReg])
+            m_CmdBuf.m_cmd.emplace_back(CPGA280cmd::cmd::read, nReg, 0);
+    }
+    if(m_CmdBuf.m_cmd.empty())
+        return true;
+
+    bRes=m_CmdBuf.transfer(*m_pSPIbus, *m_pCS);
+    nXfers++;
+    if(bRes)
+    {
+        for(const auto &cmd : m_CmdBuf.m_cmd)
+        {
+            if(cmd.m_InData!=ExpVal[cmd.m_Addr])
+            {
+                bRes=false;
+                break;
+            }
+        }
+    }
+    if(!bRes)
+        ReloadCache(nXfers);
+
+    return bRes;
+}
+
+void CPGA280::ReloadCache(unsigned int &nXfers)
+{
+    m_CmdBuf.reset();
+    m_CmdBuf.m_cmd.emplace_back(CPGA280cmd::cmd::read, reg::gain_mux, 0);
+    m_CmdBuf.m_cmd.emplace_back(CPGA280cmd::cmd::read, reg::ISw1, 0);
+    nXfers++;
+    if(!m_CmdBuf.transfer(*m_pSPIbus, *m_pCS))
+        return; //the chip does not answer: nothing better than the requested values is known
+
+    m_GainMuxReg.reg=m_CmdBuf.m_cmd[0].m_InData;
+
+    typeCPGA280ISw1Reg sw1;
+    sw1.reg=m_CmdBuf.m_cmd[1].m_InData;
+    m_nMode=sw1.bit.SW_B1 ? mode::Current:mode::Voltage;
+}
+
  bool CPGA280::SetMode(mode nMode)
  {
      //switch1 (assuming all other switches are zero after reset)
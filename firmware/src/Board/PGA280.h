@@ -8,7 +8,7 @@ Copyright (c) 2019-2020 Panda Team
 /*!
 *   \file
 *   \brief A definition file for
-*   CPGA280
+*   CPGA280, CPGA280batch, CPGA280batchLock
 */
 
 
@@ -295,11 +295,108 @@ typedef union {
 } typeCPGA280ISw2Reg;
 
 
+class CPGA280;
+
+/*!
+ * \brief The PGA280 register transaction builder
+ * \details While the batch is open (Begin() was called) all register writes of all CPGA280 instances are queued
+ *  instead of being sent immediately. Commit() flushes the queue: all queued writes of a single PGA280 are packed
+ *  into one chip select frame followed by one readback frame verifying all written registers.
+ *  Thus a setting applied to four channels costs two transfers per chip instead of a transfer per register write.
+ *  The batches can be nested, the queue is flushed when the outermost batch is committed.
+ *  A chip that fails its frame or its readback has its cached mode and gains read back from the registers.
+ *  The timing of the last commit is exposed via the profiling access points.
+ */
+class CPGA280batch
+{
+protected:
+
+    /*!
+     * \brief The batch nesting counter
+     */
+    static int m_nOpenCnt;
+
+    /*!
+     * \brief The list of PGA280 instances having queued commands
+     */
+    static std::vector<CPGA280*> m_Pending;
+
+    /*!
+     * \brief The duration of the last commit, microseconds
+     */
+    static unsigned int m_LastCommit_uS;
+
+    /*!
+     * \brief The number of SPI transfers performed by the last commit
+     */
+    static unsigned int m_LastXfers;
+
+    /*!
+     * \brief The total number of failed transfers and readback mismatches
+     */
+    static unsigned int m_Errors;
+
+public:
+
+    /*!
+     * \brief Opens the batch: all following register writes are queued
+     */
+    static void Begin(){ m_nOpenCnt++; }
+
+    /*!
+     * \brief Closes the batch. Flushes the queue if this is the outermost batch
+     * \return true on success, false if any transfer or readback verification failed
+     */
+    static bool Commit();
+
+    /*!
+     * \brief Is the batch open?
+     * \return true=register writes are queued, false=register writes are sent immediately
+     */
+    static bool IsOpen(){ return m_nOpenCnt>0; }
+
+    /*!
+     * \brief Adds the PGA280 instance to the list of instances to be flushed
+     * \param pPGA - the pointer to the instance
+     */
+    static void Enqueue(CPGA280 *pPGA);
+
+    /*!
+     * \brief Returns the duration of the last commit (profiling)
+     * \return the duration in microseconds
+     */
+    static unsigned int GetLastCommitTime(){ return m_LastCommit_uS; }
+
+    /*!
+     * \brief Returns the number of SPI transfers performed by the last commit (profiling)
+     * \return the number of transfers
+     */
+    static unsigned int GetLastXfers(){ return m_LastXfers; }
+
+    /*!
+     * \brief Returns the total number of failed transfers and readback mismatches (profiling)
+     * \return the number of errors
+     */
+    static unsigned int GetErrors(){ return m_Errors; }
+};
+
+/*!
+ * \brief The PGA280 batch auto-committer
+ * \details Opens the batch in the constructor and commits it when leaving the scope
+ */
+class CPGA280batchLock
+{
+public:
+    CPGA280batchLock(){ CPGA280batch::Begin(); }
+    ~CPGA280batchLock(){ CPGA280batch::Commit(); }
+};
+
 /*!
  * \brief The PGA280 amplifier control class
  */
 class CPGA280
 {
+friend class CPGA280batch;
 public:
 
     /*!
@@ -497,6 +594,11 @@ protected:
      */
     CPGA280cmdBuf m_CmdBuf;
 
+    /*!
+     * \brief m_BatchBuf - the queue of register writes collected while CPGA280batch is open
+     */
+    CPGA280cmdBuf m_BatchBuf;
+
     /*!
      * \brief m_SelReg - the currently selected register
      */
@@ -528,4 +630,18 @@ protected:
      * \return true on success, false on any error
      */
     bool WriteRegister(reg nReg, uint8_t RegValue, bool TBUF=false);
+
+    /*!
+     * \brief Sends all queued register writes in one frame and verifies them with one readback frame
+     * \param nXfers - incremented by the number of performed SPI transfers
+     * \return true on success, false on any error or readback mismatch
+     */
+    bool FlushBatch(unsigned int &nXfers);
+
+    /*!
+     * \brief Reads the gain and the input switch registers back into m_GainMuxReg and m_nMode after a failed batch:
+     *  the setters cache the values once they are queued
+     * \param nXfers - incremented by the number of performed SPI transfers
+     */
+    void ReloadCache(unsigned int &nXfers);
 };
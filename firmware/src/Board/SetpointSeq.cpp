@@ -0,0 +1,197 @@
+/*
+This Source Code Form is subject to the terms of the GNU General Public License v3.0.
+If a copy of the GPL was not distributed with this
+file, You can obtain one at https://www.gnu.org/licenses/gpl-3.0.html
+Copyright (c) 2019-2020 Panda Team
+*/
+
+#include "SetpointSeq.h"
+#include "json_stream.h"
+#include "sam.h"
+
+Tc *glob_GetTcPtr(typeSamTC nTc);
+
+CSetpointSeq::CSetpointSeq(const std::shared_ptr<CCmdDispatcher> &pDisp) : CSamTC(typeSamTC::Tc6)
+{
+    m_pDisp=pDisp;
+    m_Steps.reserve(m_MaxSteps);
+}
+
+void CSetpointSeq::InitTimer()
+{
+    //tune the timer (32 bit, pair):
+    CSamTC::EnableAPBbus(true);
+    CSamTC::EnableAPBbus(typeSamTC::Tc7, true);
+
+    //1MHz clock from 48MHz DFLL:
+    m_pCLK=CSamCLK::Factory();
+    m_pCLK->SetDiv(48);
+    m_pCLK->Enable(true);
+    CSamTC::ConnectGCLK(m_pCLK->CLKind());
+
+    Tc *pTc=glob_GetTcPtr(m_nTC);
+    pTc->COUNT32.CTRLA.bit.MODE=2;      //32bit
+    pTc->COUNT32.WAVE.bit.WAVEGEN=0;    //NFRQ: free running up to 0xffffffff
+    pTc->COUNT32.CTRLA.bit.ENABLE=1;    //enable
+    while(pTc->COUNT32.SYNCBUSY.bit.ENABLE){}
+    pTc->COUNT32.CTRLBSET.bit.CMD=2;    //keep it in the stopped state!
+}
+
+unsigned int CSetpointSeq::GetTime_uS()
+{
+    Tc *pTc=glob_GetTcPtr(m_nTC);
+
+    while(pTc->COUNT32.SYNCBUSY.bit.CTRLB){}
+    pTc->COUNT32.CTRLBSET.bit.CMD=4;    //READSYNC
+    while(pTc->COUNT32.SYNCBUSY.bit.COUNT || pTc->COUNT32.SYNCBUSY.bit.CTRLB){}
+    return pTc->COUNT32.COUNT.reg;
+}
+
+std::string CSetpointSeq::GetSequence()
+{
+    nlohmann::json jseq=nlohmann::json::array();
+    for(const auto &st : m_Steps)
+    {
+        jseq.push_back({st.m_Time_uS, st.m_strAP, st.m_Val});
+    }
+    return jseq.dump();
+}
+
+void CSetpointSeq::SetSequence(std::string strSeq)
+{
+    if(status::running==m_Status)
+        throw CCmdException("seq_is_running!");
+
+    auto jseq=nlohmann::json::parse(strSeq);
+    if(!jseq.is_array() || jseq.size()>m_MaxSteps)
+        throw CCmdException("seq_format_err!");
+
+    std::vector<step> steps;
+    steps.reserve(m_MaxSteps);
+    for(auto &jst : jseq)
+    {
+        if(!jst.is_array() || 3!=jst.size() || !jst[0].is_number_unsigned() || !jst[1].is_string() || !jst[2].is_primitive())
+            throw CCmdException("seq_format_err!");
+
+        //! the timer counts 32 bits:
+        uint64_t nTime_uS=jst[0];
+        if(nTime_uS>0xFFFFFFFFull)
+            throw CCmdException("seq_time_err!");
+
+        //! the steps are executed in the upload order:
+        if(!steps.empty() && nTime_uS<steps.back().m_Time_uS)
+            throw CCmdException("seq_order_err!");
+
+        step st;
+        st.m_Time_uS=static_cast<unsigned int>(nTime_uS);
+        st.m_strAP=jst[1];
+        st.m_Val=jst[2];
+
+        //! the sequencer must not control itself
+        if(0==st.m_strAP.compare(0, 3, "Seq"))
+            throw CCmdException("seq_format_err!");
+
+        steps.emplace_back(std::move(st));
+    }
+
+    m_Steps.swap(steps);
+    m_nNextStep=0;
+    m_Status=status::idle;
+}
+
+void CSetpointSeq::Arm(bool how)
+{
+    Tc *pTc=glob_GetTcPtr(m_nTC);
+
+    if(!how)
+    {
+        if(status::running==m_Status)
+            Finish(status::aborted);
+        return;
+    }
+    if(status::running==m_Status || m_Steps.empty())
+        return;
+
+    if(!m_pCLK)
+        InitTimer();
+
+    m_nNextStep=0;
+    m_MaxLateness_uS=0;
+    m_Status=status::running;
+
+    while(pTc->COUNT32.SYNCBUSY.bit.CTRLB){}
+    pTc->COUNT32.CTRLBSET.bit.CMD=1;    //retrigger: count from zero
+}
+
+void CSetpointSeq::Finish(status nStatus)
+{
+    Tc *pTc=glob_GetTcPtr(m_nTC);
+
+    while(pTc->COUNT32.SYNCBUSY.bit.CTRLB){}
+    pTc->COUNT32.CTRLBSET.bit.CMD=2;    //stop
+    m_Status=nStatus;
+
+    nlohmann::json v=static_cast<int>(nStatus);
+    Fire_on_event("Seq", v);
+}
+
+bool CSetpointSeq::ExecStep(step &st)
+{
+    nlohmann::json jresp;
+    CJSONStream in(&st.m_Val);
+    CJSONStream out(&jresp);
+    CCmdCallDescr CallDescr;
+    CallDescr.m_pIn=&in;
+    CallDescr.m_pOut=&out;
+    CallDescr.m_strCommand=st.m_strAP;
+    CallDescr.m_ctype=CCmdCallDescr::ctype::ctSet;
+
+    //! JSON commands are disabled inside the sequence
+    CJSONCmdLock CmdLock(*this);
+    try{
+
+        return (typeCRes::OK==m_pDisp->Call(CallDescr));
+    }
+    catch(const std::exception&)
+    {
+        return false;
+    }
+}
+
+void CSetpointSeq::Update()
+{
+    if(status::running!=m_Status)
+        return;
+
+    unsigned int nStepTime=m_Steps[m_nNextStep].m_Time_uS;
+    unsigned int CurTime=GetTime_uS();
+    if(CurTime<nStepTime)
+    {
+        if( (nStepTime-CurTime)>m_SpinWindow_uS )
+            return;
+
+        //! the step is close enough: wait for it
+        while( (CurTime=GetTime_uS())<nStepTime ){}
+    }
+
+    //! execute all due steps:
+    while(m_nNextStep<m_Steps.size() && m_Steps[m_nNextStep].m_Time_uS<=CurTime)
+    {
+        step &st=m_Steps[m_nNextStep];
+        unsigned int lateness=CurTime-st.m_Time_uS;
+        if(lateness>m_MaxLateness_uS)
+            m_MaxLateness_uS=lateness;
+
+        if(!ExecStep(st))
+        {
+            Finish(status::failed);
+            return;
+        }
+        m_nNextStep++;
+        CurTime=GetTime_uS();
+    }
+    if(m_nNextStep>=m_Steps.size())
+    {
+        Finish(status::completed);
+    }
+}
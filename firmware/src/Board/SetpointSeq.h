@@ -0,0 +1,187 @@
+/*
+This Source Code Form is subject to the terms of the GNU General Public License v3.0.
+If a copy of the GPL was not distributed with this
+file, You can obtain one at https://www.gnu.org/licenses/gpl-3.0.html
+Copyright (c) 2019-2020 Panda Team
+*/
+
+/*!
+*   \file
+*   \brief A definition file for
+*   CSetpointSeq
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "json_evsys.h"
+#include "cmd.h"
+#include "SamCLK.h"
+#include "SamTC.h"
+
+/*!
+ * \brief The timed setpoint sequencer: executes an uploaded sequence of access point writes at given time offsets
+ * \details The sequence is uploaded as a JSON array of steps: [[time_uS, "access point", value], ...]
+ *  where time_uS is the step time offset in microseconds from the moment the sequence is armed.
+ *  The steps must be given in the ascending time order, the steps of the same time are executed in the given order.
+ *  The time base is a 32-bit hardware timer (TC6+TC7 pair) clocked at 1MHz and started at the moment of arming.
+ *  The steps are dispatched from the Update() method via the command dispatcher to keep the command and the event
+ *  systems single-threaded. When the next step is closer than m_SpinWindow_uS Update() waits for it on the timer counter,
+ *  thus the steps are executed with microsecond precision unless the "super loop" is blocked by other objects.
+ *  The maximum step lateness is measured for each run and can be checked via "Seq.lateness".
+ *  The sequence end (completed, aborted or failed) is reported via "Seq" JSON event
+ */
+class CSetpointSeq : public CJSONEvCP, public CJSONbase, public CSamTC
+{
+public:
+
+    /*!
+     * \brief The sequencer state
+     */
+    enum status{
+
+        idle,           //!<no sequence was started yet
+        running,        //!<the sequence is armed and being executed
+        completed,      //!<all steps of the sequence were executed successfully
+        aborted,        //!<the sequence was aborted by the user
+        failed          //!<a step execution failed, the sequence was stopped
+    };
+
+protected:
+
+    /*!
+     * \brief A single step of the sequence
+     */
+    struct step{
+
+        unsigned int    m_Time_uS;      //!<the step time offset from arming, microseconds
+        std::string     m_strAP;        //!<the access point name to write
+        nlohmann::json  m_Val;          //!<the value to write
+    };
+
+    /*!
+     * \brief The maximum number of steps in a sequence
+     */
+    static constexpr unsigned int m_MaxSteps=64;
+
+    /*!
+     * \brief When the next step is closer than this value Update() waits for it on the timer counter, microseconds
+     */
+    static constexpr unsigned int m_SpinWindow_uS=200;
+
+    /*!
+     * \brief The uploaded sequence in the ascending time order
+     */
+    std::vector<step> m_Steps;
+
+    /*!
+     * \brief The index of the next step to execute
+     */
+    unsigned int m_nNextStep=0;
+
+    /*!
+     * \brief The current sequencer state
+     */
+    status m_Status=status::idle;
+
+    /*!
+     * \brief The maximum step lateness measured during the current run, microseconds
+     */
+    unsigned int m_MaxLateness_uS=0;
+
+    /*!
+     * \brief A pointer to the command dispatcher used to execute the steps
+     */
+    std::shared_ptr<CCmdDispatcher> m_pDisp;
+
+    /*!
+     * \brief An associated clock generator (nullptr until the timer is initialized)
+     */
+    std::shared_ptr<CSamCLK> m_pCLK;
+
+    /*!
+     * \brief Sets up the sequence timer and its clock generator
+     * \details Called on the first arming to keep the firmware startup short
+     */
+    void InitTimer();
+
+    /*!
+     * \brief Returns the current sequence time
+     * \return The time elapsed from the moment of arming, microseconds
+     */
+    unsigned int GetTime_uS();
+
+    /*!
+     * \brief Stops the timer and finalizes the run with a given state, fires "Seq" event
+     * \param nStatus The final state
+     */
+    void Finish(status nStatus);
+
+    /*!
+     * \brief Executes a single step via the command dispatcher
+     * \param st The step to execute
+     * \return true=successful, false=the step was rejected by its access point
+     */
+    bool ExecStep(step &st);
+
+public:
+
+    /*!
+     * \brief The class constructor
+     * \param pDisp A pointer to the command dispatcher used to execute the steps
+     */
+    CSetpointSeq(const std::shared_ptr<CCmdDispatcher> &pDisp);
+
+    /*!
+     * \brief Returns the uploaded sequence
+     * \return The sequence in a JSON array format
+     */
+    std::string GetSequence();
+
+    /*!
+     * \brief Uploads a new sequence
+     * \param strSeq The sequence in a JSON array format: [[time_uS, "access point", value], ...]
+     * \details The sequence cannot be changed while running. An exception is thrown on a format error,
+     *  on a step time beyond 32 bits or on a step earlier than the previous one
+     */
+    void SetSequence(std::string strSeq);
+
+    /*!
+     * \brief Is the sequence armed and being executed?
+     * \return true=running, false=not running
+     */
+    bool IsArmed(){ return (status::running==m_Status); }
+
+    /*!
+     * \brief Arms(starts) or aborts the sequence
+     * \param how true=arm, false=abort
+     */
+    void Arm(bool how);
+
+    /*!
+     * \brief Returns the sequencer state
+     * \return The state as an integer value of CSetpointSeq::status
+     */
+    int GetStatus(){ return m_Status; }
+
+    /*!
+     * \brief Returns the number of executed steps of the current/last run
+     * \return The number of executed steps
+     */
+    int GetStep(){ return static_cast<int>(m_nNextStep); }
+
+    /*!
+     * \brief Returns the maximum step lateness of the current/last run
+     * \return The lateness, microseconds
+     */
+    unsigned int GetMaxLateness(){ return m_MaxLateness_uS; }
+
+    /*!
+     * \brief The object state update method
+     * \details Executes due steps of the sequence.
+     *  Must be called from a "super loop" or from corresponding thread
+     */
+    void Update();
+};
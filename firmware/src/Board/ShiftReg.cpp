@@ -8,9 +8,54 @@ Copyright (c) 2019-2020 Panda Team
 
 #include "ShiftReg.h"
 
+int                     CShiftRegBatch::m_nOpenCnt=0;
+std::vector<CShiftReg*> CShiftRegBatch::m_Pending;
+
+void CShiftRegBatch::Enqueue(CShiftReg *pSR)
+{
+    for(auto *p : m_Pending)
+    {
+        if(p==pSR)
+            return;
+    }
+    m_Pending.emplace_back(pSR);
+}
+
+void CShiftRegBatch::Commit()
+{
+    if(m_nOpenCnt>0)
+        m_nOpenCnt--;
+
+    if(m_nOpenCnt>0)
+        return;
+
+    for(auto *pSR : m_Pending)
+    {
+        //the register could be already shifted out by a direct write:
+        if(pSR->m_bDirty)
+            pSR->SetShiftReg(pSR->m_RegValue, pSR->m_BitsInUse);
+    }
+    m_Pending.clear();
+}
+
+void CShiftReg::SetBit(std::size_t nBit, bool bHow)
+{
+    m_RegValue[nBit]=bHow;
+    if(CShiftRegBatch::IsOpen() && !m_ImmediateBitsMask[nBit])
+    {
+        m_bDirty=true;
+        CShiftRegBatch::Enqueue(this);
+        return;
+    }
+    SetShiftReg(m_RegValue, m_BitsInUse);
+}
 
 void CShiftReg::SetShiftReg(typeRegister &RegValue, std::size_t BitsInUse)
 {
+    //the shadow value is applied completely:
+    m_bDirty=false;
+    m_nShifts++;
+
     for(std::size_t i=0; i<BitsInUse; i++)
     {
         m_pDataPin->Set(RegValue[i]);
@@ -29,11 +74,12 @@ void CShiftReg::SetShiftReg(typeRegister &RegValue, std::size_t BitsInUse)
     m_pStrobePin->Set(false);
 }
 
-std::shared_ptr<CShiftRegPin> CShiftReg::FactoryPin(std::size_t nBit)
+std::shared_ptr<CShiftRegPin> CShiftReg::FactoryPin(std::size_t nBit, bool bImmediate)
 {
     if(m_OccupiedBitsMask[nBit])
         return nullptr;
 
     m_OccupiedBitsMask[nBit]=true;
+    m_ImmediateBitsMask[nBit]=bImmediate;
     return std::shared_ptr<CShiftRegPin>(new CShiftRegPin(shared_from_this(), nBit));
 }
@@ -8,7 +8,7 @@ Copyright (c) 2019-2020 Panda Team
 /*!
 *   \file
 *   \brief A definition file for
-*   CShiftReg, CShiftRegPin, CDMSsr, CPGA_CS
+*   CShiftReg, CShiftRegBatch, CShiftRegBatchLock, CShiftRegPin, CDMSsr, CPGA_CS
 */
 
 
@@ -16,12 +16,73 @@ Copyright (c) 2019-2020 Panda Team
 
 #include <memory>
 #include <bitset>
+#include <vector>
 #include <stdint.h>
 #include "Pin.h"
 
 
 typedef std::bitset<32> typeRegister;
 class CShiftRegPin;
+class CShiftReg;
+
+/*!
+ * \brief The shift register batch controller
+ * \details While the batch is open single pin changes only modify the shadow value of the register (m_RegValue).
+ *  The changed registers are shifted out once when the outermost batch is committed.
+ *  Batches can be nested: only the outermost Commit() performs the shift-out.
+ *  Pins created as immediate ones (chip selects, e.g. of MAX5715) are never deferred: changing such a pin
+ *  shifts out the register at once together with its pending changes, so the chip select edge is not delayed
+ *  until the commit.
+ */
+class CShiftRegBatch
+{
+protected:
+
+    /*!
+     * \brief The batch nesting counter
+     */
+    static int m_nOpenCnt;
+
+    /*!
+     * \brief The list of shift registers having uncommitted changes
+     */
+    static std::vector<CShiftReg*> m_Pending;
+
+public:
+
+    /*!
+     * \brief Opens the batch: all following pin changes are kept in the shadow register
+     */
+    static void Begin(){ m_nOpenCnt++; }
+
+    /*!
+     * \brief Closes the batch. Shifts out all changed registers if this is the outermost batch
+     */
+    static void Commit();
+
+    /*!
+     * \brief Is the batch open?
+     * \return true=pin changes are deferred, false=pin changes are shifted out immediately
+     */
+    static bool IsOpen(){ return m_nOpenCnt>0; }
+
+    /*!
+     * \brief Adds the shift register to the list of registers to be shifted out
+     * \param pSR - the pointer to the shift register
+     */
+    static void Enqueue(CShiftReg *pSR);
+};
+
+/*!
+ * \brief The shift register batch auto-committer
+ * \details Opens the batch in the constructor and commits it when leaving the scope
+ */
+class CShiftRegBatchLock
+{
+public:
+    CShiftRegBatchLock(){ CShiftRegBatch::Begin(); }
+    ~CShiftRegBatchLock(){ CShiftRegBatch::Commit(); }
+};
 
 /*!
  * \brief The pin-controlled shift register implementation
@@ -30,6 +91,7 @@ class CShiftRegPin;
 class CShiftReg : public std::enable_shared_from_this<CShiftReg>
 {
 friend class CShiftRegPin;
+friend class CShiftRegBatch;
 protected:
 
     /*!
@@ -42,11 +104,26 @@ protected:
      */
     typeRegister m_OccupiedBitsMask;
 
+    /*!
+     * \brief m_ImmediateBitsMask - tells which of register bits are shifted out immediately even when the batch is open
+     */
+    typeRegister m_ImmediateBitsMask;
+
     /*!
      * \brief m_BitsInUse - tells digit capacity of the register (8/16/32)
      */
     std::size_t m_BitsInUse;
 
+    /*!
+     * \brief m_bDirty - the shadow register value was changed but not shifted out yet (batch mode)
+     */
+    bool m_bDirty=false;
+
+    /*!
+     * \brief m_nShifts - the number of performed shift-out operations (profiling)
+     */
+    unsigned int m_nShifts=0;
+
     /*!
      * \brief m_pDataPin - the pointer to the data pin
      */
@@ -73,12 +150,10 @@ protected:
      * \brief Sets single bit of the shift register
      * \param nBit - the bit number to be set (from 0)
      * \param bHow - the bit value: true or false
+     * \details When CShiftRegBatch is open only the shadow value is changed, the register is shifted out on commit.
+     *  Immediate bits are shifted out at once with all pending changes of the register
      */
-    inline void SetBit(std::size_t nBit, bool bHow)
-    {
-        m_RegValue[nBit]=bHow;
-        SetShiftReg(m_RegValue, m_BitsInUse);
-    }
+    void SetBit(std::size_t nBit, bool bHow);
 
     /*!
      * \brief Returns single bit value of the shift register
@@ -108,10 +183,21 @@ protected:
     /*!
      * \brief Factory for CShiftRegPin single pin control object
      * \param nBit - the bit number(from 0) of the shift register to be controlled
+     * \param bImmediate - the pin changes are never deferred by CShiftRegBatch (chip select pins)
      * \return the pointer to the CShiftRegPin single pin control object on success, otherwise nullptr
      */
-    std::shared_ptr<CShiftRegPin> FactoryPin(std::size_t nBit);
+    std::shared_ptr<CShiftRegPin> FactoryPin(std::size_t nBit, bool bImmediate=false);
 
+public:
+
+    /*!
+     * \brief Returns the number of performed shift-out operations (profiling)
+     * \return the number of shift-out operations
+     */
+    inline unsigned int GetShiftCount()
+    {
+        return m_nShifts;
+    }
 };
 
 /*!
@@ -178,6 +264,7 @@ public:
     virtual ~CShiftRegPin()
     {
         m_pCont->m_OccupiedBitsMask[m_nPin]=false;
+        m_pCont->m_ImmediateBitsMask[m_nPin]=false;
     }
 };
 
@@ -236,11 +323,12 @@ public:
     /*!
      * \brief Factory for CShiftRegPin single pin control object
      * \param nBit - the bit number(from 0) of the shift register to be controlled
+     * \param bImmediate - the pin changes are never deferred by CShiftRegBatch (chip select pins)
      * \return the pointer to the CShiftRegPin single pin control object on success, otherwise nullptr
      */
-    inline std::shared_ptr<CShiftRegPin> FactoryPin(pins nPin)
+    inline std::shared_ptr<CShiftRegPin> FactoryPin(pins nPin, bool bImmediate=false)
     {
-        return CShiftReg::FactoryPin(nPin);
+        return CShiftReg::FactoryPin(nPin, bImmediate);
     }
 
     /*!
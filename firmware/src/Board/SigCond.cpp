@@ -0,0 +1,40 @@
+/*
+This Source Code Form is subject to the terms of the GNU General Public License v3.0.
+If a copy of the GPL was not distributed with this
+file, You can obtain one at https://www.gnu.org/licenses/gpl-3.0.html
+Copyright (c) 2019-2020 Panda Team
+*/
+
+#include "SigCond.h"
+
+unsigned int CSigCondChan::m_nWindow=1000;
+
+CSigCondChan::CSigCondChan(const std::shared_ptr<CSamADCchan> &pADC)
+{
+    m_pADC=pADC;
+    m_nLastConv=pADC->GetConvCount();
+    m_Cond.SetSampleRate(pADC->GetPollingRate());
+}
+
+void CSigCondChan::SetWindow(unsigned int nWindow)
+{
+    if(nWindow<1)
+        nWindow=1;
+    if(nWindow>60000)
+        nWindow=60000;
+
+    m_nWindow=nWindow;
+}
+
+void CSigCondChan::Update()
+{
+    unsigned int nConv=m_pADC->GetConvCount();
+    if(nConv==m_nLastConv)
+        return;
+    m_nLastConv=nConv;
+
+    //the ADC profiles could be changed:
+    m_Cond.SetSampleRate(m_pADC->GetPollingRate());
+    m_Cond.SetWindow(m_nWindow);
+    m_Cond.Process(static_cast<float>(m_pADC->GetUnfilteredRawBinVal()));
+}
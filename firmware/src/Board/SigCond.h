@@ -0,0 +1,107 @@
+/*
+This Source Code Form is subject to the terms of the GNU General Public License v3.0.
+If a copy of the GPL was not distributed with this
+file, You can obtain one at https://www.gnu.org/licenses/gpl-3.0.html
+Copyright (c) 2019-2020 Panda Team
+*/
+
+/*!
+*   \file
+*   \brief A definition file for
+*   CSigCondChan
+*/
+
+#pragma once
+
+#include <memory>
+#include "SamADCcntr.h"
+#include "sigcond.h"
+
+/*!
+ * \brief The onboard signal-conditioning block of a monitor ADC channel
+ * \details Each new conversion of the monitor ADC channel is passed through the CSigCond kernel: a 4th order
+ *  Butterworth low-pass filter, then the RMS and the peak (maximum absolute value) over a window of m_nWindow samples.
+ *  All values are in the ADC raw-binary units. The filter follows the channel polling rate given by the active
+ *  ADC conversion profiles (CSamADCchan::GetPollingRate()), it is redesigned when the rate changes
+ */
+class CSigCondChan
+{
+protected:
+
+    /*!
+     * \brief The RMS/peak window length, samples (common for all channels)
+     */
+    static unsigned int m_nWindow;
+
+    /*!
+     * \brief The monitor ADC channel to be processed
+     */
+    std::shared_ptr<CSamADCchan> m_pADC;
+
+    /*!
+     * \brief The conversion counter of the channel when the last sample was processed
+     */
+    unsigned int m_nLastConv=0;
+
+    /*!
+     * \brief The filter and the window values
+     */
+    CSigCond m_Cond;
+
+public:
+
+    /*!
+     * \brief The class constructor
+     * \param pADC The monitor ADC channel to be processed
+     */
+    CSigCondChan(const std::shared_ptr<CSamADCchan> &pADC);
+
+    /*!
+     * \brief Returns the low-pass cutoff frequency
+     * \return The cutoff frequency, Hz (0=the filter is bypassed)
+     */
+    float GetCutoff(){ return m_Cond.GetCutoff(); }
+
+    /*!
+     * \brief Sets the low-pass cutoff frequency
+     * \param Fc_Hz The cutoff frequency, Hz. The value is fitted to the 0..Fs/2.5 range, 0=the filter is bypassed
+     */
+    void SetCutoff(float Fc_Hz){ m_Cond.SetCutoff(Fc_Hz); }
+
+    /*!
+     * \brief Returns the last filtered value
+     * \return The filtered value, ADC raw-binary units
+     */
+    float GetVal(){ return m_Cond.GetVal(); }
+
+    /*!
+     * \brief Returns the RMS value of the last completed window
+     * \return The RMS value, ADC raw-binary units
+     */
+    float GetRMS(){ return m_Cond.GetRMS(); }
+
+    /*!
+     * \brief Returns the peak value of the last completed window
+     * \return The peak value, ADC raw-binary units
+     */
+    float GetPeak(){ return m_Cond.GetPeak(); }
+
+    /*!
+     * \brief Returns the RMS/peak window length
+     * \return The window length, samples
+     */
+    static unsigned int GetWindow(){ return m_nWindow; }
+
+    /*!
+     * \brief Sets the RMS/peak window length for all channels
+     * \param nWindow The window length, samples (fitted to the 1..60000 range)
+     */
+    static void SetWindow(unsigned int nWindow);
+
+    /*!
+     * \brief The object state update method
+     * \details Processes a new conversion of the ADC channel if available.
+     *  Must be called from a "super loop" or from corresponding thread after the ADC container update
+     */
+    void Update();
+};
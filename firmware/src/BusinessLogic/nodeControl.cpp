@@ -7,6 +7,8 @@ Copyright (c) 2019 Panda Team
 
 #include "nodeControl.h"
 #include "DataVis.h"
+#include "PGA280.h"
+#include "ShiftReg.h"
 
 
 nodeControl::nodeControl()
@@ -28,6 +30,7 @@ void nodeControl::Serialize(CStorage &st)
 
     if(st.IsDownloading())
     {
+        CShiftRegBatchLock batch; //all extension pins are shifted out in one go
         SetGain(m_GainSetting);
         SetBridge(m_BridgeSetting);
         SetSecondary(m_SecondarySetting);
@@ -57,7 +60,10 @@ int nodeControl::gain_out(int val)
     //update channels gain setting:
     float gval=val;
     m_GainSetting=val;
-    for(auto &el : m_pMesChans) el->SetAmpGain(gval);
+    {
+        CPGA280batchLock batch; //all amplifiers are set in one go
+        for(auto &el : m_pMesChans) el->SetAmpGain(gval);
+    }
 
 
      //set old IEPE gain:
@@ -121,8 +127,11 @@ void nodeControl::SetMode(int nMode)
         m_pUBRswitch->Set(MesModes::IEPE==m_OpMode ? true:false);
     }
 
-    //switch all channels to IEPE:
-    for(auto &el : m_pMesChans) el->IEPEon(MesModes::IEPE==m_OpMode);
+    //switch all channels to IEPE (the extension pins are shifted out in one go):
+    {
+        CShiftRegBatchLock batch;
+        for(auto &el : m_pMesChans) el->IEPEon(MesModes::IEPE==m_OpMode);
+    }
 
     SetSecondary(m_OpMode);
 
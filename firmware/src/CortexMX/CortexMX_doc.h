@@ -8,6 +8,7 @@
  * 
  * void SysTick_Handler(void) - a CortexM4 interrupt handler, used for generating OS system time.
  * The time can be requested by os::get_tick_mS.
+ * The CortexM4 DWT cycle counter is used for fine profiling: os::get_cycles, os::cycles_to_uS.
  *
  */
  
@@ -27,4 +27,22 @@ unsigned long get_tick_mS(void)
 {
 	return sys_time_mS;
 }
+
+//the core clock is set to 120MHz by sys_clock_init():
+static constexpr unsigned long CyclesPerUs=120;
+
+unsigned long get_cycles(void)
+{
+	if(0==(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk))
+	{
+		CoreDebug->DEMCR|=CoreDebug_DEMCR_TRCENA_Msk;
+		DWT->CYCCNT=0;
+		DWT->CTRL|=DWT_CTRL_CYCCNTENA_Msk;
+	}
+	return DWT->CYCCNT;
+}
+unsigned long cycles_to_uS(unsigned long cycles)
+{
+	return cycles/CyclesPerUs;
+}
 }
@@ -133,6 +133,31 @@ void CHatAtomGPIOmap::reset()
     memset(&m_bank_drive, 0, 30);
 }
 
+bool CHatAtomCustom::load(CFIFO &buf)
+{
+    typeSChar ch;
+    m_data.reserve(buf.in_avail());
+    while(buf.in_avail())
+    {
+        buf>>ch;
+        m_data+=ch;
+    }
+    return true;
+}
+bool CHatAtomCustom::store(CFIFO &buf)
+{
+    buf.reserve(m_data.length());
+    for(size_t i=0; i<m_data.length(); i++)
+    {
+        buf<<m_data[i];
+    }
+    return true;
+}
+void CHatAtomCustom::reset()
+{
+    m_data.erase();
+}
+
 
 namespace  {
 
@@ -258,6 +283,21 @@ void CHatsMemMan::Reset()
     SetMemBufSize(sizeof(struct header_t));
     m_StorageState=ResetStorage(GetMemBuf(), GetMemBufSize());
 }
+int CHatsMemMan::GetHeaderSize()
+{
+    return sizeof(struct header_t);
+}
+int CHatsMemMan::GetImageSize()
+{
+    if(GetMemBufSize()<static_cast<int>(sizeof(struct header_t)))
+        return 0;
+
+    struct header_t *pHeader=(struct header_t *)(GetMemBuf());
+    if(SIGNATURE!=pHeader->signature || VERSION!=pHeader->ver)
+        return 0;
+
+    return pHeader->eeplen;
+}
 
 
 CHatsMemMan::op_result CHatsMemMan::ReadAtom(unsigned int nAtom, typeHatsAtom &nAtomType, CFIFO &rbuf)
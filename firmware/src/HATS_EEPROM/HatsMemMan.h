@@ -116,6 +116,47 @@ private:
     bool store(CFIFO &buf);
 };
 
+/*!
+ * \brief The custom data atom
+ * \details Custom atoms follow the vendor info, the GPIO map and the optional Linux DTB atom,
+ * the data format is up to the atom user
+ */
+struct CHatAtomCustom
+{
+friend class CHatsMemMan;
+
+    std::string m_data;
+
+    /*!
+     * \brief A class constructor
+     * \param nIndex absolute address of the Atom
+     */
+    CHatAtomCustom(int nIndex) : m_index(nIndex) {reset();}
+
+private:
+    typeHatsAtom m_type=typeHatsAtom::Custom;
+    int          m_index;
+
+    /*!
+     * \brief Clears the data
+     */
+    void reset();
+
+    /*!
+     * \brief Loads data fields from an ATOM binary image
+     * \param buf ATOM binary image
+     * \return true=successful, false=failure
+     */
+    bool load(CFIFO &buf);
+
+    /*!
+     * \brief Stores data fields to an ATOM binary image
+     * \param buf ATOM binary image
+     * \return true=successful, false=failure
+     */
+    bool store(CFIFO &buf);
+};
+
 
 /*!
  * \brief A manager class for working with HATs-EEPROM binary image
@@ -182,6 +223,19 @@ public:
      */
     void Reset();
 
+    /*!
+     * \brief Returns the size of the image header
+     * \return The header size in bytes
+     */
+    static int GetHeaderSize();
+
+    /*!
+     * \brief Returns the image size declared in the image header
+     * \details Can be used to read out only the used part of the EEPROM: the header is read first, then the rest of the image
+     * \return The image size in bytes or 0 if the header is not complete or its signature is wrong
+     */
+    int GetImageSize();
+
 
     /*!
      * \brief Loads the atom of given type from the image
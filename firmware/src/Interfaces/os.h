@@ -25,6 +25,20 @@ namespace os {
  */
 unsigned long get_tick_mS(void);
 
+/*!
+ * \brief The CPU cycle counter value
+ * \return the counter value in CPU cycles (wraps around)
+ * \details The counter is started on the first call. Used for fine profiling of the firmware routines
+ */
+unsigned long get_cycles(void);
+
+/*!
+ * \brief Converts a CPU cycles interval to microseconds
+ * \param cycles the interval in CPU cycles (usually the difference of two get_cycles() values)
+ * \return the interval in microseconds
+ */
+unsigned long cycles_to_uS(unsigned long cycles);
+
 /*!
  * \brief Sleep for defined time
  * \param time_mS sleep time in milliseconds
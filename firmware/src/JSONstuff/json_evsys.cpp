@@ -10,8 +10,22 @@ Copyright (c) 2019 Panda Team
 
 void CJSONEvDispatcher::on_event(const char *key, nlohmann::json &val)
 {
-    m_event[key]=val;
+    //drop the oldest event if the queue is full:
+    if(m_nCount>=m_MaxEvents)
+    {
+        m_nHead=(m_nHead+1)%m_MaxEvents;
+        m_nCount--;
+        m_nLost++;
+    }
+
+    event &ev=m_Events[(m_nHead+m_nCount)%m_MaxEvents];
+    ev.m_nSeq=m_nNextSeq++;
+    ev.m_Time_mS=os::get_tick_mS();
+    ev.m_strKey=key;
+    ev.m_Val=val;
+    m_nCount++;
 }
+
 typeCRes CJSONEvDispatcher::Call(CCmdCallDescr &d)
 {
     if(IsCmdSubsysLocked())
@@ -23,10 +37,21 @@ typeCRes CJSONEvDispatcher::Call(CCmdCallDescr &d)
     }
 
     //don't send if there is nothing to send
-    if(!m_event.empty())
+    if(m_nCount || m_nLost)
     {
-        *(d.m_pOut)<<m_event.dump();
-        m_event.clear();
+        nlohmann::json jresp;
+        nlohmann::json &jev=jresp["ev"];
+        jev=nlohmann::json::array();
+        for(; m_nCount; m_nCount--)
+        {
+            event &ev=m_Events[m_nHead];
+            jev.push_back({ev.m_nSeq, ev.m_Time_mS, ev.m_strKey, ev.m_Val});
+            m_nHead=(m_nHead+1)%m_MaxEvents;
+        }
+        jresp["lost"]=m_nLost;
+        m_nLost=0;
+
+        *(d.m_pOut)<<jresp.dump();
     }
     return typeCRes::OK;
 }
@@ -15,6 +15,7 @@ Copyright (c) 2019 Panda Team
 
 #include <vector>
 #include <memory>
+#include <string>
 #include "json_base.h"
 
 
@@ -109,7 +110,10 @@ public:
  * \brief The "je" command dispatcher and holder of the last JSON events
  * \details Please, see CommunicationProtocol.md and EventSysytem.md for details.
  * All JSON events to which the class object is subscribed falls to on_event and stored
- * in m_event until they being readout by "je" command. The m_event is cleared after handling "je" command.
+ * in a bounded ring queue m_Events until they being readout by "je" command.
+ * Each event gets a sequence number and a time stamp(mS). The "je" command drains the queue in order.
+ * When the queue is full the oldest event is dropped and counted as lost: a reader can detect this
+ * by the lost counter and by a gap in the sequence numbers.
  *
  */
 class CJSONEvDispatcher : public IJSONEvent, public CJSONbase, public CCmdCallHandler
@@ -117,9 +121,45 @@ class CJSONEvDispatcher : public IJSONEvent, public CJSONbase, public CCmdCallHa
 protected:
 
     /*!
-     * \brief A holder for JSON events
+     * \brief A queued JSON event
      */
-    nlohmann::json m_event;
+    struct event{
+
+        unsigned int    m_nSeq;         //!<the event sequence number
+        unsigned long   m_Time_mS;      //!<the event time stamp, milliseconds
+        std::string     m_strKey;       //!<the event key
+        nlohmann::json  m_Val;          //!<the event value
+    };
+
+    /*!
+     * \brief The maximum number of queued events
+     */
+    static constexpr unsigned int m_MaxEvents=32;
+
+    /*!
+     * \brief The event queue storage (ring buffer)
+     */
+    std::vector<event> m_Events;
+
+    /*!
+     * \brief The index of the oldest queued event
+     */
+    unsigned int m_nHead=0;
+
+    /*!
+     * \brief The number of queued events
+     */
+    unsigned int m_nCount=0;
+
+    /*!
+     * \brief The sequence number of the next event
+     */
+    unsigned int m_nNextSeq=0;
+
+    /*!
+     * \brief The number of events dropped due to the queue overflow since the last readout
+     */
+    unsigned int m_nLost=0;
 
     /*!
      * \brief A pointer to a command dispatcher
@@ -148,5 +188,6 @@ public:
     CJSONEvDispatcher(const std::shared_ptr<CCmdDispatcher> &pDisp)
     {
         m_pDisp=pDisp;
+        m_Events.resize(m_MaxEvents);
     }
 };
@@ -5,6 +5,7 @@
  * \page Math_page Math
  *
  * Contains Moving Average implementation with calculation of Standard Deviation
+ * and the signal-conditioning kernel (low-pass biquad filter, RMS and peak) that also builds on the host
  * 
  */
  
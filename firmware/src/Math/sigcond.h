@@ -0,0 +1,298 @@
+/*
+This Source Code Form is subject to the terms of the GNU General Public License v3.0.
+If a copy of the GPL was not distributed with this
+file, You can obtain one at https://www.gnu.org/licenses/gpl-3.0.html
+Copyright (c) 2019-2020 Panda Team
+*/
+
+
+/*!
+*   \file
+*   \brief A definition file for
+*   CSigCond
+*/
+
+
+#pragma once
+
+#include <math.h>
+
+#ifdef SIGCOND_CMSIS_DSP
+#include "arm_math.h"
+#endif
+
+/*!
+ * \brief The signal-conditioning kernel: 4th order Butterworth low-pass filter followed by the RMS and the peak
+ *  over a window of samples
+ * \details The filter is two cascaded biquad sections in the CMSIS-DSP Direct Form II transposed layout.
+ *  With SIGCOND_CMSIS_DSP defined (the firmware is linked with the CMSIS-DSP library) the sections are run by
+ *  arm_biquad_cascade_df2T_f32, otherwise by the same kernel written in place, so the class also builds on the host.
+ *  Both give the same bits: the driver tests build the class both ways with the library reference C code.
+ *  The sum of squares of the window is accumulated in double precision: float loses the small terms of long windows
+ */
+class CSigCond
+{
+protected:
+
+    /*!
+     * \brief The number of cascaded biquad sections
+     */
+    static constexpr int m_nStages=2;
+
+    /*!
+     * \brief The sample rate, Hz
+     */
+    float m_Fs_Hz=1000.0f;
+
+    /*!
+     * \brief The low-pass cutoff frequency, Hz (0=the filter is bypassed)
+     */
+    float m_Fc_Hz=0;
+
+    /*!
+     * \brief The RMS/peak window length, samples
+     */
+    unsigned int m_nWindow=1000;
+
+    /*!
+     * \brief The filter coefficients in CMSIS-DSP order: {b10, b11, b12, a11, a12, b20, b21, ...}, a-coefficients are negated
+     */
+    float m_Coeffs[5*m_nStages];
+
+    /*!
+     * \brief The filter state: two delay elements per stage
+     */
+    float m_State[2*m_nStages]={};
+
+#ifdef SIGCOND_CMSIS_DSP
+    /*!
+     * \brief The CMSIS-DSP filter instance (refers to m_Coeffs and m_State)
+     */
+    arm_biquad_cascade_df2T_instance_f32 m_Biquad;
+#endif
+
+    /*!
+     * \brief The filter state must be preloaded with the next sample
+     */
+    bool m_bPreload=true;
+
+    /*!
+     * \brief The last filtered value
+     */
+    float m_Val=0;
+
+    /*!
+     * \brief The sum of squares of the current window
+     */
+    double m_SumSq=0;
+
+    /*!
+     * \brief The peak value of the current window
+     */
+    float m_WinPeak=0;
+
+    /*!
+     * \brief The number of samples processed in the current window
+     */
+    unsigned int m_nWinCnt=0;
+
+    /*!
+     * \brief The RMS value of the last completed window
+     */
+    float m_RMS=0;
+
+    /*!
+     * \brief The peak value of the last completed window
+     */
+    float m_Peak=0;
+
+    /*!
+     * \brief Calculates the filter coefficients for the current sample rate and cutoff frequency
+     */
+    void Design()
+    {
+        //quality factors of the 4th order Butterworth sections:
+        static const float Q[m_nStages]={0.5411961f, 1.3065630f};
+
+        float w0=2.0f*3.14159265f*m_Fc_Hz/m_Fs_Hz;
+        float cosw0=cosf(w0);
+        for(int i=0; i<m_nStages; i++)
+        {
+            float *pC=m_Coeffs+5*i;
+
+            if(0==m_Fc_Hz)
+            {
+                //bypass:
+                pC[0]=1.0f; pC[1]=0; pC[2]=0; pC[3]=0; pC[4]=0;
+                continue;
+            }
+            float alpha=sinf(w0)/(2.0f*Q[i]);
+            float a0=1.0f+alpha;
+
+            pC[0]=(1.0f-cosw0)/(2.0f*a0);
+            pC[1]=(1.0f-cosw0)/a0;
+            pC[2]=pC[0];
+            pC[3]=2.0f*cosw0/a0;            //CMSIS: negated a1
+            pC[4]=-(1.0f-alpha)/a0;         //CMSIS: negated a2
+        }
+        m_bPreload=true;
+    }
+
+    /*!
+     * \brief Fits the cutoff frequency to the 0..Fs/2.5 range
+     */
+    void FitCutoff()
+    {
+        if(m_Fc_Hz<0)
+            m_Fc_Hz=0;
+        if(m_Fc_Hz>m_Fs_Hz/2.5f)
+            m_Fc_Hz=m_Fs_Hz/2.5f;
+    }
+
+public:
+
+    /*!
+     * \brief The class constructor
+     */
+    CSigCond()
+    {
+#ifdef SIGCOND_CMSIS_DSP
+        arm_biquad_cascade_df2T_init_f32(&m_Biquad, m_nStages, m_Coeffs, m_State);
+#endif
+        Design();
+    }
+
+    /*!
+     * \brief Returns the sample rate
+     * \return The sample rate, Hz
+     */
+    float GetSampleRate(){ return m_Fs_Hz; }
+
+    /*!
+     * \brief Sets the sample rate and redesigns the filter
+     * \param Fs_Hz The sample rate, Hz. The cutoff frequency is fitted to the new 0..Fs/2.5 range
+     */
+    void SetSampleRate(float Fs_Hz)
+    {
+        if(Fs_Hz<=0 || Fs_Hz==m_Fs_Hz)
+            return;
+
+        m_Fs_Hz=Fs_Hz;
+        FitCutoff();
+        Design();
+    }
+
+    /*!
+     * \brief Returns the low-pass cutoff frequency
+     * \return The cutoff frequency, Hz (0=the filter is bypassed)
+     */
+    float GetCutoff(){ return m_Fc_Hz; }
+
+    /*!
+     * \brief Sets the low-pass cutoff frequency
+     * \param Fc_Hz The cutoff frequency, Hz. The value is fitted to the 0..Fs/2.5 range, 0=the filter is bypassed
+     */
+    void SetCutoff(float Fc_Hz)
+    {
+        m_Fc_Hz=Fc_Hz;
+        FitCutoff();
+        Design();
+    }
+
+    /*!
+     * \brief Returns the RMS/peak window length
+     * \return The window length, samples
+     */
+    unsigned int GetWindow(){ return m_nWindow; }
+
+    /*!
+     * \brief Sets the RMS/peak window length
+     * \param nWindow The window length, samples (at least 1)
+     * \details The current window ends as soon as it has the new number of samples
+     */
+    void SetWindow(unsigned int nWindow){ m_nWindow=nWindow<1 ? 1:nWindow; }
+
+    /*!
+     * \brief Returns the last filtered value
+     * \return The filtered value
+     */
+    float GetVal(){ return m_Val; }
+
+    /*!
+     * \brief Returns the RMS value of the last completed window
+     * \return The RMS value
+     */
+    float GetRMS(){ return m_RMS; }
+
+    /*!
+     * \brief Returns the peak value of the last completed window
+     * \return The peak value
+     */
+    float GetPeak(){ return m_Peak; }
+
+    /*!
+     * \brief Passes a single sample through the filter
+     * \param x The input sample
+     * \return The filtered sample
+     */
+    float Filter(float x)
+    {
+        //preload the state with the steady state for the input value to avoid a startup transient:
+        if(m_bPreload)
+        {
+            for(int i=0; i<m_nStages; i++)
+            {
+                const float *pC=m_Coeffs+5*i;
+                float *pS=m_State+2*i;
+
+                pS[1]=(pC[2]+pC[4])*x;
+                pS[0]=(pC[1]+pC[3])*x + pS[1];
+            }
+            m_bPreload=false;
+        }
+
+#ifdef SIGCOND_CMSIS_DSP
+        float y;
+        arm_biquad_cascade_df2T_f32(&m_Biquad, &x, &y, 1);
+        return y;
+#else
+        //biquad cascade, Direct Form II transposed (arm_biquad_cascade_df2T_f32 kernel):
+        float acc=x;
+        for(int i=0; i<m_nStages; i++)
+        {
+            const float *pC=m_Coeffs+5*i;
+            float *pS=m_State+2*i;
+            float in=acc;
+
+            acc  =pC[0]*in + pS[0];
+            pS[0]=pC[1]*in + pC[3]*acc + pS[1];
+            pS[1]=pC[2]*in + pC[4]*acc;
+        }
+        return acc;
+#endif
+    }
+
+    /*!
+     * \brief Processes a new sample: filters it and updates the window values
+     * \param x The input sample
+     */
+    void Process(float x)
+    {
+        m_Val=Filter(x);
+
+        m_SumSq+=static_cast<double>(m_Val)*m_Val;
+        float abs_val=fabsf(m_Val);
+        if(abs_val>m_WinPeak)
+            m_WinPeak=abs_val;
+
+        if(++m_nWinCnt>=m_nWindow)
+        {
+            m_RMS=static_cast<float>(sqrt(m_SumSq/m_nWinCnt));
+            m_Peak=m_WinPeak;
+
+            m_SumSq=0;
+            m_WinPeak=0;
+            m_nWinCnt=0;
+        }
+    }
+};
@@ -16,6 +16,8 @@ void CADpointSearch::Update()
     if(typePTsrcState::searching!=m_State)
         return;
 
+    //coarse steps are measured with the fast profile, the final ones with the precise:
+    m_pADC->SetFastMode(m_ProcBits>m_nPreciseBits);
     int CurPoint=m_pADC->DirectMeasure();
     int CurSetPoint=m_pDAC->GetRawBinVal();
     int err=(m_TargPoint-CurPoint);
@@ -37,6 +39,7 @@ void CADpointSearch::Update()
     if(0==m_ProcBits--)
     {
         //m_State=(std::abs(err) < m_TargErrTolerance) ? typePTsrcState::found : typePTsrcState::error;
+        m_pADC->SetFastMode(false);
         if(std::abs(err) < m_TargErrTolerance)
         {
             m_State=typePTsrcState::found;
@@ -62,6 +62,12 @@ protected:
      */
     int m_TargPoint;
 
+    /*!
+     * \brief The number of the last search steps that are measured with the precise ADC profile
+     * \details The previous (coarse) steps are measured with the fast profile
+     */
+    static constexpr int m_nPreciseBits=4;
+
     /*!
      * \brief A value that defines acceptable deviation from the target value (+-)
      */
@@ -132,6 +138,7 @@ public:
     void StopReset()
     {
         m_State=typePTsrcState::idle;
+        m_pADC->SetFastMode(false);
     }
 
     /*!
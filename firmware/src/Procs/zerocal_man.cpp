@@ -7,11 +7,13 @@ Copyright (c) 2019 Panda Team
 
 #include "os.h"
 #include "zerocal_man.h"
+#include "DACmax5715.h"
 
 
 void CCalMan::Serialize(CStorage &st)
 {
     bool bSet=st.IsDownloading();
+    CDac5715batchLock batch; //all offsets are applied at once
     for(auto &ch : m_ChanCal)
     {
         if(st.IsDefaultSettingsOrder())
@@ -68,6 +70,8 @@ void CCalMan::Update()
 
     bool bRunning=false;
     unsigned int nSize=m_ChanCal.size();
+    {
+    CDac5715batchLock batch; //the search steps of all channels are applied at once
     for(unsigned int i=0; i<nSize; i++)
     {
         m_ChanCal[i].Update();
@@ -92,6 +96,7 @@ void CCalMan::Update()
             }
         }
     }
+    } //committed here, before the search is stopped
     if(!bRunning)
     {
         StopReset();
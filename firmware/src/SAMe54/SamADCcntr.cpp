@@ -37,6 +37,7 @@ CSamADCchan::~CSamADCchan()
 void CSamADCchan::SetRawBinVal(int RawVal)
 {
     m_UnfilteredRawVal=RawVal;
+    m_nConvCnt++;
     m_FilteredRawVal+=((float)RawVal - m_FilteredRawVal ) * ( (float)data_age() ) / m_filter_t_mSec;
     m_MesTStamp=os::get_tick_mS();
 
@@ -44,8 +45,53 @@ void CSamADCchan::SetRawBinVal(int RawVal)
 }
 
 
+void CSamADCchan::SetAvgSamples(unsigned int nSamples)
+{
+    unsigned int n=0;
+    while(n<10 && (2u<<n)<=nSamples)
+        n++;
+
+    m_Profile.m_SampleNum=n;
+}
+
+void CSamADCchan::SetPrescaler(unsigned int nDiv)
+{
+    unsigned int n=0;
+    while(n<7 && (4u<<n)<=nDiv)
+        n++;
+
+    m_Profile.m_Prescaler=n;
+}
+
+void CSamADCchan::SetSampleLen(unsigned int nCycles)
+{
+    if(nCycles<1)
+        nCycles=1;
+    if(nCycles>64)
+        nCycles=64;
+
+    m_Profile.m_SampleLen=nCycles-1;
+}
+
+float CSamADCchan::GetPollingRate()
+{
+    return m_pCont->GetPollingRate();
+}
+
  int CSamADCchan::DirectMeasure(int nMesCnt, float alpha)
  {
+     //apply the conversion profile:
+     if(m_bFastMode)
+     {
+         typeSamADCprofile FastProfile=m_Profile;
+         FastProfile.m_SampleNum=m_FastSampleNum;
+         m_pCont->ApplyProfile(FastProfile);
+     }
+     else
+     {
+         m_pCont->ApplyProfile(m_Profile);
+     }
+
      //select one chanel and no switching beetwen mes:
      m_pCont->SelectInput(m_posIN, m_negIN);
 
@@ -66,6 +112,7 @@ bool CSamADCcntr::Update()
     {
         if(pCh->data_age()>=1){
 
+        ApplyProfile(pCh->m_Profile);
         SelectInput(pCh->m_posIN, pCh->m_negIN);
         short mes=SingleConv();
         pCh->CSamADCchan::SetRawBinVal(mes);
@@ -75,6 +122,44 @@ bool CSamADCcntr::Update()
     return true;
 }
 
+float CSamADCcntr::GetPollingRate()
+{
+    float Period_uS=0;
+    for(auto *pCh : m_Chans)
+        Period_uS+=pCh->m_Profile.GetConvTime_uS();
+
+    return 1e6f/(Period_uS>1000.0f ? Period_uS:1000.0f);
+}
+
+void CSamADCcntr::ApplyProfile(const typeSamADCprofile &prof, bool bForce)
+{
+    if(!bForce && prof==m_CurProfile)
+        return;
+
+    //select ptr:
+    Adc *pADC=SELECT_SAMADC(m_nADC);
+
+    //the prescaler is enable-protected:
+    pADC->CTRLA.bit.ENABLE=0;
+    while(pADC->SYNCBUSY.bit.ENABLE){}
+
+    pADC->CTRLA.bit.PRESCALER=prof.m_Prescaler;
+
+    pADC->SAMPCTRL.bit.SAMPLEN=prof.m_SampleLen;
+    while(pADC->SYNCBUSY.bit.SAMPCTRL){}
+
+    //averaging: the result is adjusted to 12 bits by the hardware for more than 16 samples
+    pADC->AVGCTRL.reg=ADC_AVGCTRL_SAMPLENUM(prof.m_SampleNum) | ADC_AVGCTRL_ADJRES(prof.m_SampleNum<4 ? prof.m_SampleNum:4);
+    while(pADC->SYNCBUSY.bit.AVGCTRL){}
+    pADC->CTRLB.bit.RESSEL=prof.m_SampleNum ? 0x01:0x00; //16BIT for averaging mode output, 12BIT for a single sample
+    while(pADC->SYNCBUSY.bit.CTRLB){}
+
+    pADC->CTRLA.bit.ENABLE=1;
+    while(pADC->SYNCBUSY.bit.ENABLE){}
+
+    m_CurProfile=prof;
+}
+
 void CSamADCcntr::SelectInput(typeSamADCmuxpos nPos, typeSamADCmuxneg nNeg)
 {
     //select ptr:
@@ -180,21 +265,12 @@ CSamADCcntr::CSamADCcntr(typeSamADC nADC)
     //------------------------------------------------------------------
 
 
-    //----------------enabling accumulation & averaging-----------------
-        pADC->AVGCTRL.bit.SAMPLENUM=0x07; //128 samples
-        while(pADC->SYNCBUSY.bit.AVGCTRL){}
-        pADC->AVGCTRL.bit.ADJRES=0x04;      //12 bits res of 128 samples
-        while(pADC->SYNCBUSY.bit.AVGCTRL){}
-        pADC->CTRLB.bit.RESSEL=0x01; //16BIT For averaging mode output
-        while(pADC->SYNCBUSY.bit.CTRLB){}
-    //-------------------------------------------------------------------
-
-    
     //--------------------------enabling---------------------------------
     pADC->REFCTRL.bit.REFSEL    =0x05; //AREFB
     while(pADC->SYNCBUSY.bit.REFCTRL){}
-    pADC->CTRLA.bit.ENABLE=1;   //enable the ADC
-    while(pADC->SYNCBUSY.bit.ENABLE){}
+
+    //the default profile (128 samples averaging) is applied, then the ADC is enabled:
+    ApplyProfile(typeSamADCprofile(), true);
     //-------------------------------------------------------------------
 }
 
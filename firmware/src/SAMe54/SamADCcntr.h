@@ -8,7 +8,7 @@ Copyright (c) 2019 Panda Team
 /*!
 *   \file
 *   \brief A definition file for
-*   typeSamADC, typeSamADCmuxpos, typeSamADCmuxneg, CSamADCchan, CSamADCcntr
+*   typeSamADC, typeSamADCmuxpos, typeSamADCmuxneg, typeSamADCprofile, CSamADCchan, CSamADCcntr
 */
 
 
@@ -35,6 +35,33 @@ enum class typeSamADCmuxpos : int {AIN0=0, AIN1, AIN2, AIN3, AIN4, AIN5, AIN6, A
  */
 enum class typeSamADCmuxneg : int {none=-1, AIN0=0, AIN1, AIN2, AIN3, AIN4, AIN5, AIN6, AIN7};
 
+/*!
+ * \brief The ADC conversion profile: conversion time vs precision settings
+ * \details The fields hold SAME54 ADC register values. The default profile is: 128 samples averaging,
+ *  GCLK/2 prescaler and the minimum sampling time
+ */
+struct typeSamADCprofile
+{
+    unsigned int m_SampleNum=7;     //!<AVGCTRL.SAMPLENUM: 2^m_SampleNum samples are averaged (0:10)
+    unsigned int m_Prescaler=0;     //!<CTRLA.PRESCALER: the ADC clock is GCLK/2^(m_Prescaler+1) (0:7)
+    unsigned int m_SampleLen=0;     //!<SAMPCTRL.SAMPLEN: the sampling time is m_SampleLen+1 ADC clock cycles (0:63)
+
+    /*!
+     * \brief Returns the time of one (averaged) conversion of the profile
+     * \param GCLK_MHz The ADC generic clock frequency, MHz (the DFLL by default)
+     * \return The conversion time, uS
+     * \details Each averaged sample takes the sampling time plus 12 bit cycles of the ADC clock
+     */
+    float GetConvTime_uS(float GCLK_MHz=48.0f) const
+    {
+        return static_cast<float>((1u<<m_SampleNum)*(m_SampleLen+1+12)*(2u<<m_Prescaler))/GCLK_MHz;
+    }
+
+    bool operator==(const typeSamADCprofile &p) const
+    {
+        return m_SampleNum==p.m_SampleNum && m_Prescaler==p.m_Prescaler && m_SampleLen==p.m_SampleLen;
+    }
+};
 
 class CSamADCcntr;
 
@@ -83,6 +110,31 @@ protected:
      */
     float         m_filter_t_mSec=50.0f;
 
+    /*!
+     * \brief A conversion counter: incremented on each new conversion result
+     */
+    unsigned int  m_nConvCnt=0;
+
+    /*!
+     * \brief The conversion profile of the channel (used for the polling and for the precise direct measurements)
+     */
+    typeSamADCprofile m_Profile;
+
+    /*!
+     * \brief The direct measurements are made with the fast profile
+     */
+    bool          m_bFastMode=false;
+
+    /*!
+     * \brief The number of averaging samples of the fast profile (power of 2)
+     */
+    static constexpr unsigned int m_FastSampleNum=4;
+
+    /*!
+     * \brief The number of conversions averaged by DirectMeasure() in the fast mode
+     */
+    static constexpr int m_FastMesCnt=5;
+
     /*!
      * \brief Returns the age of last ADC conversion.
      * \return The age of last ADC conversion, milliseconds
@@ -119,9 +171,15 @@ public:
      */
     virtual int DirectMeasure()
     {
-        return CSamADCchan::DirectMeasure(50, 0.8f);
+        return m_bFastMode ? CSamADCchan::DirectMeasure(m_FastMesCnt, 0.5f) : CSamADCchan::DirectMeasure(50, 0.8f);
     }
 
+    /*!
+     * \brief Override "SetFastMode" methode: selects the fast (16 samples averaging, fewer conversions) or the channel's own profile
+     * \param how true=fast, false=precise
+     */
+    virtual void SetFastMode(bool how){ m_bFastMode=how; }
+
     /*!
      * \brief The own implementation of "Direct Measure"
      * \param nMesCnt A number of samples to average
@@ -130,6 +188,62 @@ public:
      * \details The averaging method used for the methode is: Result=alpha*Result +(1.0f-alpha)*ADC_conversion_result
      */
     int DirectMeasure(int nMesCnt, float alpha);
+
+    /*!
+     * \brief Returns unfiltered raw binary value of last ADC conversion
+     * \return The conversion result
+     */
+    int GetUnfilteredRawBinVal(){ return m_UnfilteredRawVal; }
+
+    /*!
+     * \brief Returns the conversion counter
+     * \return The number of conversions made by the channel container (wraps around)
+     * \details The counter can be used to detect a new conversion result
+     */
+    unsigned int GetConvCount(){ return m_nConvCnt; }
+
+    /*!
+     * \brief Returns the nominal polling rate of the channel
+     * \return The number of conversions per second made by the channel container for the channel
+     * \details Depends on the conversion profiles of all channels of the container, see CSamADCcntr::GetPollingRate()
+     */
+    float GetPollingRate();
+
+    /*!
+     * \brief Returns the number of averaging samples of the channel profile
+     * \return The number of samples
+     */
+    unsigned int GetAvgSamples(){ return 1<<m_Profile.m_SampleNum; }
+
+    /*!
+     * \brief Sets the number of averaging samples of the channel profile
+     * \param nSamples The number of samples (rounded down to a power of 2 in the range 1:1024)
+     */
+    void SetAvgSamples(unsigned int nSamples);
+
+    /*!
+     * \brief Returns the ADC clock prescaler of the channel profile
+     * \return The prescaler division factor
+     */
+    unsigned int GetPrescaler(){ return 2<<m_Profile.m_Prescaler; }
+
+    /*!
+     * \brief Sets the ADC clock prescaler of the channel profile
+     * \param nDiv The prescaler division factor (rounded down to a power of 2 in the range 2:256)
+     */
+    void SetPrescaler(unsigned int nDiv);
+
+    /*!
+     * \brief Returns the sampling time of the channel profile
+     * \return The sampling time in ADC clock cycles
+     */
+    unsigned int GetSampleLen(){ return m_Profile.m_SampleLen+1; }
+
+    /*!
+     * \brief Sets the sampling time of the channel profile
+     * \param nCycles The sampling time in ADC clock cycles (1:64)
+     */
+    void SetSampleLen(unsigned int nCycles);
 };
 
 /*!
@@ -156,6 +270,19 @@ protected:
      * \brief An associated clock generator: must be provided to perform conversions
      */
     std::shared_ptr<CSamCLK> m_pCLK;
+
+    /*!
+     * \brief The conversion profile that is currently applied to the ADC
+     */
+    typeSamADCprofile m_CurProfile;
+
+    /*!
+     * \brief Applies the conversion profile to the ADC if it differs from the current one
+     * \param prof The profile to apply
+     * \param bForce Apply the profile unconditionally
+     * \details The ADC is disabled while changing the settings since the prescaler is enable-protected
+     */
+    void ApplyProfile(const typeSamADCprofile &prof, bool bForce=false);
 	
 public:
     /*!
@@ -191,4 +318,11 @@ public:
      *  Must be called from a "super loop" or from corresponding thread
      */
     bool Update();
+
+    /*!
+     * \brief Returns the nominal polling rate of the channels
+     * \return The number of conversions per second made for each channel
+     * \details The channels are polled each millisecond unless the conversions of all channels take longer
+     */
+    float GetPollingRate();
 };
@@ -114,7 +114,7 @@ bool CSamI2CeepromMaster::receive(CFIFO &msg) //blocking call
     {
         if( (os::get_tick_mS()-StartWaitTime)>m_OpTmt_mS )
             break;
-        os::wait(50);
+        os::wait(1);
     }
     m_pBuf=nullptr;
     return (FSM::halted==m_MState);
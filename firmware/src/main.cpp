@@ -22,6 +22,10 @@ Copyright (c) 2019 Panda Team
 #include "DACPWMht.h"
 #include "ShiftReg.h"
 #include "PGA280.h"
+#include "SetpointSeq.h"
+#include "SigCond.h"
+#include "BoardSnapshot.h"
+#include "BootTiming.h"
 
 #include "NewMenu.h"
 #include "SAMbutton.h"
@@ -70,6 +74,7 @@ int main(void)
 
         //step 0: clock init:
         sys_clock_init(); //->120MHz
+        CBootTiming::Start();
 
         //----------------creating I2C EEPROM-----------------------
         //creating shared mem buf:
@@ -80,13 +85,21 @@ int main(void)
         auto pEEPROM_MasterBus= std::make_shared<CSamI2CeepromMaster>();
         pEEPROM_MasterBus->EnableIRQs(true);
 
-        //request data from an external chip:
-        pEEPROM_MasterBus->SetDataAddrAndCountLim(0, 1024);
+        //request the image header from an external chip first:
+        pEEPROM_MasterBus->SetDataAddrAndCountLim(0, CHatsMemMan::GetHeaderSize());
         pEEPROM_MasterBus->SetDeviceAddr(0xA0);
         pEEPROM_MasterBus->receive(*pEEPROM_MemBuf);
 
-        //verifing the image:
+        //then read out only the used part of the image instead of the whole 1kb:
         CHatsMemMan HatMan(pEEPROM_MemBuf);
+        int nImageSize=HatMan.GetImageSize();
+        if(nImageSize>CHatsMemMan::GetHeaderSize() && nImageSize<=1024)
+        {
+            pEEPROM_MasterBus->SetDataAddrAndCountLim(CHatsMemMan::GetHeaderSize(), nImageSize);
+            pEEPROM_MasterBus->receive(*pEEPROM_MemBuf);
+        }
+
+        //verifing the image:
         if(CHatsMemMan::op_result::OK!=HatMan.Verify()) //image is corrupted
         {
             //make default image:
@@ -107,6 +120,7 @@ int main(void)
         auto pEEPROM_HAT=std::make_shared<CSamI2CmemHAT>();
         pEEPROM_HAT->SetMemBuf(pEEPROM_MemBuf);
         pEEPROM_HAT->EnableIRQs(true);
+        CBootTiming::Mark(CBootTiming::eeprom);
         //----------------------------------------------------------
 
 
@@ -116,6 +130,7 @@ int main(void)
         auto pDisp=         std::make_shared<CCmdDispatcher>();
         auto pStdPort=      std::make_shared<CStdPort>(pDisp, pSPIsc2);
         pSPIsc2->AdviseSink(pStdPort);
+        CBootTiming::Mark(CBootTiming::comm);
 
 
         //setup pins:
@@ -145,10 +160,11 @@ int main(void)
             pDAConPin=pDMSsr->FactoryPin(CDMSsr::pins::DAC_On);
             pUB1onPin=pDMSsr->FactoryPin(CDMSsr::pins::UB1_On);
 
-            auto pCS0=pDMSsr->FactoryPin(CDMSsr::pins::QSPI_CS0); pCS0->SetInvertedBehaviour(true);  pQSPICS0Pin=pCS0; pCS0->Set(false);
+            auto pCS0=pDMSsr->FactoryPin(CDMSsr::pins::QSPI_CS0, true); pCS0->SetInvertedBehaviour(true);  pQSPICS0Pin=pCS0; pCS0->Set(false);
 
 #ifdef DMS_TEST_MODE
            pDisp->Add("SR", std::make_shared< CCmdSGHandler<CDMSsr, unsigned int> >(pDMSsr, &CDMSsr::GetShiftReg, &CDMSsr::SetShiftReg) );
+           pDisp->Add("SR.shifts", std::make_shared< CCmdSGHandler<CDMSsr, unsigned int> >(pDMSsr, &CDMSsr::GetShiftCount) );
 #endif
 
         }
@@ -192,25 +208,48 @@ int main(void)
         pSamDAC1->SetRawBinVal(2048);
 
         //add ADC/DAC commands:
+        std::shared_ptr<CSigCondChan> pSigCond[nChannels];
         for(int i=0; i<nChannels; i++)
         {
             char cmd[64];
             int nInd=i+1;
             std::sprintf(cmd, "ADC%d.raw", nInd);
             pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CAdc, int> >(pADC[i], &CAdc::DirectMeasure) );
+
+            //conversion profile:
+            std::sprintf(cmd, "ADC%d.avg", nInd);
+            pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CSamADCchan, unsigned int> >(pADC[i], &CSamADCchan::GetAvgSamples, &CSamADCchan::SetAvgSamples) );
+            std::sprintf(cmd, "ADC%d.presc", nInd);
+            pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CSamADCchan, unsigned int> >(pADC[i], &CSamADCchan::GetPrescaler, &CSamADCchan::SetPrescaler) );
+            std::sprintf(cmd, "ADC%d.samplen", nInd);
+            pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CSamADCchan, unsigned int> >(pADC[i], &CSamADCchan::GetSampleLen, &CSamADCchan::SetSampleLen) );
+
+            //onboard signal conditioning:
+            pSigCond[i]=std::make_shared<CSigCondChan>(pADC[i]);
+            std::sprintf(cmd, "ADC%d.fc", nInd);
+            pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CSigCondChan, float> >(pSigCond[i], &CSigCondChan::GetCutoff, &CSigCondChan::SetCutoff) );
+            std::sprintf(cmd, "ADC%d.flt", nInd);
+            pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CSigCondChan, float> >(pSigCond[i], &CSigCondChan::GetVal) );
+            std::sprintf(cmd, "ADC%d.rms", nInd);
+            pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CSigCondChan, float> >(pSigCond[i], &CSigCondChan::GetRMS) );
+            std::sprintf(cmd, "ADC%d.peak", nInd);
+            pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CSigCondChan, float> >(pSigCond[i], &CSigCondChan::GetPeak) );
+
             std::sprintf(cmd, "DAC%d.raw", nInd);
             pDisp->Add(cmd, std::make_shared< CCmdSGHandler<CDac, int> >(pDAC[i], &CDac::GetRawBinVal, &CDac::SetRawOutput ) );
         }
+        pDisp->Add("ADC.win", std::make_shared< CCmdSGHandlerF<unsigned int> >(&CSigCondChan::GetWindow, &CSigCondChan::SetWindow) );
         pDisp->Add("AOUT3.raw", std::make_shared< CCmdSGHandler<CDac, int> >(pSamDAC0, &CDac::GetRawBinVal, &CDac::SetRawOutput ) );
         pDisp->Add("AOUT4.raw", std::make_shared< CCmdSGHandler<CDac, int> >(pSamDAC1, &CDac::GetRawBinVal, &CDac::SetRawOutput ) );
         pDisp->Add("DACsw", std::make_shared< CCmdSGHandler<CPin, bool> >(pDAConPin, &CPin::RbSet,  &CPin::Set) );
+        CBootTiming::Mark(CBootTiming::board);
 
 
 
         //2nd step:
         if(typeBoard::DMSBoard==ThisBoard)
         {
-            auto pCS1=pDMSsr->FactoryPin(CDMSsr::pins::QSPI_CS1); pCS1->SetInvertedBehaviour(true);  pCS1->Set(false);
+            auto pCS1=pDMSsr->FactoryPin(CDMSsr::pins::QSPI_CS1, true); pCS1->SetInvertedBehaviour(true);  pCS1->Set(false);
 
             //create PGA280 extension bus:
             auto pInaSpi=std::make_shared<CSamSPIbase>(true, typeSamSercoms::Sercom5,
@@ -227,8 +266,10 @@ int main(void)
             nc.SetVoltageDAC(pDAC2A);
 
 
-            //create 4 PGAs:
+            //create 4 PGAs (their initial setup is sent in one batch):
             CDMSsr::pins IEPEpins[]={CDMSsr::pins::IEPE1_On, CDMSsr::pins::IEPE2_On, CDMSsr::pins::IEPE3_On, CDMSsr::pins::IEPE4_On};
+            {
+            CPGA280batchLock PGAbatch;
             for(int i=0; i<nChannels; i++)
             {
                 auto pPGA_CS=std::make_shared<CPGA_CS>(static_cast<CDMSsr::pga_sel>(i), pDMSsr, pInaSpiCSpin);
@@ -249,6 +290,12 @@ int main(void)
 #endif
 
             }
+            }   //the batch is committed here
+
+            //PGA profiling:
+            pDisp->Add("PGA.prof.uS", std::make_shared< CCmdSGHandlerF<unsigned int> >(&CPGA280batch::GetLastCommitTime) );
+            pDisp->Add("PGA.prof.xfers", std::make_shared< CCmdSGHandlerF<unsigned int> >(&CPGA280batch::GetLastXfers) );
+            pDisp->Add("PGA.prof.errors", std::make_shared< CCmdSGHandlerF<unsigned int> >(&CPGA280batch::GetErrors) );
         }
         else
         {
@@ -257,6 +304,7 @@ int main(void)
                 nc.AddMesChannel( std::make_shared<CIEPEchannel>(pADC[i], pDAC[i], static_cast<CView::vischan>(i)) );
             }
         }
+        CBootTiming::Mark(CBootTiming::periph);
 
 
         //2 DAC PWMs:
@@ -280,11 +328,35 @@ int main(void)
         pDisp->Add("PWM2.low", std::make_shared< CCmdSGHandler<CDacPWMht, int> >(pPWM2, &CDacPWMht::GetLowLevel,  &CDacPWMht::SetLowLevel) );
 
 
+        //timed setpoint sequencer:
+        auto pSeq=std::make_shared<CSetpointSeq>(pDisp);
+        pDisp->Add("Seq", std::make_shared< CCmdSGHandler<CSetpointSeq, std::string> >(pSeq, &CSetpointSeq::GetSequence,  &CSetpointSeq::SetSequence) );
+        pDisp->Add("Seq.arm", std::make_shared< CCmdSGHandler<CSetpointSeq, bool> >(pSeq, &CSetpointSeq::IsArmed,  &CSetpointSeq::Arm) );
+        pDisp->Add("Seq.status", std::make_shared< CCmdSGHandler<CSetpointSeq, int> >(pSeq, &CSetpointSeq::GetStatus) );
+        pDisp->Add("Seq.step", std::make_shared< CCmdSGHandler<CSetpointSeq, int> >(pSeq, &CSetpointSeq::GetStep) );
+        pDisp->Add("Seq.lateness", std::make_shared< CCmdSGHandler<CSetpointSeq, unsigned int> >(pSeq, &CSetpointSeq::GetMaxLateness) );
+
+
         //temp sens+fan control:
         auto pTempSens=std::make_shared<CSamTempSensor>(pSamADC0);
         pDisp->Add("Temp", std::make_shared< CCmdSGHandler<CSamTempSensor, float> >(pTempSens,  &CSamTempSensor::GetTempCD) );
         auto pFanControl=std::make_shared<CFanControlSimple>(pTempSens, CSamPORT::group::A, CSamPORT::pin::P09);
 
+        //board health snapshot:
+        auto pSnap=std::make_shared<CBoardSnapshot>();
+        pSnap->SetMonitor(pTempSens, pFanControl);
+        for(int i=0; i<nChannels; i++)
+        {
+            pSnap->SetADC(i, pADC[i], pSigCond[i]);
+            pSnap->SetDAC(i, pDAC[i]);
+        }
+        pSnap->SetAOUT(0, pSamDAC0);
+        pSnap->SetAOUT(1, pSamDAC1);
+        pSnap->SetPWM(0, pPWM1);
+        pSnap->SetPWM(1, pPWM2);
+        pDisp->Add("Snap", std::make_shared< CCmdSGHandler<CBoardSnapshot, std::string> >(pSnap, &CBoardSnapshot::GetSnapshot) );
+        pDisp->Add("Snap.period", std::make_shared< CCmdSGHandler<CBoardSnapshot, unsigned int> >(pSnap, &CBoardSnapshot::GetPeriod, &CBoardSnapshot::SetPeriod) );
+
 
         //---------------------------------------------------command system------------------------------------------------------
         //channel commands:
@@ -308,6 +380,16 @@ int main(void)
         pDisp->Add("ARMID", std::make_shared< CCmdSGHandlerF<std::string> >(&CSamService::GetSerialString) );
         pDisp->Add("fwVersion", std::make_shared< CCmdSGHandler<CSemVer, std::string> >(pVersion, &CSemVer::GetVersionString) );
 
+        //boot phases timing:
+        pDisp->Add("Boot.eeprom", std::make_shared< CCmdSGHandlerF<unsigned int> >(&CBootTiming::Get<CBootTiming::eeprom>) );
+        pDisp->Add("Boot.comm", std::make_shared< CCmdSGHandlerF<unsigned int> >(&CBootTiming::Get<CBootTiming::comm>) );
+        pDisp->Add("Boot.board", std::make_shared< CCmdSGHandlerF<unsigned int> >(&CBootTiming::Get<CBootTiming::board>) );
+        pDisp->Add("Boot.periph", std::make_shared< CCmdSGHandlerF<unsigned int> >(&CBootTiming::Get<CBootTiming::periph>) );
+        pDisp->Add("Boot.cmd", std::make_shared< CCmdSGHandlerF<unsigned int> >(&CBootTiming::Get<CBootTiming::commands>) );
+        pDisp->Add("Boot.settings", std::make_shared< CCmdSGHandlerF<unsigned int> >(&CBootTiming::Get<CBootTiming::settings>) );
+        pDisp->Add("Boot.total", std::make_shared< CCmdSGHandlerF<unsigned int> >(&CBootTiming::Get<CBootTiming::total>) );
+        pDisp->Add("Boot.ordered", std::make_shared< CCmdSGHandlerF<bool> >(&CBootTiming::IsOrdered) );
+
         //control commands:
         const std::shared_ptr<nodeControl> &pNC=nc.shared_from_this();
         pDisp->Add("Gain", std::make_shared< CCmdSGHandler<nodeControl, int> >(pNC, &nodeControl::GetGain, &nodeControl::SetGain) );
@@ -335,14 +417,19 @@ int main(void)
         pDisp->Add("je", pJE);
         button.CJSONEvCP::AdviseSink(pJE);
         nodeControl::Instance().AdviseSink(pJE);
+        pSeq->AdviseSink(pJE);
         //--------------------------------------------------------------------------------------------------------------
 
 
 
+        CBootTiming::Mark(CBootTiming::commands);
+
         CView &view=CView::Instance();
         nc.LoadSettings();
         nc.SetMode(0); //set default mode
+        CBootTiming::Mark(CBootTiming::settings);
         view.BlinkAtStart();
+        CBootTiming::Mark(CBootTiming::total);
 
         while(1) //endless loop ("super loop")
         {
@@ -352,6 +439,9 @@ int main(void)
 
              pSPIsc2->Update();
              pSamADC0->Update();
+             for(auto &el : pSigCond) el->Update();
              pFanControl->Update();
+             pSnap->Update();
+             pSeq->Update();
         }
 }